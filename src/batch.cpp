@@ -0,0 +1,111 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include "eval_env.h"
+#include "runner.h"
+
+namespace {
+
+struct FileResult {
+    RunResult run;
+    double millis = 0;
+};
+
+RunResult runBatchFile(const std::string& path, const std::string& prelude_source) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return RunResult{false, "", "Could not open file '" + path + "'", 1};
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    auto env = std::make_shared<EvalEnv>();
+    if (!prelude_source.empty()) {
+        RunResult prelude = runCaptured(*env, prelude_source);
+        if (!prelude.ok) {
+            prelude.value = "prelude: " + prelude.value;
+            env->clearBindings();
+            return prelude;
+        }
+    }
+    RunResult result = runCaptured(*env, buffer.str());
+    // 文件中定义的闭包引用着 env，清空绑定以打破引用环
+    env->clearBindings();
+    return result;
+}
+
+}  // namespace
+
+int runBatch(const std::vector<std::string>& files, const std::string& prelude_source) {
+    std::vector<std::optional<FileResult>> results(files.size());
+    std::mutex mutex;
+    std::condition_variable done;
+    std::atomic<size_t> next_file{0};
+
+    auto worker = [&] {
+        size_t index;
+        while ((index = next_file++) < files.size()) {
+            auto start = std::chrono::steady_clock::now();
+            RunResult run = runBatchFile(files[index], prelude_source);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[index] = FileResult{std::move(run), elapsed.count()};
+            }
+            done.notify_one();
+        }
+    };
+
+    auto batch_start = std::chrono::steady_clock::now();
+    size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), files.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    // 按文件顺序输出已完成文件的捕获输出
+    std::vector<FileResult> summary;
+    for (size_t i = 0; i < files.size(); ++i) {
+        FileResult result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return results[i].has_value(); });
+            result = std::move(*results[i]);
+            results[i].reset();
+        }
+        std::cout << result.run.output << std::flush;
+        result.run.output.clear();
+        summary.push_back(std::move(result));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - batch_start;
+
+    int failed = 0;
+    std::cerr << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < files.size(); ++i) {
+        const RunResult& run = summary[i].run;
+        std::cerr << (run.ok ? "ok  " : "FAIL") << "  " << std::setw(9) << summary[i].millis << " ms  " << files[i];
+        if (!run.ok) {
+            std::cerr << ": " << run.value;
+            ++failed;
+        }
+        std::cerr << '\n';
+    }
+    std::cerr << files.size() << " files, " << failed << " failed, " << total.count() << " ms on " << thread_count
+              << " threads" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+
+// 批处理模式：在线程池中并行执行 files 中的脚本。每个文件拥有独立的根环境
+// （先执行 prelude_source），输出按文件顺序打印，最后在标准错误输出中
+// 汇总每个文件的状态与耗时。任一文件失败时返回非零状态码。
+int runBatch(const std::vector<std::string>& files, const std::string& prelude_source);
+
+#endif
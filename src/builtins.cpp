@@ -4,18 +4,55 @@
 #include <cstdlib>
 #include <sstream>
 #include <algorithm>
+#include <array>
+#include <new>
+#include <utility>
 #include "builtins.h"
+#include "native.h"
 #include "value.h"   
 #include "eval_env.h"
 #include "error.h" 
 #include "token.h"
 #include "tokenizer.h"
 #include "parser.h"
+#include "port.h"
+#include "scheduler.h"
+#include "handler_stack.h"
+#include "iterator.h"
 
-static ValuePtr builtin_apply(const std::vector<ValuePtr>& evaluated_args_for_apply_func, EvalEnv& env) {
-    if(evaluated_args_for_apply_func.size() != 2){
-        throw LispError("apply: Exactly 2 values required.");
+static thread_local std::ostream* current_output = &std::cout;
+
+std::ostream& lisp_output() {
+    return *current_output;
+}
+
+OutputRedirect::OutputRedirect(std::ostream& stream) : previous(current_output) {
+    current_output = &stream;
+}
+
+OutputRedirect::~OutputRedirect() {
+    current_output = previous;
+}
+
+static thread_local bool exit_trapped = false;
+
+ExitTrap::ExitTrap() : previous(exit_trapped) {
+    exit_trapped = true;
+}
+
+ExitTrap::~ExitTrap() {
+    exit_trapped = previous;
+}
+
+void requestExit(int code) {
+    // 线程局部的调度器在进程结束时释放任务栈，不能在这段栈上调用 std::exit
+    if (exit_trapped || Scheduler::current().inTask()) {
+        throw ExitRequest(code);
     }
+    std::exit(code);
+}
+
+static ValuePtr builtin_apply(const std::vector<ValuePtr>& evaluated_args_for_apply_func, EvalEnv& env) {
     ValuePtr proc_object_to_call = evaluated_args_for_apply_func[0]; 
     ValuePtr list_of_actual_args = evaluated_args_for_apply_func[1]; 
     if(!proc_object_to_call->isProcedure()){ 
@@ -29,152 +66,139 @@ static ValuePtr builtin_apply(const std::vector<ValuePtr>& evaluated_args_for_ap
         args_vector_for_proc = list_of_actual_args->toVector();
     }
 
-    return env.apply(proc_object_to_call, args_vector_for_proc);
+    // 结果直接返回，过程中的续延逃逸原样传回
+    return env.applyOrEscape(proc_object_to_call, args_vector_for_proc);
 }
 
 static ValuePtr builtin_display(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(params.size() != 1){
-        throw LispError("display: Exactly 1 value required.");
-    }
     auto it = params[0];
     if(auto str_val = std::dynamic_pointer_cast<StringValue>(it)){ 
-        std::cout << str_val->asString(); 
+        lisp_output() << str_val->asString(); 
     }
     else{
-        std::cout << it->toString();
+        lisp_output() << it->toString();
     }
     return LISP_NIL;
 }
 
 static ValuePtr builtin_displayln(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(params.size() != 1){
-        throw LispError("displayln: Exactly 1 value required.");
-    }
     auto it = params[0];
     if(auto str_val = std::dynamic_pointer_cast<StringValue>(it)){ 
-        std::cout << str_val->asString(); 
+        lisp_output() << str_val->asString(); 
     }
     else{
-        std::cout << it->toString();
+        lisp_output() << it->toString();
     }
-    std::cout << std::endl;
+    lisp_output() << std::endl;
     return LISP_NIL;
 }
 
-static ValuePtr builtin_error(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(params.empty()){
-        throw std::runtime_error(0);
-    }
-    if(params.size() != 1){
-        throw LispError("error: At most 1 argument (error code) allowed.");
-    }
-    auto it = params[0];
-    if(!it->isNumber()){ 
-        throw LispError("error: Error code must be a number. Got: " + it->toString());
+static ValuePtr builtin_error(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params.empty() && params[0]->isString()) {
+        // (error message irritant ...)：附带的值原样保存在条件对象中，需要报告时才格式化
+        ValuePtr irritants = LISP_NIL;
+        for (size_t i = params.size(); i-- > 1;) {
+            irritants = std::make_shared<PairValue>(params[i], std::move(irritants));
+        }
+        return raise_condition(env, std::make_shared<ErrorObjectValue>(params[0]->asString(), std::move(irritants)),
+                               false);
+    }
+    if (params.size() > 1) {
+        throw LispError("error: expects (error code) or (error message irritant ...)");
+    }
+    // (error)：没有错误码与说明时使用默认的信息
+    std::string error_string = "error";
+    if (!params.empty()) {
+        auto it = params[0];
+        if(!it->isNumber()){ 
+            throw LispError("error: Error code must be a number. Got: " + brief_repr(*it));
+        }
+        double val = it->asNumber();
+        int error_code = static_cast<int>(val);
+        if (std::abs(val - static_cast<double>(error_code)) > 1e-9) {
+            throw LispError("error: Error code must be an integer. Got: " + brief_repr(*it));
+        }
+        error_string = std::to_string(error_code);
     }
-    double val = it->asNumber();
-    int error_code = static_cast<int>(val);
-    if (std::abs(val - static_cast<double>(error_code)) > 1e-9) {
-        throw LispError("error: Error code must be an integer. Got: " + it->toString());
+    if (current_handlers) {
+        return raise_condition(env, std::make_shared<ErrorObjectValue>(error_string, LISP_NIL), false);
     }
-    std::string error_string = std::to_string(error_code); 
     throw std::runtime_error(error_string);
     return LISP_NIL;
 }
 
 static ValuePtr builtin_eval(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if(params.size() != 1){
-        throw LispError("eval: Exactly 1 value required.");
-    }
     return env.eval(params[0]);
 }
 
 static ValuePtr builtin_exit(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
     if(params.empty()){
-        std::exit(0);
-    }
-    if(params.size() != 1){
-        throw LispError("exit: At most 1 argument (exit code) allowed.");
+        requestExit(0);
     }
     auto it = params[0];
     if(!it->isNumber()){ // 确保是数字
-        throw LispError("exit: Exit code must be a number. Got: " + it->toString());
+        throw LispError("exit: Exit code must be a number. Got: " + brief_repr(*it));
     }
     double val = it->asNumber(); // 获取 double
     int exit_code = static_cast<int>(val);
     if (std::abs(val - static_cast<double>(exit_code)) > 1e-9) { // 检查是否为整数
-        throw LispError("exit: Exit code must be an integer. Got: " + it->toString());
+        throw LispError("exit: Exit code must be an integer. Got: " + brief_repr(*it));
     }
-    std::exit(exit_code);
-    return LISP_NIL; // Unreachable
+    requestExit(exit_code);
 }
 
 static ValuePtr builtin_newline(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(!params.empty()){
-        throw LispError("newline: No arguments expected.");
-    }
-    std::cout << std::endl;
+    lisp_output() << std::endl;
     return LISP_NIL;
 }
 
 static ValuePtr builtin_print(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
     for (size_t i = 0; i < params.size(); ++i) {
         if (params[i]) {
-            std::cout << params[i]->toString();
+            lisp_output() << params[i]->toString();
         }
         else {
-            std::cout << "#<nullptr-in-print>";
+            lisp_output() << "#<nullptr-in-print>";
         }
         if (i < params.size() - 1) {
-            std::cout << " ";
+            lisp_output() << " ";
         }
     }
-    std::cout << std::endl;
+    lisp_output() << std::endl;
     return LISP_NIL;
 }
 
-static ValuePtr builtin_atom(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("atom?: expects 1 argument");
-    ValuePtr p = params[0];
-    return (p->isNil() || p->isBoolean() || p->isNumber() || p->isString() || p->isSymbol())?LISP_TRUE:LISP_FALSE;
+static bool builtin_atom(const ValuePtr& p) {
+    return p->isNil() || p->isBoolean() || p->isNumber() || p->isString() || p->isSymbol();
 }
-static ValuePtr builtin_boolean(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("boolean?: expects 1 argument");
-    return (params[0]->isBoolean())?LISP_TRUE:LISP_FALSE;
+static bool builtin_boolean(const ValuePtr& value) {
+    return value->isBoolean();
 }
-static ValuePtr builtin_integer(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("integer?: expects 1 argument");
-    if (!params[0]->isNumber()) return LISP_FALSE;
-    double val = params[0]->asNumber();
-    return (std::trunc(val) == val)?LISP_TRUE:LISP_FALSE;
+static bool builtin_integer(const ValuePtr& value) {
+    if (!value->isNumber()) return false;
+    double val = value->asNumber();
+    return std::trunc(val) == val;
 }
-static ValuePtr builtin_list_(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("list?: expects 1 argument");
-    return (params[0]->isList() || params[0]->isNil())?LISP_TRUE:LISP_FALSE; // 使用 Value::isList()
+static bool builtin_list_(const ValuePtr& value) {
+    return value->isList() || value->isNil(); // 使用 Value::isList()
 }
-static ValuePtr builtin_number(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("number?: expects 1 argument");
-    return (params[0]->isNumber())?LISP_TRUE:LISP_FALSE;
+static bool builtin_number(const ValuePtr& value) {
+    return value->isNumber();
 }
-static ValuePtr builtin_null(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("null?: expects 1 argument");
-    return (params[0]->isNil())?LISP_TRUE:LISP_FALSE;
+static bool builtin_null(const ValuePtr& value) {
+    return value->isNil();
 }
-static ValuePtr builtin_pair(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("pair?: expects 1 argument");
-    return (params[0]->isPair())?LISP_TRUE:LISP_FALSE;
+static bool builtin_pair(const ValuePtr& value) {
+    return value->isPair();
 }
-static ValuePtr builtin_procedure(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("procedure?: expects 1 argument");
-    return (std::dynamic_pointer_cast<BuiltinProcValue>(params[0]) || std::dynamic_pointer_cast<LambdaValue>(params[0]))?LISP_TRUE:LISP_FALSE;
+static bool builtin_procedure(const ValuePtr& value) {
+    return value->isProcedure();
 }
-static ValuePtr builtin_string(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("string?: expects 1 argument");
-    return (params[0]->isString())?LISP_TRUE:LISP_FALSE;
+static bool builtin_string(const ValuePtr& value) {
+    return value->isString();
 }
-static ValuePtr builtin_symbol(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 1) throw LispError("symbol?: expects 1 argument");
-    return (params[0]->isSymbol())?LISP_TRUE:LISP_FALSE;
+static bool builtin_symbol(const ValuePtr& value) {
+    return value->isSymbol();
 }
 
 static ValuePtr builtin_append(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
@@ -188,7 +212,7 @@ static ValuePtr builtin_append(const std::vector<ValuePtr>& params, EvalEnv& env
         ValuePtr current_list_part = params[i];
         if (i < params.size() - 1) {
             if (!current_list_part->isList() && !current_list_part->isNil()) {
-                throw LispError("append: arguments before the last must be proper lists. Got: " + current_list_part->toString());
+                throw LispError("append: arguments before the last must be proper lists. Got: " + brief_repr(*current_list_part));
             }
             ValuePtr temp_iter = current_list_part;
             while (temp_iter->isPair()) {
@@ -214,44 +238,50 @@ static ValuePtr builtin_append(const std::vector<ValuePtr>& params, EvalEnv& env
     }
     return result_head;
 }
-static ValuePtr builtin_car(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if(params.size() != 1) throw LispError("car: expects 1 argument");
-    if(!params[0]->isPair()) throw LispError("car: argument must be a pair. Got: " + params[0]->toString());
-    return std::static_pointer_cast<PairValue>(params[0])->l;
+static ValuePtr builtin_car(const ValuePtr& pair) {
+    if (!pair->isPair()) throw LispError("car: argument must be a pair. Got: " + brief_repr(*pair));
+    return static_cast<PairValue&>(*pair).l;
 }
-static ValuePtr builtin_cdr(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(params.size() != 1) throw LispError("cdr: expects 1 argument");
-    if(!params[0]->isPair()) throw LispError("cdr: argument must be a pair. Got: " + params[0]->toString());
-    return std::static_pointer_cast<PairValue>(params[0])->r;
+static ValuePtr builtin_cdr(const ValuePtr& pair) {
+    if (!pair->isPair()) throw LispError("cdr: argument must be a pair. Got: " + brief_repr(*pair));
+    return static_cast<PairValue&>(*pair).r;
 }
-static ValuePtr builtin_cons(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(params.size() != 2) throw LispError("cons: expects 2 arguments");
-    return std::make_shared<PairValue>(params[0], params[1]);
+static ValuePtr builtin_cons(const ValuePtr& car, const ValuePtr& cdr) {
+    return std::make_shared<PairValue>(car, cdr);
 }
 static ValuePtr builtin_length(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if(params.size() != 1) throw LispError("length: expects 1 argument");
     if(!params[0]->isList() && !params[0]->isNil()){ // 确保是 proper list 或 nil
-        throw LispError("length: argument must be a proper list or nil. Got: " + params[0]->toString());
+        throw LispError("length: argument must be a proper list or nil. Got: " + brief_repr(*params[0]));
     }
-    if (params[0]->isNil()) return std::make_shared<NumericValue>(0.0);
-    return std::make_shared<NumericValue>(static_cast<double>(params[0]->toVector().size()));
+    size_t length = 0;
+    for (const Value* node = params[0].get(); typeid(*node) == typeid(PairValue);
+         node = static_cast<const PairValue&>(*node).r.get()) {
+        ++length;
+    }
+    return std::make_shared<NumericValue>(static_cast<double>(length));
 }
 static ValuePtr builtin_list(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
     std::vector<ValuePtr> elements = params; 
     return toList(elements);
 }
 
+// 迭代器（见 iterator.h）；不是迭代器时返回 nullptr
+static std::shared_ptr<IteratorValue> as_iterator(const ValuePtr& value) {
+    return std::dynamic_pointer_cast<IteratorValue>(value);
+}
+
 static ValuePtr builtin_map(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if(params.size() != 2){
-        throw LispError("map: Exactly 2 arguments required.");
-    }
     ValuePtr proc_object = params[0];
     ValuePtr list_object = params[1];
     if (!proc_object->isProcedure()) {
-        throw LispError("map: first argument must be a procedure. Got: " + proc_object->toString());
+        throw LispError("map: first argument must be a procedure. Got: " + brief_repr(*proc_object));
+    }
+    if (auto source = as_iterator(list_object)) {
+        // 对迭代器惰性地映射，取出元素时才调用过程
+        return std::make_shared<MapIterator>(proc_object, std::move(source));
     }
     if (!list_object->isList()) { 
-        throw LispError("map: second argument must be a list. Got: " + list_object->toString());
+        throw LispError("map: second argument must be a list. Got: " + brief_repr(*list_object));
     }
     if (list_object->isNil()) { 
         return LISP_NIL;
@@ -267,16 +297,16 @@ static ValuePtr builtin_map(const std::vector<ValuePtr>& params, EvalEnv& env) {
 }
 
 static ValuePtr builtin_filter(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if(params.size() != 2){
-        throw LispError("filter: Exactly 2 arguments required.");
-    }
     ValuePtr pred_object = params[0];
     ValuePtr list_object = params[1];
     if (!pred_object->isProcedure()) {
-        throw LispError("filter: first argument must be a procedure. Got: " + pred_object->toString());
+        throw LispError("filter: first argument must be a procedure. Got: " + brief_repr(*pred_object));
+    }
+    if (auto source = as_iterator(list_object)) {
+        return std::make_shared<FilterIterator>(pred_object, std::move(source));
     }
     if (!list_object->isList()) {
-        throw LispError("filter: second argument must be a list. Got: " + list_object->toString());
+        throw LispError("filter: second argument must be a list. Got: " + brief_repr(*list_object));
     }
     if (list_object->isNil()) {
         return LISP_NIL;
@@ -293,11 +323,26 @@ static ValuePtr builtin_filter(const std::vector<ValuePtr>& params, EvalEnv& env
 }
 
 static ValuePtr builtin_reduce(const std::vector<ValuePtr>& evaluated_args, EvalEnv& env) {
-    if(evaluated_args.size() != 2){
-        throw LispError("reduce: Exactly 2 values required.");
-    }
     ValuePtr proc_object = evaluated_args[0];
     ValuePtr list_object = evaluated_args[1];
+    if (auto source = as_iterator(list_object); source && proc_object->isProcedure()) {
+        // 逐个取出元素累积，不构造表
+        ValuePtr accumulator = source->next(env);
+        if (!accumulator) {
+            throw LispError("reduce: Invalid variables.");
+        }
+        // 二元的内建过程（如 +）走专用入口，不为每个元素构造实参 vector
+        auto builtin = std::dynamic_pointer_cast<BuiltinProcValue>(proc_object);
+        BuiltinFunc2Type fn2 = builtin ? builtin->get_descriptor().fn2 : nullptr;
+        for (ValuePtr item; accumulator != LISP_ESCAPE && (item = source->next(env));) {
+            if (item == LISP_ESCAPE) {
+                return item;
+            }
+            accumulator = fn2 ? fn2(accumulator, item, env)
+                              : env.applyOrEscape(proc_object, {std::move(accumulator), std::move(item)});
+        }
+        return accumulator;
+    }
     if(!proc_object->isProcedure() || !list_object->isList() || list_object->isNil()){
         throw LispError("reduce: Invalid variables."); 
     }
@@ -315,103 +360,201 @@ static ValuePtr builtin_reduce(const std::vector<ValuePtr>& evaluated_args, Eval
     return accumulator;
 }
 
-static ValuePtr builtin_add(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    double sum_result = 0.0;
-    if (params.empty()) return std::make_shared<NumericValue>(0.0);
-    for (const auto& arg_ptr : params) {
-        if (!arg_ptr->isNumber()) throw LispError("+: expects numeric arguments. Got: " + arg_ptr->toString());
-        sum_result += arg_ptr->asNumber(); // 假设 asNumber() 返回 double
-    }
-    return std::make_shared<NumericValue>(sum_result);
-}
-static ValuePtr builtin_subtract(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.empty()) throw LispError("-: expects at least 1 argument");
-    if (!params[0]->isNumber()) throw LispError("-: expects numeric arguments. Got: " + params[0]->toString());
-    double result = params[0]->asNumber();
-    if (params.size() == 1) return std::make_shared<NumericValue>(-result);
+// 向量
+static VectorValue& expect_vector(const ValuePtr& value, const char* who) {
+    if (typeid(*value) != typeid(VectorValue)) {
+        throw LispError(std::string(who) + ": argument must be a vector. Got: " + brief_repr(*value));
+    }
+    return static_cast<VectorValue&>(*value);
+}
+
+static size_t vector_index(const VectorValue& vector, std::int64_t index, const char* who) {
+    if (index < 0 || static_cast<std::uint64_t>(index) >= vector.elements.size()) {
+        throw LispError(std::string(who) + ": index " + std::to_string(index) + " out of range for vector of length " +
+                        std::to_string(vector.elements.size()) + ".");
+    }
+    return static_cast<size_t>(index);
+}
+
+// make-vector 的长度上限（约 2.7 亿个元素，4GB）。超出时报错，而不是在分配或填充时耗尽内存
+constexpr double MAX_VECTOR_LENGTH = 1 << 28;
+
+static ValuePtr builtin_make_vector(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    double length = params[0]->isNumber() ? params[0]->asNumber() : -1;
+    if (length < 0 || std::trunc(length) != length) {
+        throw LispError("make-vector: length must be a non-negative integer. Got: " + brief_repr(*params[0]));
+    }
+    if (length > MAX_VECTOR_LENGTH) {
+        throw LispError("make-vector: length " + brief_repr(*params[0]) + " exceeds the limit of " +
+                        std::to_string(static_cast<std::int64_t>(MAX_VECTOR_LENGTH)) + " elements.");
+    }
+    ValuePtr fill = params.size() == 2 ? params[1] : std::make_shared<NumericValue>(0);
+    try {
+        return std::make_shared<VectorValue>(std::vector<ValuePtr>(static_cast<size_t>(length), fill));
+    } catch (const std::bad_alloc&) {
+        throw LispError("make-vector: out of memory for a vector of length " + brief_repr(*params[0]) + ".");
+    }
+}
+
+static ValuePtr builtin_vector(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return std::make_shared<VectorValue>(params);
+}
+
+static bool builtin_is_vector(const ValuePtr& value) {
+    return typeid(*value) == typeid(VectorValue);
+}
+
+static std::int64_t builtin_vector_length(const ValuePtr& vector) {
+    return static_cast<std::int64_t>(expect_vector(vector, "vector-length").elements.size());
+}
+
+static ValuePtr builtin_vector_ref(const ValuePtr& value, std::int64_t index) {
+    auto& vector = expect_vector(value, "vector-ref");
+    return vector.elements[vector_index(vector, index, "vector-ref")];
+}
+
+static ValuePtr builtin_vector_set(const ValuePtr& value, std::int64_t index, const ValuePtr& element) {
+    auto& vector = expect_vector(value, "vector-set!");
+    vector.elements[vector_index(vector, index, "vector-set!")] = element;
+    return LISP_NIL;
+}
+
+static ValuePtr builtin_vector_fill(const ValuePtr& value, const ValuePtr& fill) {
+    auto& vector = expect_vector(value, "vector-fill!");
+    std::fill(vector.elements.begin(), vector.elements.end(), fill);
+    return LISP_NIL;
+}
+
+// vector-map / vector-for-each：对各向量同一下标的元素调用过程，到最短的向量结束为止。
+// 过程中可能修改这些向量，每一轮按下标重新读取，不持有元素的引用；results 为空指针时丢弃结果
+static ValuePtr map_vectors(const std::vector<ValuePtr>& params, EvalEnv& env, const char* who,
+                            std::vector<ValuePtr>* results) {
+    if (!params[0]->isProcedure()) {
+        throw LispError(std::string(who) + ": first argument must be a procedure. Got: " + brief_repr(*params[0]));
+    }
+    std::vector<VectorValue*> vectors;
     for (size_t i = 1; i < params.size(); ++i) {
-        if (!params[i]->isNumber()) throw LispError("-: expects numeric arguments. Got: " + params[i]->toString());
-        result -= params[i]->asNumber();
+        vectors.push_back(&expect_vector(params[i], who));
     }
-    return std::make_shared<NumericValue>(result);
+    auto shortest = [&] {
+        size_t length = vectors[0]->elements.size();
+        for (const auto* vector : vectors) {
+            length = std::min(length, vector->elements.size());
+        }
+        return length;
+    };
+    if (results) {
+        results->reserve(shortest());
+    }
+    for (size_t i = 0; i < shortest(); ++i) {
+        std::vector<ValuePtr> args;
+        args.reserve(vectors.size());
+        for (const auto* vector : vectors) {
+            args.push_back(vector->elements[i]);
+        }
+        ValuePtr result = env.applyOrEscape(params[0], std::move(args));
+        if (result == LISP_ESCAPE) {
+            return result;
+        }
+        if (results) {
+            results->push_back(std::move(result));
+        }
+    }
+    return LISP_NIL;
 }
-static ValuePtr builtin_multiply(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+
+static ValuePtr builtin_vector_map(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    std::vector<ValuePtr> results;
+    if (map_vectors(params, env, "vector-map", &results) == LISP_ESCAPE) {
+        return LISP_ESCAPE;
+    }
+    return std::make_shared<VectorValue>(std::move(results));
+}
+
+static ValuePtr builtin_vector_for_each(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return map_vectors(params, env, "vector-for-each", nullptr);
+}
+
+static ValuePtr builtin_list_to_vector(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    if (!params[0]->isList() && !params[0]->isNil()) {
+        throw LispError("list->vector: argument must be a proper list. Got: " + brief_repr(*params[0]));
+    }
+    std::vector<ValuePtr> elements;
+    for (const Value* node = params[0].get(); typeid(*node) == typeid(PairValue);
+         node = static_cast<const PairValue&>(*node).r.get()) {
+        elements.push_back(static_cast<const PairValue&>(*node).l);
+    }
+    return std::make_shared<VectorValue>(std::move(elements));
+}
+
+static ValuePtr builtin_vector_to_list(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    const auto& elements = expect_vector(params[0], "vector->list").elements;
+    ValuePtr list = LISP_NIL;
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+        list = std::make_shared<PairValue>(*it, std::move(list));
+    }
+    return list;
+}
+
+static double builtin_add(std::span<const double> numbers) {
+    double sum_result = 0.0;
+    for (double number : numbers) {
+        sum_result += number;
+    }
+    return sum_result;
+}
+static double builtin_subtract(double first, std::span<const double> rest) {
+    if (rest.empty()) return -first;
+    for (double number : rest) {
+        first -= number;
+    }
+    return first;
+}
+static double builtin_multiply(std::span<const double> numbers) {
     double product_result = 1.0;
-    if (params.empty()) return std::make_shared<NumericValue>(1.0);
-    for (const auto& arg_ptr : params) {
-        if (!arg_ptr->isNumber()) throw LispError("*: expects numeric arguments. Got: " + arg_ptr->toString());
-        product_result *= arg_ptr->asNumber();
+    for (double number : numbers) {
+        product_result *= number;
     }
-    return std::make_shared<NumericValue>(product_result);
+    return product_result;
 }
-static ValuePtr builtin_divide(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.empty()) throw LispError("/: expects at least 1 argument");
-    if (!params[0]->isNumber()) throw LispError("/: expects numeric arguments. Got: " + params[0]->toString());
-    double result = params[0]->asNumber();
-    if (params.size() == 1) {
-        if (result == 0.0) throw LispError("/: division by zero");
-        return std::make_shared<NumericValue>(1.0 / result);
+static double builtin_divide(double first, std::span<const double> rest) {
+    if (rest.empty()) {
+        if (first == 0.0) throw LispError("/: division by zero");
+        return 1.0 / first;
     }
-    for (size_t i = 1; i < params.size(); ++i) {
-        if (!params[i]->isNumber()) throw LispError("/: expects numeric arguments. Got: " + params[i]->toString());
-        double divisor = params[i]->asNumber();
+    for (double divisor : rest) {
         if (divisor == 0.0) throw LispError("/: division by zero");
-        result /= divisor;
+        first /= divisor;
     }
-    return std::make_shared<NumericValue>(result);
+    return first;
 }
-static ValuePtr builtin_abs(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=1) throw LispError("abs: expects 1 argument");
-    if (!params[0]->isNumber()) throw LispError("abs: expects a numeric argument. Got: " + params[0]->toString());
-    return std::make_shared<NumericValue>(std::abs(params[0]->asNumber()));
+static double builtin_abs(double x) {
+    return std::abs(x);
 }
-
-static ValuePtr builtin_expt(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=2) throw LispError("expt: expects 2 arguments (base exponent)");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("expt: expects numeric arguments.");
-    return std::make_shared<NumericValue>(std::pow(params[0]->asNumber(), params[1]->asNumber()));
+static double builtin_expt(double base, double exponent) {
+    return std::pow(base, exponent);
 }
-static ValuePtr builtin_quotient(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=2) throw LispError("quotient: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("quotient: expects numeric arguments.");
-    double n1 = params[0]->asNumber();
-    double n2 = params[1]->asNumber();
+static double builtin_quotient(double n1, double n2) {
     if (n2 == 0.0) throw LispError("quotient: division by zero");
-    return std::make_shared<NumericValue>(static_cast<double>(static_cast<long long>(n1 / n2)));
+    return static_cast<double>(static_cast<long long>(n1 / n2));
 }
-static ValuePtr builtin_modulo(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 2) throw LispError("modulo: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("modulo: expects numeric arguments.");
-    double n1 = params[0]->asNumber();
-    double n2 = params[1]->asNumber();
+static double builtin_modulo(double n1, double n2) {
     if (n2 == 0.0) throw LispError("modulo: division by zero");
     double result = std::fmod(n1, n2);
     if (result * n2 < 0) { 
         result += n2;
     }
-    return std::make_shared<NumericValue>(result);
+    return result;
 }
-static ValuePtr builtin_remainder(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 2) throw LispError("remainder: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("remainder: expects numeric arguments.");
-    double n1 = params[0]->asNumber();
-    double n2 = params[1]->asNumber();
+static double builtin_remainder(double n1, double n2) {
     if (n2 == 0.0) throw LispError("remainder: division by zero");
-    return std::make_shared<NumericValue>(std::fmod(n1, n2));
+    return std::fmod(n1, n2);
 }
-static ValuePtr builtin_eq(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 2) {
-        throw LispError("eq?: expects 2 arguments");
-    }
-    ValuePtr p1 = params[0];
-    ValuePtr p2 = params[1];
-    bool result = (p1.get() == p2.get());
-    if (!result && p1->isNumber() && p2->isNumber()) {
-        if (std::abs(p1->asNumber() - p2->asNumber()) < 1e-9) { 
-            result = true;
-        }
+static bool builtin_eq(const ValuePtr& p1, const ValuePtr& p2) {
+    if (p1.get() == p2.get()) {
+        return true;
     }
-    return result ? LISP_TRUE : LISP_FALSE;
+    return p1->isNumber() && p2->isNumber() && std::abs(p1->asNumber() - p2->asNumber()) < 1e-9;
 }
 static bool are_values_equal_recursive(ValuePtr p1, ValuePtr p2) {
     if (p1.get() == p2.get()) {
@@ -438,62 +581,43 @@ static bool are_values_equal_recursive(ValuePtr p1, ValuePtr p2) {
     if (p1->isBoolean() && p2->isBoolean()) {
         return p1.get() == p2.get();
     }
+    if (typeid(*p1) == typeid(VectorValue) && typeid(*p2) == typeid(VectorValue)) {
+        const auto& elements1 = static_cast<VectorValue&>(*p1).elements;
+        const auto& elements2 = static_cast<VectorValue&>(*p2).elements;
+        return elements1.size() == elements2.size() &&
+               std::equal(elements1.begin(), elements1.end(), elements2.begin(), are_values_equal_recursive);
+    }
     return false;
 }
-static ValuePtr builtin_equal_(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size() != 2) {
-        throw LispError("equal?: expects 2 arguments");
-    }
-    bool result = are_values_equal_recursive(params[0], params[1]);
-    return result ? LISP_TRUE : LISP_FALSE;
-}
-static ValuePtr builtin_not(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) { 
-    if (params.size()!=1) throw LispError("not: expects 1 argument");
-    return (params[0]->isLispFalse())?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_greater(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=2) throw LispError(">: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError(">: expects numeric arguments.");
-    return (params[0]->asNumber() > params[1]->asNumber())?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_lesser(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=2) throw LispError("<: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("<: expects numeric arguments.");
-    return (params[0]->asNumber() < params[1]->asNumber())?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_equal(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) { // Numeric equality
-    if (params.size()!=2) throw LispError("=: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("=: expects numeric arguments.");
-    return (params[0]->asNumber() == params[1]->asNumber())?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_greater_equal(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=2) throw LispError(">=: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError(">=: expects numeric arguments.");
-    return (params[0]->asNumber() >= params[1]->asNumber())?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_lesser_equal(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=2) throw LispError("<=: expects 2 arguments");
-    if (!params[0]->isNumber() || !params[1]->isNumber()) throw LispError("<=: expects numeric arguments.");
-    return (params[0]->asNumber() <= params[1]->asNumber())?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_is_even(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=1) throw LispError("even?: expects 1 argument");
-    if (!params[0]->isNumber()) throw LispError("even?: expects a numeric argument.");
-    double val = params[0]->asNumber();
-    if (std::trunc(val) != val) throw LispError("even?: expects an integer argument.");
-    return (static_cast<long long>(val) % 2 == 0)?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_is_odd(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=1) throw LispError("odd?: expects 1 argument");
-    if (!params[0]->isNumber()) throw LispError("odd?: expects a numeric argument.");
-    double val = params[0]->asNumber();
-    if (std::trunc(val) != val) throw LispError("odd?: expects an integer argument.");
-    return (static_cast<long long>(val) % 2 != 0)?LISP_TRUE:LISP_FALSE;
-}
-static ValuePtr builtin_is_zero(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
-    if (params.size()!=1) throw LispError("zero?: expects 1 argument");
-    if (!params[0]->isNumber()) throw LispError("zero?: expects a numeric argument.");
-    return (params[0]->asNumber() == 0.0)?LISP_TRUE:LISP_FALSE;
+static bool builtin_equal_(const ValuePtr& p1, const ValuePtr& p2) {
+    return are_values_equal_recursive(p1, p2);
+}
+static bool builtin_not(bool value) {
+    return !value;
+}
+static bool builtin_greater(double a, double b) {
+    return a > b;
+}
+static bool builtin_lesser(double a, double b) {
+    return a < b;
+}
+static bool builtin_equal(double a, double b) { // Numeric equality
+    return a == b;
+}
+static bool builtin_greater_equal(double a, double b) {
+    return a >= b;
+}
+static bool builtin_lesser_equal(double a, double b) {
+    return a <= b;
+}
+static bool builtin_is_even(std::int64_t n) {
+    return n % 2 == 0;
+}
+static bool builtin_is_odd(std::int64_t n) {
+    return n % 2 != 0;
+}
+static bool builtin_is_zero(double x) {
+    return x == 0.0;
 }
 // 字符串操作函数实现
 ValuePtr string_append(const std::vector<ValuePtr>& args, EvalEnv& env) {
@@ -513,10 +637,6 @@ ValuePtr string_append(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr string_length(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 1) {
-        throw LispError("string-length: requires exactly one argument");
-    }
-    
     if (auto str_val = std::dynamic_pointer_cast<StringValue>(args[0])) {
         return std::make_shared<NumericValue>(str_val->getValue().length());
     }
@@ -524,10 +644,6 @@ ValuePtr string_length(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr string_ref(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) {
-        throw LispError("string-ref: requires exactly two arguments");
-    }
-    
     if (auto str_val = std::dynamic_pointer_cast<StringValue>(args[0])) {
         if (auto num_val = std::dynamic_pointer_cast<NumericValue>(args[1])) {
             size_t index = static_cast<size_t>(num_val->getValue());
@@ -543,10 +659,6 @@ ValuePtr string_ref(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr number_to_string(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 1) {
-        throw LispError("number->string: requires exactly one argument");
-    }
-    
     if (auto num_val = std::dynamic_pointer_cast<NumericValue>(args[0])) {
         std::ostringstream oss;
         oss << num_val->getValue();
@@ -556,10 +668,6 @@ ValuePtr number_to_string(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr string_to_number(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 1) {
-        throw LispError("string->number: requires exactly one argument");
-    }
-    
     if (auto str_val = std::dynamic_pointer_cast<StringValue>(args[0])) {
         try {
             double value = std::stod(str_val->getValue());
@@ -573,10 +681,6 @@ ValuePtr string_to_number(const std::vector<ValuePtr>& args, EvalEnv& env) {
 
 // 字符串比较函数实现
 ValuePtr string_equal(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) {
-        throw LispError("string=?: requires exactly two arguments");
-    }
-    
     if (auto str1 = std::dynamic_pointer_cast<StringValue>(args[0])) {
         if (auto str2 = std::dynamic_pointer_cast<StringValue>(args[1])) {
             return (str1->getValue() == str2->getValue()) ? LISP_TRUE : LISP_FALSE;
@@ -587,10 +691,6 @@ ValuePtr string_equal(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr string_less(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) {
-        throw LispError("string<?: requires exactly two arguments");
-    }
-    
     if (auto str1 = std::dynamic_pointer_cast<StringValue>(args[0])) {
         if (auto str2 = std::dynamic_pointer_cast<StringValue>(args[1])) {
             return (str1->getValue() < str2->getValue()) ? LISP_TRUE : LISP_FALSE;
@@ -601,10 +701,6 @@ ValuePtr string_less(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr string_greater(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) {
-        throw LispError("string>?: requires exactly two arguments");
-    }
-    
     if (auto str1 = std::dynamic_pointer_cast<StringValue>(args[0])) {
         if (auto str2 = std::dynamic_pointer_cast<StringValue>(args[1])) {
             return (str1->getValue() > str2->getValue()) ? LISP_TRUE : LISP_FALSE;
@@ -616,10 +712,6 @@ ValuePtr string_greater(const std::vector<ValuePtr>& args, EvalEnv& env) {
 
 // 字符串转换函数实现
 ValuePtr string_upcase(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 1) {
-        throw LispError("string-upcase: requires exactly one argument");
-    }
-    
     if (auto str_val = std::dynamic_pointer_cast<StringValue>(args[0])) {
         std::string result = str_val->getValue();
         std::transform(result.begin(), result.end(), result.begin(), ::toupper);
@@ -629,10 +721,6 @@ ValuePtr string_upcase(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr string_downcase(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 1) {
-        throw LispError("string-downcase: requires exactly one argument");
-    }
-    
     if (auto str_val = std::dynamic_pointer_cast<StringValue>(args[0])) {
         std::string result = str_val->getValue();
         std::transform(result.begin(), result.end(), result.begin(), ::tolower);
@@ -643,10 +731,6 @@ ValuePtr string_downcase(const std::vector<ValuePtr>& args, EvalEnv& env) {
 
 // 字符串子串函数实现
 ValuePtr substring(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 3) {
-        throw LispError("substring: requires exactly three arguments (string start end)");
-    }
-    
     if (auto str_val = std::dynamic_pointer_cast<StringValue>(args[0])) {
         if (auto start_val = std::dynamic_pointer_cast<NumericValue>(args[1])) {
             if (auto end_val = std::dynamic_pointer_cast<NumericValue>(args[2])) {
@@ -673,10 +757,6 @@ ValuePtr substring(const std::vector<ValuePtr>& args, EvalEnv& env) {
 
 // 输入输出函数实现
 ValuePtr readline(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (!args.empty()) {
-        throw LispError("readline: expects no arguments");
-    }
-    
     std::string line;
     if (std::getline(std::cin, line)) {
         return std::make_shared<StringValue>(line);
@@ -684,11 +764,7 @@ ValuePtr readline(const std::vector<ValuePtr>& args, EvalEnv& env) {
     return LISP_NIL;  // 当遇到EOF时返回nil
 }
 
-ValuePtr read(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (!args.empty()) {
-        throw LispError("read: expects no arguments");
-    }
-    
+ValuePtr builtin_read(const std::vector<ValuePtr>& args, EvalEnv& env) {
     std::string input;
     if (std::getline(std::cin, input)) {
         try {
@@ -705,10 +781,6 @@ ValuePtr read(const std::vector<ValuePtr>& args, EvalEnv& env) {
 }
 
 ValuePtr read_multiline(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (!args.empty()) {
-        throw LispError("read-multiline: expects no arguments");
-    }
-    
     std::string input;
     std::string line;
     int paren_count = 0;
@@ -774,72 +846,608 @@ ValuePtr read_multiline(const std::vector<ValuePtr>& args, EvalEnv& env) {
         }
     }
 }
-const BuiltinProceduresMap& get_builtin_procedures() {
-    static BuiltinProceduresMap procedures_map_instance; 
-    static bool initialized = false;
-    if (!initialized) {
-        procedures_map_instance["apply"] = std::make_shared<BuiltinProcValue>(&builtin_apply);
-        procedures_map_instance["display"] = std::make_shared<BuiltinProcValue>(&builtin_display);
-        procedures_map_instance["displayln"] = std::make_shared<BuiltinProcValue>(&builtin_displayln);
-        procedures_map_instance["error"] = std::make_shared<BuiltinProcValue>(&builtin_error);
-        procedures_map_instance["eval"] = std::make_shared<BuiltinProcValue>(&builtin_eval);
-        procedures_map_instance["exit"] = std::make_shared<BuiltinProcValue>(&builtin_exit);
-        procedures_map_instance["newline"] = std::make_shared<BuiltinProcValue>(&builtin_newline);
-        procedures_map_instance["print"] = std::make_shared<BuiltinProcValue>(&builtin_print);
-        procedures_map_instance["atom?"] = std::make_shared<BuiltinProcValue>(&builtin_atom);
-        procedures_map_instance["boolean?"] = std::make_shared<BuiltinProcValue>(&builtin_boolean);
-        procedures_map_instance["integer?"] = std::make_shared<BuiltinProcValue>(&builtin_integer);
-        procedures_map_instance["list?"] = std::make_shared<BuiltinProcValue>(&builtin_list_);
-        procedures_map_instance["number?"] = std::make_shared<BuiltinProcValue>(&builtin_number);
-        procedures_map_instance["null?"] = std::make_shared<BuiltinProcValue>(&builtin_null);
-        procedures_map_instance["pair?"] = std::make_shared<BuiltinProcValue>(&builtin_pair);
-        procedures_map_instance["procedure?"] = std::make_shared<BuiltinProcValue>(&builtin_procedure);
-        procedures_map_instance["string?"] = std::make_shared<BuiltinProcValue>(&builtin_string);
-        procedures_map_instance["symbol?"] = std::make_shared<BuiltinProcValue>(&builtin_symbol);
-        procedures_map_instance["append"] = std::make_shared<BuiltinProcValue>(&builtin_append);
-        procedures_map_instance["car"] = std::make_shared<BuiltinProcValue>(&builtin_car);
-        procedures_map_instance["cdr"] = std::make_shared<BuiltinProcValue>(&builtin_cdr);
-        procedures_map_instance["cons"] = std::make_shared<BuiltinProcValue>(&builtin_cons);
-        procedures_map_instance["length"] = std::make_shared<BuiltinProcValue>(&builtin_length);
-        procedures_map_instance["list"] = std::make_shared<BuiltinProcValue>(&builtin_list);
-        procedures_map_instance["map"] = std::make_shared<BuiltinProcValue>(&builtin_map);
-        procedures_map_instance["filter"] = std::make_shared<BuiltinProcValue>(&builtin_filter);
-        procedures_map_instance["reduce"] = std::make_shared<BuiltinProcValue>(&builtin_reduce);
-        procedures_map_instance["+"] = std::make_shared<BuiltinProcValue>(&builtin_add);
-        procedures_map_instance["-"] = std::make_shared<BuiltinProcValue>(&builtin_subtract);
-        procedures_map_instance["*"] = std::make_shared<BuiltinProcValue>(&builtin_multiply);
-        procedures_map_instance["/"] = std::make_shared<BuiltinProcValue>(&builtin_divide);
-        procedures_map_instance["abs"] = std::make_shared<BuiltinProcValue>(&builtin_abs);
-        procedures_map_instance["expt"] = std::make_shared<BuiltinProcValue>(&builtin_expt);
-        procedures_map_instance["quotient"] = std::make_shared<BuiltinProcValue>(&builtin_quotient);
-        procedures_map_instance["modulo"] = std::make_shared<BuiltinProcValue>(&builtin_modulo);
-        procedures_map_instance["remainder"] = std::make_shared<BuiltinProcValue>(&builtin_remainder);
-        procedures_map_instance["eq?"] = std::make_shared<BuiltinProcValue>(&builtin_eq);
-        procedures_map_instance["equal?"] = std::make_shared<BuiltinProcValue>(&builtin_equal_);
-        procedures_map_instance["not"] = std::make_shared<BuiltinProcValue>(&builtin_not);
-        procedures_map_instance[">"] = std::make_shared<BuiltinProcValue>(&builtin_greater);
-        procedures_map_instance["<"] = std::make_shared<BuiltinProcValue>(&builtin_lesser);
-        procedures_map_instance["="] = std::make_shared<BuiltinProcValue>(&builtin_equal);
-        procedures_map_instance[">="] = std::make_shared<BuiltinProcValue>(&builtin_greater_equal);
-        procedures_map_instance["<="] = std::make_shared<BuiltinProcValue>(&builtin_lesser_equal);
-        procedures_map_instance["even?"] = std::make_shared<BuiltinProcValue>(&builtin_is_even);
-        procedures_map_instance["odd?"] = std::make_shared<BuiltinProcValue>(&builtin_is_odd);
-        procedures_map_instance["zero?"] = std::make_shared<BuiltinProcValue>(&builtin_is_zero);
-        procedures_map_instance["string-append"] = std::make_shared<BuiltinProcValue>(&string_append);
-        procedures_map_instance["string-length"] = std::make_shared<BuiltinProcValue>(&string_length);
-        procedures_map_instance["string-ref"] = std::make_shared<BuiltinProcValue>(&string_ref);
-        procedures_map_instance["number-string"] = std::make_shared<BuiltinProcValue>(&number_to_string);
-        procedures_map_instance["string-number"] = std::make_shared<BuiltinProcValue>(&string_to_number);
-        procedures_map_instance["string=?"] = std::make_shared<BuiltinProcValue>(&string_equal);
-        procedures_map_instance["string<?"] = std::make_shared<BuiltinProcValue>(&string_less);
-        procedures_map_instance["string>?"] = std::make_shared<BuiltinProcValue>(&string_greater);
-        procedures_map_instance["string-upcase"] = std::make_shared<BuiltinProcValue>(&string_upcase);
-        procedures_map_instance["string-downcase"] = std::make_shared<BuiltinProcValue>(&string_downcase);
-        procedures_map_instance["substring"] = std::make_shared<BuiltinProcValue>(&substring);
-        procedures_map_instance["readline"] = std::make_shared<BuiltinProcValue>(&readline);
-        procedures_map_instance["read"] = std::make_shared<BuiltinProcValue>(&read);
-        procedures_map_instance["read-multiline"] = std::make_shared<BuiltinProcValue>(&read_multiline);
-        initialized = true;
+// 多值
+namespace {
+constexpr size_t VALUES_POOL_SIZE = 4;
+thread_local std::array<std::shared_ptr<MultipleValuesValue>, VALUES_POOL_SIZE> values_pool;
+}  // namespace
+
+ValuePtr make_values(const ValuePtr* values, size_t count) {
+    if (count == 1) {
+        return values[0];
+    }
+    // 只被池引用的对象没有人再读取，可以直接改写；都在使用中时另外分配
+    std::shared_ptr<MultipleValuesValue> result;
+    for (auto& slot : values_pool) {
+        if (!slot) {
+            slot = std::make_shared<MultipleValuesValue>();
+        }
+        if (slot.use_count() == 1) {
+            result = slot;
+            break;
+        }
     }
+    if (!result) {
+        result = std::make_shared<MultipleValuesValue>();
+    }
+    result->assign(values, count);
+    return result;
+}
+
+void finish_values(const ValuePtr& produced) {
+    // 池与 produced 之外没有其他引用
+    if (produced.use_count() != 2 || typeid(*produced) != typeid(MultipleValuesValue)) {
+        return;
+    }
+    for (const auto& slot : values_pool) {
+        if (slot == produced) {
+            static_cast<MultipleValuesValue&>(*produced).release();
+            return;
+        }
+    }
+}
+
+static ValuePtr builtin_values(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return make_values(params.data(), params.size());
+}
+
+static ValuePtr builtin_values1(const ValuePtr& value, EvalEnv& env) {
+    return value;
+}
+
+static ValuePtr builtin_values2(const ValuePtr& first, const ValuePtr& second, EvalEnv& env) {
+    const ValuePtr values[] = {first, second};
+    return make_values(values, 2);
+}
+
+static ValuePtr builtin_call_with_values(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isProcedure() || !params[1]->isProcedure()) {
+        throw LispError("call-with-values: arguments must be procedures.");
+    }
+    ValuePtr produced = env.applyOrEscape(params[0], {});
+    if (produced == LISP_ESCAPE) {
+        return produced;
+    }
+    std::vector<ValuePtr> args;
+    if (typeid(*produced) == typeid(MultipleValuesValue)) {
+        auto& values = static_cast<MultipleValuesValue&>(*produced);
+        args.reserve(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            args.push_back(values[i]);
+        }
+        finish_values(produced);
+    } else {
+        args.push_back(std::move(produced));
+    }
+    return env.applyOrEscape(params[1], std::move(args));
+}
+
+// 延迟求值
+// 按 R7RS 的方式迭代求值：delay-force 的结果是另一个 promise 时，把它的状态移入本 promise 并让它共享本 promise 的状态，
+// 然后继续循环，长的 delay-force 链只占用常量的原生栈与内存
+static ValuePtr force_promise(const ValuePtr& value, EvalEnv& env) {
+    if (typeid(*value) != typeid(PromiseValue)) {
+        return value;
+    }
+    std::shared_ptr<PromiseState> state = static_cast<PromiseValue&>(*value).state;
+    while (!state->done) {
+        ValuePtr expr = state->expr;
+        std::shared_ptr<EvalEnv> promise_env = state->env;
+        ValuePtr result = promise_env->evalOrEscape(expr);
+        if (result == LISP_ESCAPE) {
+            return result;
+        }
+        if (state->done) {
+            // 求值中重入的 force 已经得到了值，以先得到的为准
+            break;
+        }
+        if (!state->delay_force) {
+            state->done = true;
+            state->value = std::move(result);
+            state->expr = nullptr;
+            state->env = nullptr;
+            break;
+        }
+        if (typeid(*result) != typeid(PromiseValue)) {
+            throw LispError("delay-force: expression must evaluate to a promise. Got: " + brief_repr(*result));
+        }
+        auto& next = static_cast<PromiseValue&>(*result);
+        if (next.state != state) {
+            std::shared_ptr<PromiseState> next_state = std::move(next.state);
+            *state = *next_state;
+            next.state = state;
+        }
+    }
+    return state->value;
+}
+
+static ValuePtr builtin_force(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return force_promise(params[0], env);
+}
+
+static ValuePtr builtin_make_promise(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (typeid(*params[0]) == typeid(PromiseValue)) {
+        return params[0];
+    }
+    auto state = std::make_shared<PromiseState>();
+    state->done = true;
+    state->value = params[0];
+    return std::make_shared<PromiseValue>(std::move(state));
+}
+
+static ValuePtr builtin_is_promise(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return typeid(*params[0]) == typeid(PromiseValue) ? LISP_TRUE : LISP_FALSE;
+}
+
+static ValuePtr builtin_stream_car(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isPair()) {
+        throw LispError("stream-car: argument must be a stream pair. Got: " + brief_repr(*params[0]));
+    }
+    return static_cast<PairValue&>(*params[0]).l;
+}
+
+static ValuePtr builtin_stream_cdr(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isPair()) {
+        throw LispError("stream-cdr: argument must be a stream pair. Got: " + brief_repr(*params[0]));
+    }
+    return force_promise(static_cast<PairValue&>(*params[0]).r, env);
+}
+
+// 续延与 dynamic-wind
+static ValuePtr builtin_call_cc(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isProcedure()) {
+        throw LispError("call/cc: argument must be a procedure. Got: " + brief_repr(*params[0]));
+    }
+    auto continuation = std::make_shared<ContinuationValue>(Scheduler::current().runningTask());
+    // 无论正常返回还是经异常离开，之后都不能再用它逃逸
+    struct Deactivate {
+        ContinuationValue& continuation;
+        ~Deactivate() {
+            continuation.active = false;
+        }
+    } deactivate{*continuation};
+    try {
+        ValuePtr result = env.applyOrEscape(params[0], {continuation});
+        if (result == LISP_ESCAPE && pending_escape().target == continuation.get()) {
+            return std::exchange(pending_escape(), ContinuationJump{nullptr, nullptr}).value;
+        }
+        return result;
+    } catch (const ContinuationJump& jump) {
+        // 逃逸途中经过了不认识 LISP_ESCAPE 的调用方（如 map），由它改为抛出
+        if (jump.target != continuation.get()) {
+            throw;
+        }
+        return jump.value;
+    }
+}
+
+static ValuePtr builtin_dynamic_wind(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    for (const auto& param : params) {
+        if (!param->isProcedure()) {
+            throw LispError("dynamic-wind: arguments must be procedures. Got: " + brief_repr(*param));
+        }
+    }
+    env.apply(params[0], {});
+    ValuePtr result;
+    try {
+        result = env.applyOrEscape(params[1], {});
+    } catch (...) {
+        // 经续延逃逸或出错离开 thunk 时同样执行 after
+        env.apply(params[2], {});
+        throw;
+    }
+    if (result == LISP_ESCAPE) {
+        // after 中也可能发生逃逸，先取出正在传回的逃逸，after 正常返回后再继续传回
+        ContinuationJump escape = std::exchange(pending_escape(), ContinuationJump{nullptr, nullptr});
+        env.apply(params[2], {});
+        pending_escape() = std::move(escape);
+        return result;
+    }
+    env.apply(params[2], {});
+    return result;
+}
+
+// 异常处理
+static ValuePtr builtin_with_exception_handler(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isProcedure() || !params[1]->isProcedure()) {
+        throw LispError("with-exception-handler: arguments must be procedures.");
+    }
+    HandlerFrame frame{current_handlers, params[0]};
+    try {
+        HandlerScope scope(&frame);
+        return env.applyOrEscape(params[1], {});
+    } catch (const UnhandledCondition&) {
+        throw;
+    } catch (const std::runtime_error& error) {
+        // 没有经过 callBuiltin 的错误（如未定义的变量）抛到这里，此时已离开 thunk，仍交给本层的处理过程
+        return raise_condition(env, error_condition(error), false, &frame);
+    }
+}
+
+static ValuePtr builtin_raise(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return raise_condition(env, params[0], false);
+}
+
+static ValuePtr builtin_raise_continuable(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return raise_condition(env, params[0], true);
+}
+
+static ValuePtr builtin_error_object(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return typeid(*params[0]) == typeid(ErrorObjectValue) ? LISP_TRUE : LISP_FALSE;
+}
+
+static ErrorObjectValue& error_object_arg(const char* name, const ValuePtr& value) {
+    if (typeid(*value) != typeid(ErrorObjectValue)) {
+        throw LispError(std::string(name) + ": argument must be an error object. Got: " + brief_repr(*value));
+    }
+    return static_cast<ErrorObjectValue&>(*value);
+}
+
+static ValuePtr builtin_error_object_message(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return std::make_shared<StringValue>(error_object_arg("error-object-message", params[0]).message);
+}
+
+static ValuePtr builtin_error_object_irritants(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    return error_object_arg("error-object-irritants", params[0]).irritants;
+}
+
+// 协程相关
+static ValuePtr builtin_spawn(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isProcedure()) throw LispError("spawn: argument must be a procedure. Got: " + brief_repr(*params[0]));
+    return Scheduler::current().spawn(params[0], env.shared_from_this());
+}
+
+static ValuePtr builtin_yield(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    Scheduler::current().yield();
+    return LISP_NIL;
+}
+
+static ValuePtr builtin_sleep(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    if (!params[0]->isNumber()) throw LispError("sleep: expects a numeric argument (seconds).");
+    double seconds = params[0]->asNumber();
+    if (seconds < 0) throw LispError("sleep: duration must be non-negative.");
+    Scheduler::current().sleepFor(seconds);
+    return LISP_NIL;
+}
+
+static ValuePtr builtin_join(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    auto task = std::dynamic_pointer_cast<TaskValue>(params[0]);
+    if (!task) throw LispError("join: argument must be a task. Got: " + brief_repr(*params[0]));
+    return Scheduler::current().join(task);
+}
+
+static ValuePtr builtin_is_task(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return std::dynamic_pointer_cast<TaskValue>(params[0]) ? LISP_TRUE : LISP_FALSE;
+}
+
+static ValuePtr builtin_run_event_loop(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    Scheduler::current().runAll();
+    return LISP_NIL;
+}
+
+static ValuePtr builtin_set_timeout(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isNumber()) throw LispError("set-timeout: first argument must be a number. Got: " + brief_repr(*params[0]));
+    if (!params[1]->isProcedure()) throw LispError("set-timeout: second argument must be a procedure. Got: " + brief_repr(*params[1]));
+    return Scheduler::current().spawn(params[1], env.shared_from_this(), std::max(0.0, params[0]->asNumber()));
+}
+
+// 端口与非阻塞 I/O
+static PortPtr expect_port(const ValuePtr& value, const std::string& who) {
+    auto port = std::dynamic_pointer_cast<PortValue>(value);
+    if (!port) throw LispError(who + ": argument must be a port. Got: " + brief_repr(*value));
+    return port;
+}
+
+static ValuePtr optional_string(const std::optional<std::string>& text) {
+    if (!text) return LISP_NIL;
+    return std::make_shared<StringValue>(*text);
+}
+
+static ValuePtr builtin_open_input_file(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    if (!params[0]->isString()) throw LispError("open-input-file: expects a file name string");
+    return PortValue::openFile(params[0]->asString(), false);
+}
+
+static ValuePtr builtin_open_output_file(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    if (!params[0]->isString()) throw LispError("open-output-file: expects a file name string");
+    return PortValue::openFile(params[0]->asString(), true);
+}
+
+static ValuePtr builtin_make_pipe(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    auto [read_end, write_end] = PortValue::makePipe();
+    std::vector<ValuePtr> ends{read_end, write_end};
+    return toList(ends);
+}
+
+static ValuePtr builtin_close_port(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    expect_port(params[0], "close-port")->close();
+    return LISP_NIL;
+}
+
+static ValuePtr builtin_is_port(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return std::dynamic_pointer_cast<PortValue>(params[0]) ? LISP_TRUE : LISP_FALSE;
+}
+
+static ValuePtr builtin_current_input_port(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return PortValue::standardInput();
+}
+
+static ValuePtr builtin_read_line_async(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return optional_string(expect_port(params[0], "read-line-async")->readLine());
+}
+
+static ValuePtr builtin_read_chunk_async(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return optional_string(expect_port(params[0], "read-chunk-async")->readChunk());
+}
+
+static ValuePtr builtin_write_async(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    auto port = expect_port(params[0], "write-async");
+    auto str_val = std::dynamic_pointer_cast<StringValue>(params[1]);
+    port->write(str_val ? str_val->getValue() : params[1]->toString());
+    return LISP_NIL;
+}
+
+// 迭代器与生成器
+static ValuePtr builtin_in_range(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    for (const auto& param : params) {
+        if (!param->isNumber()) {
+            throw LispError("in-range: arguments must be numbers. Got: " + brief_repr(*param));
+        }
+    }
+    // (in-range end)、(in-range start end) 或 (in-range start end step)
+    double start = params.size() == 1 ? 0 : params[0]->asNumber();
+    double end = params.size() == 1 ? params[0]->asNumber() : params[1]->asNumber();
+    double step = params.size() == 3 ? params[2]->asNumber() : 1;
+    return std::make_shared<RangeIterator>(start, end, step);
+}
+
+static ValuePtr builtin_in_lines(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return std::make_shared<LinesIterator>(expect_port(params[0], "in-lines"));
+}
+
+static ValuePtr builtin_make_generator(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isProcedure()) {
+        throw LispError("make-generator: argument must be a procedure. Got: " + brief_repr(*params[0]));
+    }
+    return std::make_shared<GeneratorValue>(params[0], env.shared_from_this());
+}
+
+static ValuePtr builtin_generator_yield(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    GeneratorValue::yield(params[0]);
+    return LISP_NIL;
+}
+
+static ValuePtr builtin_is_iterator(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return as_iterator(params[0]) ? LISP_TRUE : LISP_FALSE;
+}
+
+static std::shared_ptr<IteratorValue> expect_iterator(const ValuePtr& value, const std::string& who) {
+    auto iterator = as_iterator(value);
+    if (!iterator) throw LispError(who + ": argument must be an iterator. Got: " + brief_repr(*value));
+    return iterator;
+}
+
+// (iterator-next it) 或 (iterator-next it default)：取完后返回 default，没有 default 时报错
+static ValuePtr builtin_iterator_next(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    ValuePtr item = expect_iterator(params[0], "iterator-next")->next(env);
+    if (item) {
+        return item;
+    }
+    if (params.size() == 2) {
+        return params[1];
+    }
+    throw LispError("iterator-next: iterator is exhausted.");
+}
+
+static ValuePtr builtin_iterator_to_list(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    auto iterator = expect_iterator(params[0], "iterator->list");
+    std::vector<ValuePtr> elements;
+    while (ValuePtr item = iterator->next(env)) {
+        if (item == LISP_ESCAPE) {
+            return item;
+        }
+        elements.push_back(std::move(item));
+    }
+    return toList(elements);
+}
+
+static ValuePtr builtin_for_each(const std::vector<ValuePtr>& params, EvalEnv& env) {
+    if (!params[0]->isProcedure()) {
+        throw LispError("for-each: first argument must be a procedure. Got: " + brief_repr(*params[0]));
+    }
+    if (auto iterator = as_iterator(params[1])) {
+        while (ValuePtr item = iterator->next(env)) {
+            if (item == LISP_ESCAPE || env.applyOrEscape(params[0], {std::move(item)}) == LISP_ESCAPE) {
+                return LISP_ESCAPE;
+            }
+        }
+        return LISP_NIL;
+    }
+    if (!params[1]->isList()) {
+        throw LispError("for-each: second argument must be a list or an iterator. Got: " + brief_repr(*params[1]));
+    }
+    for (ValuePtr rest = params[1]; rest->isPair(); rest = static_cast<PairValue&>(*rest).r) {
+        if (env.applyOrEscape(params[0], {static_cast<PairValue&>(*rest).l}) == LISP_ESCAPE) {
+            return LISP_ESCAPE;
+        }
+    }
+    return LISP_NIL;
+}
+
+// readline / read 的非阻塞版本，从标准输入读取
+static ValuePtr builtin_readline_async(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    return optional_string(PortValue::standardInput()->readLine());
+}
+
+static ValuePtr builtin_read_async(const std::vector<ValuePtr>& params, EvalEnv& env /*env unused*/) {
+    auto line = PortValue::standardInput()->readLine();
+    if (!line) return LISP_NIL;
+    try {
+        Parser parser(Tokenizer::tokenize(*line));
+        return parser.parse();
+    } catch (const std::exception& e) {
+        throw LispError("read-async: failed to parse input: " + std::string(e.what()));
+    }
+}
+
+// 全部内建过程。BUILTIN_PURE 的过程可被优化器在编译期求值。
+static constexpr BuiltinDescriptor BUILTIN_DESCRIPTORS[] = {
+    {"apply", &builtin_apply, 2, 2, BUILTIN_IMPURE},
+    {"display", &builtin_display, 1, 1, BUILTIN_IMPURE},
+    {"displayln", &builtin_displayln, 1, 1, BUILTIN_IMPURE},
+    {"error", &builtin_error, 0, ARITY_VARIADIC, BUILTIN_IMPURE},
+    {"eval", &builtin_eval, 1, 1, BUILTIN_CAPTURES_ENV},
+    {"exit", &builtin_exit, 0, 1, BUILTIN_IMPURE},
+    {"newline", &builtin_newline, 0, 0, BUILTIN_IMPURE},
+    {"print", &builtin_print, 0, ARITY_VARIADIC, BUILTIN_IMPURE},
+    native_builtin<"atom?", &builtin_atom>(BUILTIN_PURE),
+    native_builtin<"boolean?", &builtin_boolean>(BUILTIN_PURE),
+    native_builtin<"integer?", &builtin_integer>(BUILTIN_PURE),
+    native_builtin<"list?", &builtin_list_>(BUILTIN_PURE),
+    native_builtin<"number?", &builtin_number>(BUILTIN_PURE),
+    native_builtin<"null?", &builtin_null>(BUILTIN_PURE),
+    native_builtin<"pair?", &builtin_pair>(BUILTIN_PURE),
+    native_builtin<"procedure?", &builtin_procedure>(BUILTIN_PURE),
+    native_builtin<"string?", &builtin_string>(BUILTIN_PURE),
+    native_builtin<"symbol?", &builtin_symbol>(BUILTIN_PURE),
+    {"append", &builtin_append, 0, ARITY_VARIADIC, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    native_builtin<"car", &builtin_car>(BUILTIN_PURE),
+    native_builtin<"cdr", &builtin_cdr>(BUILTIN_PURE),
+    native_builtin<"cons", &builtin_cons>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    {"length", &builtin_length, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"list", &builtin_list, 0, ARITY_VARIADIC, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    // 向量是可变的：构造新向量的过程不做常量折叠，vector-ref 的结果也可能随 vector-set! 改变
+    {"make-vector", &builtin_make_vector, 1, 2, BUILTIN_ALLOCATES},
+    {"vector", &builtin_vector, 0, ARITY_VARIADIC, BUILTIN_ALLOCATES},
+    native_builtin<"vector?", &builtin_is_vector>(BUILTIN_PURE),
+    native_builtin<"vector-length", &builtin_vector_length>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"vector-ref", &builtin_vector_ref>(BUILTIN_IMPURE),
+    native_builtin<"vector-set!", &builtin_vector_set>(BUILTIN_IMPURE),
+    native_builtin<"vector-fill!", &builtin_vector_fill>(BUILTIN_IMPURE),
+    {"vector-map", &builtin_vector_map, 2, ARITY_VARIADIC, BUILTIN_ALLOCATES},
+    {"vector-for-each", &builtin_vector_for_each, 2, ARITY_VARIADIC, BUILTIN_IMPURE},
+    {"list->vector", &builtin_list_to_vector, 1, 1, BUILTIN_ALLOCATES},
+    {"vector->list", &builtin_vector_to_list, 1, 1, BUILTIN_ALLOCATES},
+    {"map", &builtin_map, 2, 2, BUILTIN_ALLOCATES},
+    {"filter", &builtin_filter, 2, 2, BUILTIN_ALLOCATES},
+    {"reduce", &builtin_reduce, 2, 2, BUILTIN_IMPURE},
+    {"for-each", &builtin_for_each, 2, 2, BUILTIN_IMPURE},
+    // values 的结果不是普通的值，不参与常量折叠
+    {"values", &builtin_values, 0, ARITY_VARIADIC, BUILTIN_IMPURE, &builtin_values1, &builtin_values2},
+    {"call-with-values", &builtin_call_with_values, 2, 2, BUILTIN_IMPURE},
+    {"force", &builtin_force, 1, 1, BUILTIN_IMPURE},
+    {"make-promise", &builtin_make_promise, 1, 1, BUILTIN_ALLOCATES},
+    {"promise?", &builtin_is_promise, 1, 1, BUILTIN_PURE},
+    {"stream-car", &builtin_stream_car, 1, 1, BUILTIN_PURE},
+    {"stream-cdr", &builtin_stream_cdr, 1, 1, BUILTIN_IMPURE},
+    {"call-with-current-continuation", &builtin_call_cc, 1, 1, BUILTIN_ALLOCATES},
+    {"call/cc", &builtin_call_cc, 1, 1, BUILTIN_ALLOCATES},
+    {"dynamic-wind", &builtin_dynamic_wind, 3, 3, BUILTIN_IMPURE},
+    {"with-exception-handler", &builtin_with_exception_handler, 2, 2, BUILTIN_IMPURE},
+    {"raise", &builtin_raise, 1, 1, BUILTIN_IMPURE},
+    {"raise-continuable", &builtin_raise_continuable, 1, 1, BUILTIN_IMPURE},
+    {"error-object?", &builtin_error_object, 1, 1, BUILTIN_PURE},
+    {"error-object-message", &builtin_error_object_message, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"error-object-irritants", &builtin_error_object_irritants, 1, 1, BUILTIN_PURE},
+    native_builtin<"+", &builtin_add>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"-", &builtin_subtract>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"*", &builtin_multiply>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"/", &builtin_divide>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"abs", &builtin_abs>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"expt", &builtin_expt>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"quotient", &builtin_quotient>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"modulo", &builtin_modulo>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"remainder", &builtin_remainder>(BUILTIN_PURE | BUILTIN_ALLOCATES),
+    native_builtin<"eq?", &builtin_eq>(BUILTIN_PURE),
+    native_builtin<"equal?", &builtin_equal_>(BUILTIN_PURE),
+    native_builtin<"not", &builtin_not>(BUILTIN_PURE),
+    native_builtin<">", &builtin_greater>(BUILTIN_PURE),
+    native_builtin<"<", &builtin_lesser>(BUILTIN_PURE),
+    native_builtin<"=", &builtin_equal>(BUILTIN_PURE),
+    native_builtin<">=", &builtin_greater_equal>(BUILTIN_PURE),
+    native_builtin<"<=", &builtin_lesser_equal>(BUILTIN_PURE),
+    native_builtin<"even?", &builtin_is_even>(BUILTIN_PURE),
+    native_builtin<"odd?", &builtin_is_odd>(BUILTIN_PURE),
+    native_builtin<"zero?", &builtin_is_zero>(BUILTIN_PURE),
+    {"string-append", &string_append, 0, ARITY_VARIADIC, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"string-length", &string_length, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"string-ref", &string_ref, 2, 2, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"number-string", &number_to_string, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"string-number", &string_to_number, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"string=?", &string_equal, 2, 2, BUILTIN_PURE},
+    {"string<?", &string_less, 2, 2, BUILTIN_PURE},
+    {"string>?", &string_greater, 2, 2, BUILTIN_PURE},
+    {"string-upcase", &string_upcase, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"string-downcase", &string_downcase, 1, 1, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"substring", &substring, 3, 3, BUILTIN_PURE | BUILTIN_ALLOCATES},
+    {"readline", &readline, 0, 0, BUILTIN_ALLOCATES},
+    {"read", &builtin_read, 0, 0, BUILTIN_ALLOCATES},
+    {"read-multiline", &read_multiline, 0, 0, BUILTIN_ALLOCATES},
+    {"spawn", &builtin_spawn, 1, 1, BUILTIN_ALLOCATES | BUILTIN_CAPTURES_ENV},
+    {"yield", &builtin_yield, 0, 0, BUILTIN_IMPURE},
+    {"sleep", &builtin_sleep, 1, 1, BUILTIN_IMPURE},
+    {"join", &builtin_join, 1, 1, BUILTIN_IMPURE},
+    {"task?", &builtin_is_task, 1, 1, BUILTIN_PURE},
+    {"run-event-loop", &builtin_run_event_loop, 0, 0, BUILTIN_IMPURE},
+    {"set-timeout", &builtin_set_timeout, 2, 2, BUILTIN_ALLOCATES | BUILTIN_CAPTURES_ENV},
+    {"open-input-file", &builtin_open_input_file, 1, 1, BUILTIN_ALLOCATES},
+    {"open-output-file", &builtin_open_output_file, 1, 1, BUILTIN_ALLOCATES},
+    {"make-pipe", &builtin_make_pipe, 0, 0, BUILTIN_ALLOCATES},
+    {"close-port", &builtin_close_port, 1, 1, BUILTIN_IMPURE},
+    {"port?", &builtin_is_port, 1, 1, BUILTIN_PURE},
+    {"current-input-port", &builtin_current_input_port, 0, 0, BUILTIN_IMPURE},
+    {"read-line-async", &builtin_read_line_async, 1, 1, BUILTIN_ALLOCATES},
+    {"read-chunk-async", &builtin_read_chunk_async, 1, 1, BUILTIN_ALLOCATES},
+    {"write-async", &builtin_write_async, 2, 2, BUILTIN_IMPURE},
+    {"in-range", &builtin_in_range, 1, 3, BUILTIN_ALLOCATES},
+    {"in-lines", &builtin_in_lines, 1, 1, BUILTIN_ALLOCATES},
+    {"make-generator", &builtin_make_generator, 1, 1, BUILTIN_ALLOCATES | BUILTIN_CAPTURES_ENV},
+    {"generator-yield", &builtin_generator_yield, 1, 1, BUILTIN_IMPURE},
+    {"iterator?", &builtin_is_iterator, 1, 1, BUILTIN_PURE},
+    {"iterator-next", &builtin_iterator_next, 1, 2, BUILTIN_IMPURE},
+    {"iterator->list", &builtin_iterator_to_list, 1, 1, BUILTIN_ALLOCATES},
+    {"readline-async", &builtin_readline_async, 0, 0, BUILTIN_ALLOCATES},
+    {"read-async", &builtin_read_async, 0, 0, BUILTIN_ALLOCATES},
+};
+
+std::span<const BuiltinDescriptor> builtin_descriptors() {
+    return BUILTIN_DESCRIPTORS;
+}
+
+const BuiltinDescriptor* find_builtin(std::string_view name) {
+    for (const auto& descriptor : BUILTIN_DESCRIPTORS) {
+        if (name == descriptor.name) {
+            return &descriptor;
+        }
+    }
+    return nullptr;
+}
+
+void throw_arity_error(const BuiltinDescriptor& descriptor, size_t count) {
+    std::string expected = std::to_string(descriptor.min_arity);
+    size_t shown = descriptor.min_arity;
+    if (descriptor.max_arity == ARITY_VARIADIC) {
+        expected = "at least " + expected;
+    } else if (descriptor.min_arity == 0 && descriptor.max_arity != 0) {
+        expected = "at most " + std::to_string(descriptor.max_arity);
+        shown = descriptor.max_arity;
+    } else if (descriptor.max_arity != descriptor.min_arity) {
+        expected += " to " + std::to_string(descriptor.max_arity);
+        shown = descriptor.max_arity;
+    }
+    bool singular = shown == 1;
+    throw LispError(std::string(descriptor.name) + ": expects " + expected + (singular ? " argument" : " arguments") +
+                    ". Got: " + std::to_string(count));
+}
+
+const BuiltinProceduresMap& get_builtin_procedures() {
+    // 局部静态变量的初始化是线程安全的
+    static const BuiltinProceduresMap procedures_map_instance = [] {
+        BuiltinProceduresMap procedures;
+        for (const auto& descriptor : BUILTIN_DESCRIPTORS) {
+            procedures[descriptor.name] = std::make_shared<BuiltinProcValue>(&descriptor);
+        }
+        return procedures;
+    }();
     return procedures_map_instance;
 }
\ No newline at end of file
@@ -3,8 +3,99 @@
 #include "error.h"
 #include "token.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+// 固定元数内建过程的专用入口，省去构造实参 vector
+using BuiltinFunc1Type = ValuePtr (*)(const ValuePtr& a, EvalEnv& env);
+using BuiltinFunc2Type = ValuePtr (*)(const ValuePtr& a, const ValuePtr& b, EvalEnv& env);
+
+constexpr size_t ARITY_VARIADIC = SIZE_MAX;
+
+enum BuiltinFlags : unsigned {
+    BUILTIN_IMPURE = 0,
+    // 没有副作用，结果只取决于实参：实参都是常量时可以在编译期求值
+    BUILTIN_PURE = 1u << 0,
+    // 结果可能是新分配的对象
+    BUILTIN_ALLOCATES = 1u << 1,
+    // 会保留或使用调用处的环境（eval、spawn 等）：调用它的过程的帧可能逃逸，也不能内联到别处
+    BUILTIN_CAPTURES_ENV = 1u << 2,
+};
+
+// 内建过程的描述信息。元数由求值器在调用处统一检查，
+// 内建过程本身不再检查实参个数；优化器也依据这些信息做常量折叠等变换。
+struct BuiltinDescriptor {
+    const char* name;
+    BuiltinFuncType fn;
+    size_t min_arity;
+    size_t max_arity;  // ARITY_VARIADIC 表示不限
+    unsigned flags;
+    BuiltinFunc1Type fn1 = nullptr;  // 实参恰好为 1 个时的专用入口（可选）
+    BuiltinFunc2Type fn2 = nullptr;  // 实参恰好为 2 个时的专用入口（可选）
+
+    constexpr bool accepts(size_t count) const {
+        return count >= min_arity && count <= max_arity;
+    }
+    constexpr bool isPure() const {
+        return flags & BUILTIN_PURE;
+    }
+    constexpr bool allocates() const {
+        return flags & BUILTIN_ALLOCATES;
+    }
+    constexpr bool capturesEnv() const {
+        return flags & BUILTIN_CAPTURES_ENV;
+    }
+};
+
+// 实参个数不符时抛出 LispError
+[[noreturn]] void throw_arity_error(const BuiltinDescriptor& descriptor, size_t count);
+
+inline void check_arity(const BuiltinDescriptor& descriptor, size_t count) {
+    if (!descriptor.accepts(count)) [[unlikely]] {
+        throw_arity_error(descriptor, count);
+    }
+}
+
+std::span<const BuiltinDescriptor> builtin_descriptors();
+const BuiltinDescriptor* find_builtin(std::string_view name);
+
+// values 的结果：恰好 1 个值时就是该值本身，否则是 MultipleValuesValue。
+// 不超过 4 个值时使用线程内循环使用的对象，不分配内存
+ValuePtr make_values(const ValuePtr* values, size_t count);
+// 消费方取出 produced 中的各个值之后调用：produced 是池中的对象且不再被别处引用时清空它
+void finish_values(const ValuePtr& produced);
 
 using BuiltinProceduresMap = std::map<std::string, std::shared_ptr<BuiltinProcValue>>;
 
 const BuiltinProceduresMap& get_builtin_procedures();
+
+// display 等内建过程的输出目标，默认为 std::cout
+std::ostream& lisp_output();
+
+// 在作用域内把当前线程的 Lisp 输出重定向到 stream，用于按请求捕获输出
+class OutputRedirect {
+    std::ostream* previous;
+public:
+    explicit OutputRedirect(std::ostream& stream);
+    ~OutputRedirect();
+    OutputRedirect(const OutputRedirect&) = delete;
+    OutputRedirect& operator=(const OutputRedirect&) = delete;
+};
+
+// 在作用域内让当前线程的 exit 抛出 ExitRequest 而不是结束进程
+class ExitTrap {
+    bool previous;
+public:
+    ExitTrap();
+    ~ExitTrap();
+    ExitTrap(const ExitTrap&) = delete;
+    ExitTrap& operator=(const ExitTrap&) = delete;
+};
+
+// exit 的实现：在 ExitTrap 作用域内或任务的栈上抛出 ExitRequest，否则结束进程。
+// 任务中的 ExitRequest 由调度器切回主流程后再交给这里（见 Scheduler::resume），不在任务栈上结束进程
+[[noreturn]] void requestExit(int code);
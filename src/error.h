@@ -1,8 +1,12 @@
 #ifndef ERROR_H
 #define ERROR_H
 
+#include <memory>
 #include <stdexcept>
 
+class Value;
+class ContinuationValue;
+
 class SyntaxError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
@@ -13,4 +17,27 @@ public:
     using runtime_error::runtime_error;
 };
 
+// 没有处理器时 raise 抛出的错误。它已经越过了所有可用的处理器，
+// 途经的 guard、with-exception-handler 与 callBuiltin 不再处理它
+class UnhandledCondition : public LispError {
+public:
+    using LispError::LispError;
+};
+
+// 捕获模式下（见 runCaptured）exit 不结束进程，而是抛出此异常，
+// 由调用方结束当前脚本。它不派生自 std::exception，不会被普通的错误处理拦截。
+class ExitRequest {
+public:
+    int code;
+    explicit ExitRequest(int code) : code(code) {}
+};
+
+// 续延逃逸的目标与实参。逃逸通常以返回值的方式传回（见 eval_env.h 的 LISP_ESCAPE），
+// 途经不认识该标记的调用方（如 map 调用的过程）时改为抛出它，由创建 target 的 call/cc 捕获。
+// 同样不派生自 std::exception，沿途的错误处理不会拦截它；dynamic-wind 在它经过时执行 after
+struct ContinuationJump {
+    const ContinuationValue* target;
+    std::shared_ptr<Value> value;
+};
+
 #endif
\ No newline at end of file
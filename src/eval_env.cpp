@@ -1,9 +1,17 @@
 #include "eval_env.h"
 #include "error.h"
+#include "frame_arena.h"
+#include "handler_stack.h"
+#include "optimizer.h"
+#include "scheduler.h"
+#include "stack_segments.h"
+#include "syntax_rules.h"
 
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <utility>
 
 using namespace std::literals;
 
@@ -11,158 +19,345 @@ const ValuePtr LISP_NIL = std::make_shared<NilValue>();
 const ValuePtr LISP_TRUE = std::make_shared<BooleanValue>(1);
 const ValuePtr LISP_FALSE = std::make_shared<BooleanValue>(0);
 
+namespace {
+class EscapeValue : public Value {
+public:
+    std::string toString() const override {
+        return "#<escape>";
+    }
+};
+
+thread_local ContinuationJump escape_in_flight{nullptr, nullptr};
+}  // namespace
+
+const ValuePtr LISP_ESCAPE = std::make_shared<EscapeValue>();
+
+ContinuationJump& pending_escape() {
+    return escape_in_flight;
+}
+
+void throw_pending_escape() {
+    throw std::exchange(escape_in_flight, ContinuationJump{nullptr, nullptr});
+}
+
 std::unordered_map<std::string, ValuePtr> global_symbol_table;
+// 符号表在各线程间共享（--batch 模式），驻留时需要加锁
+static std::mutex symbol_table_mutex;
 ValuePtr EvalEnv::expandQuasiquote(const ValuePtr& tmpl) {
+    ValuePtr expanded = expandTemplate(tmpl, 0);
+    return expanded ? expanded : tmpl;
+}
+
+ValuePtr EvalEnv::expandTemplate(const ValuePtr& tmpl, int level) {
+    if (typeid(*tmpl) == typeid(VectorValue)) {
+        // 向量模板按元素组成的表展开，再转换回向量
+        std::vector<ValuePtr> elements = static_cast<VectorValue&>(*tmpl).elements;
+        ValuePtr expanded = expandTemplate(toList(elements), level);
+        if (!expanded) {
+            return nullptr;
+        }
+        return callBuiltin(*find_builtin("list->vector"), {expanded});
+    }
     if (!tmpl->isPair()) {
-        return tmpl;
+        return nullptr;
     }
-    if (tmpl->isNil()) {
-        return tmpl;
+    auto& pair = static_cast<PairValue&>(*tmpl);
+    switch (template_keyword(tmpl)) {
+        case TemplateKeyword::UNQUOTE:
+            if (level == 0) {
+                return this->eval(template_operand(tmpl));
+            }
+            --level;
+            break;
+        case TemplateKeyword::UNQUOTE_SPLICING:
+            if (level == 0) {
+                throw LispError("unquote-splicing: must appear inside a list template");
+            }
+            --level;
+            break;
+        case TemplateKeyword::QUASIQUOTE:
+            ++level;
+            break;
+        case TemplateKeyword::NONE:
+            break;
     }
-    auto car = std::static_pointer_cast<PairValue>(tmpl)->l;
-    if (car->isSymbol() && car->asSymbol() && *car->asSymbol() == "unquote") {
-        auto cdr = std::static_pointer_cast<PairValue>(tmpl)->r;
-        if (!cdr->isPair() || std::static_pointer_cast<PairValue>(cdr)->r->isNil() == false) {
-            throw LispError("unquote: expects exactly one argument");
+    if (level == 0 && template_keyword(pair.l) == TemplateKeyword::UNQUOTE_SPLICING) {
+        ValuePtr spliced = this->eval(template_operand(pair.l));
+        ValuePtr rest = expandTemplate(pair.r, level);
+        if (!rest) {
+            rest = pair.r;
+        }
+        if (rest->isNil()) {
+            return spliced;
         }
-        auto expr_to_eval = std::static_pointer_cast<PairValue>(cdr)->l;
-        return this->eval(expr_to_eval);
+        // 与 append 相同：复制被拼接的表，与其后的部分共享
+        return callBuiltin(*find_builtin("append"), {spliced, rest});
     }
-    
-    auto expanded_car = this->expandQuasiquote(car);
-    auto expanded_cdr = this->expandQuasiquote(std::static_pointer_cast<PairValue>(tmpl)->r);
-    return std::make_shared<PairValue>(expanded_car, expanded_cdr);
+    ValuePtr car = expandTemplate(pair.l, level);
+    ValuePtr cdr = expandTemplate(pair.r, level);
+    if (!car && !cdr) {
+        return nullptr;
+    }
+    return std::make_shared<PairValue>(car ? car : pair.l, cdr ? cdr : pair.r);
 }
 ValuePtr create_or_get_symbol(const std::string& name) {
+    std::lock_guard<std::mutex> lock(symbol_table_mutex);
     auto it = global_symbol_table.find(name);
     if (it != global_symbol_table.end()) {
         return it->second;
     } else {
-        ValuePtr new_symbol = std::make_shared<SymbolValue>(name);
+        ValuePtr new_symbol = std::make_shared<SymbolValue>(name, global_symbol_table.size());
         global_symbol_table[name] = new_symbol;
         return new_symbol;
     }
 }
 
-ValuePtr EvalEnv::eval(const ValuePtr &expr) {
-    if (expr->isSymbol()) {
-        auto name_opt = expr->asSymbol();
-        return this->lookupBinding(*name_opt);
+const ValuePtr* EvalEnv::ifBranch(const ValuePtr& expr) {
+    if (typeid(*expr) != typeid(PairValue)) {
+        return nullptr;
     }
-    if (expr->isNumber() || expr->isString() || expr->isBoolean()) {
-        return expr;
+    auto& form = static_cast<PairValue&>(*expr);
+    if (typeid(*form.l) != typeid(SymbolValue) || static_cast<SymbolValue&>(*form.l).getName() != "if" ||
+        !form.r->isPair()) {
+        return nullptr;
     }
-    if (expr->isNil()) {
-        return expr;
+    auto& condition = static_cast<PairValue&>(*form.r);
+    if (!condition.r->isPair()) {
+        return nullptr;
     }
-    if (expr->isProcedure()) {
-        return expr;
+    auto& consequent = static_cast<PairValue&>(*condition.r);
+    const ValuePtr* alternative = &LISP_NIL;
+    if (consequent.r->isPair()) {
+        auto& rest = static_cast<PairValue&>(*consequent.r);
+        if (!rest.r->isNil()) {
+            return nullptr;
+        }
+        alternative = &rest.l;
+    } else if (!consequent.r->isNil()) {
+        return nullptr;
     }
-    if (expr->isPair()) {
+    ValuePtr condition_value = this->evalOrEscape(condition.l);
+    if (condition_value == LISP_ESCAPE) {
+        return &LISP_ESCAPE;
+    }
+    return condition_value->isLispFalse() ? alternative : &consequent.l;
+}
+
+ValuePtr EvalEnv::evalOrEscape(const ValuePtr& form) {
+    if (stack_exhausted()) {
+        // 原生栈将要用完时换到新的栈段上继续求值
+        return eval_on_new_stack_segment(*this, form);
+    }
+    // 尾位置上的 lambda 调用不再递归：换到调用帧后在这一层继续求值过程体的最后一个表达式，
+    // 每一层非尾递归只占用一个 eval 的栈帧。frame 与 code 保持当前调用帧与过程体存活
+    EvalEnv* env = this;
+    std::shared_ptr<EvalEnv> frame;
+    std::shared_ptr<const LambdaCode> code;
+    const ValuePtr* tail = &form;
+    for (;;) {
+        // if 的分支同样处在尾位置，选出分支后直接求值
+        while (const ValuePtr* branch = env->ifBranch(*tail)) {
+            if (branch == &LISP_ESCAPE) {
+                return LISP_ESCAPE;
+            }
+            tail = branch;
+        }
+        const ValuePtr& expr = *tail;
+        if (typeid(*expr) == typeid(GlobalRefValue)) {
+            auto& ref = static_cast<GlobalRefValue&>(*expr);
+            if (!ref.cell->value) {
+                throw LispError("Variable " + ref.symbol->toString() + " not defined.");
+            }
+            return ref.cell->value;
+        }
+        if (typeid(*expr) == typeid(SymbolValue)) {
+            return env->lookupSymbol(static_cast<SymbolValue&>(*expr));
+        }
+        if (expr->isNumber() || expr->isString() || expr->isBoolean()) {
+            return expr;
+        }
+        if (expr->isNil()) {
+            return expr;
+        }
+        if (expr->isProcedure()) {
+            return expr;
+        }
+        if (typeid(*expr) == typeid(VectorValue)) {
+            return expr;
+        }
+        if (!expr->isPair()) {
+            throw LispError("Cannot evaluate unexpected value type: " + brief_repr(*expr));
+        }
         std::vector<ValuePtr> elements_vec = expr->toVector();
         if (elements_vec.empty()) {
             throw LispError("Attempt to evaluate an empty application form.");
         }
         ValuePtr op_expr = elements_vec[0];
-        if (op_expr->isSymbol()) {
-            auto op_name_opt = op_expr->asSymbol();
-            const std::string& op_name = *op_name_opt;
+        if (typeid(*op_expr) == typeid(SymbolValue)) {
+            const std::string& op_name = static_cast<SymbolValue&>(*op_expr).getName();
             auto it_sf = SPECIAL_FORMS.find(op_name);
             if (it_sf != SPECIAL_FORMS.end()) {
-                SpecialFormType* form_func = it_sf->second; 
-                std::vector<ValuePtr> form_args;
-                if (elements_vec.size() > 1) {
-                    form_args.assign(elements_vec.begin() + 1, elements_vec.end());
-                }
-                return form_func(form_args, *this);
+                // 去掉运算符后直接作为特殊形式的参数，不另建 vector
+                elements_vec.erase(elements_vec.begin());
+                return it_sf->second(elements_vec, *env);
             }
         }
-        ValuePtr proc_object = this->eval(op_expr);
-        if (auto macro = std::dynamic_pointer_cast<MacroValue>(proc_object)) {
-            ValuePtr args_expr = std::static_pointer_cast<PairValue>(expr)->r;
-            std::vector<ValuePtr> arg_values;
-            if (!args_expr->isNil()) {
-                arg_values = args_expr->toVector();
+        ValuePtr proc_object = env->evalOrEscape(op_expr);
+        if (proc_object == LISP_ESCAPE) {
+            return proc_object;
+        }
+        if (typeid(*proc_object) == typeid(MacroValue) || typeid(*proc_object) == typeid(SyntaxRulesValue)) {
+            return env->evalOrEscape(env->expandMacroCall(proc_object, expr));
+        }
+        if (!proc_object->isProcedure()) {
+            throw LispError("Operator is not a procedure.");
+        }
+        // 每个实参求值后检查逃逸标记，逃逸时不再求值其余实参
+        if (typeid(*proc_object) == typeid(BuiltinProcValue)) {
+            // 元数在调用处检查一次；固定元数的内建过程走专用入口，不构造实参 vector
+            const auto& builtin = static_cast<BuiltinProcValue&>(*proc_object).get_descriptor();
+            size_t argc = elements_vec.size() - 1;
+            check_arity(builtin, argc);
+            if (argc == 1 && builtin.fn1) {
+                ValuePtr arg = env->evalOrEscape(elements_vec[1]);
+                return arg == LISP_ESCAPE ? arg : builtin.fn1(arg, *env);
             }
-            if (macro->params.size() != arg_values.size()) {
-                throw LispError("Macro argument count mismatch");
+            if (argc == 2 && builtin.fn2) {
+                ValuePtr first = env->evalOrEscape(elements_vec[1]);
+                if (first == LISP_ESCAPE) {
+                    return first;
+                }
+                ValuePtr second = env->evalOrEscape(elements_vec[2]);
+                return second == LISP_ESCAPE ? second : builtin.fn2(first, second, *env);
             }
-            auto macro_env = std::make_shared<EvalEnv>(this->shared_from_this());
-            for (size_t i = 0; i < macro->params.size(); ++i) {
-                macro_env->defineBinding(macro->params[i], arg_values[i]);
+        }
+        std::vector<ValuePtr> evaluated_args;
+        evaluated_args.reserve(elements_vec.size() - 1);
+        for (size_t i = 1; i < elements_vec.size(); ++i) {
+            evaluated_args.push_back(env->evalOrEscape(elements_vec[i]));
+            if (evaluated_args.back() == LISP_ESCAPE) {
+                return LISP_ESCAPE;
             }
-            auto expanded = macro_env->eval(macro->body);
-            return this->eval(expanded);
         }
-        if (!proc_object->isProcedure()) {
-            throw LispError("Operator is not a procedure.");
+        if (typeid(*proc_object) == typeid(BuiltinProcValue)) {
+            return env->callBuiltin(static_cast<BuiltinProcValue&>(*proc_object).get_descriptor(), evaluated_args);
+        }
+        if (typeid(*proc_object) != typeid(LambdaValue)) {
+            return env->applyOrEscape(proc_object, std::move(evaluated_args));
+        }
+        // 实参已经求出，调用方的帧不再需要：先释放它，调用帧可以在帧栈（frame_arena.h）上原地复用
+        auto& lambda = static_cast<LambdaValue&>(*proc_object);
+        frame.reset();
+        frame = enterLambda(lambda, std::move(evaluated_args));
+        code = lambda.get_code();
+        env = frame.get();
+        if (code->body.empty()) {
+            return LISP_NIL;
+        }
+        for (size_t i = 0; i + 1 < code->body.size(); ++i) {
+            if (env->evalOrEscape(code->body[i]) == LISP_ESCAPE) {
+                return LISP_ESCAPE;
+            }
         }
-        ValuePtr args_expressions_list = std::static_pointer_cast<PairValue>(expr)->r;
-        std::vector<ValuePtr> evaluated_args = this->evalList(args_expressions_list);
-        return this->apply(proc_object, evaluated_args);
+        tail = &code->body.back();
     }
-    throw LispError("Cannot evaluate unexpected value type: " + expr->toString());
 }
 
-ValuePtr EvalEnv::apply(ValuePtr proc_object, std::vector<ValuePtr> args) {
+ValuePtr EvalEnv::expandMacroCall(const ValuePtr& macro_value, const ValuePtr& expr) {
+    if (typeid(*macro_value) == typeid(SyntaxRulesValue)) {
+        return static_cast<SyntaxRulesValue&>(*macro_value).rules->expand(expr);
+    }
+    auto& macro = static_cast<MacroValue&>(*macro_value);
+    ValuePtr args_expr = static_cast<PairValue&>(*expr).r;
+    std::vector<ValuePtr> arg_values;
+    if (!args_expr->isNil()) {
+        arg_values = args_expr->toVector();
+    }
+    if (macro.params.size() != arg_values.size()) {
+        throw LispError("Macro argument count mismatch");
+    }
+    auto macro_env = std::make_shared<EvalEnv>(this->shared_from_this());
+    for (size_t i = 0; i < macro.params.size(); ++i) {
+        macro_env->defineBinding(macro.params[i], arg_values[i]);
+    }
+    if (macro.optimized_epoch != redefinition_epoch()) {
+        refresh_macro(macro, *this);
+    }
+    return macro_env->eval(macro.code);
+}
+
+ValuePtr EvalEnv::applyOrEscape(ValuePtr proc_object, std::vector<ValuePtr> args) {
     if (typeid(*proc_object) == typeid(BuiltinProcValue)) {
-        auto builtin_proc = std::static_pointer_cast<BuiltinProcValue>(proc_object);
-        BuiltinFuncType func_to_call = builtin_proc->get_function_pointer();
-        if (func_to_call) {
-            try {
-                return func_to_call(args, *this);
-            } catch (const LispError& e) {
-                throw;
-            } catch (const std::exception& e) {
-                throw LispError("Exception in builtin procedure " + proc_object->toString() + ": " + e.what());
-            }
-        }
-        else {
-            throw LispError("BuiltinFuncType* is nullptr for " + proc_object->toString());
-        }
+        const auto& builtin = static_cast<BuiltinProcValue&>(*proc_object).get_descriptor();
+        check_arity(builtin, args.size());
+        return callBuiltin(builtin, args);
     }
-    else if (auto lambda_proc = std::dynamic_pointer_cast<LambdaValue>(proc_object)) {
-        const auto& formal_params = lambda_proc->get_params();
-        const auto& body_expressions = lambda_proc->get_body();
-        std::shared_ptr<EvalEnv> captured_env = lambda_proc->get_captured_env();
-        if (formal_params.size() != args.size()) {
-            throw LispError("Eval::apply error.");
-        }
-        auto call_env = std::make_shared<EvalEnv>(captured_env);
-        for (size_t i = 0; i < formal_params.size(); ++i) {
-           call_env->defineBinding(formal_params[i], args[i]);
-        }
+    else if (auto lambda_proc = dynamic_cast<LambdaValue*>(proc_object.get())) {
+        auto call_env = enterLambda(*lambda_proc, std::move(args));
+        auto code = lambda_proc->get_code();
         ValuePtr result = LISP_NIL; 
-        for (const auto& body_expr : body_expressions) {
-           result = call_env->eval(body_expr);
+        for (const auto& body_expr : code->body) {
+           result = call_env->evalOrEscape(body_expr);
+           if (result == LISP_ESCAPE) {
+               break;
+           }
         }
         return result;
     }
+    else if (typeid(*proc_object) == typeid(ContinuationValue)) {
+        auto& continuation = static_cast<ContinuationValue&>(*proc_object);
+        if (args.size() != 1) {
+            throw LispError("continuation: expects 1 argument, got " + std::to_string(args.size()) + ".");
+        }
+        if (!continuation.active || continuation.owner != Scheduler::current().runningTask()) {
+            throw LispError("continuation: only escapes from within its own call/cc are supported.");
+        }
+        escape_in_flight = ContinuationJump{&continuation, std::move(args[0])};
+        return LISP_ESCAPE;
+    }
     else {
-        throw LispError("Unimplemented: Cannot apply non-builtin procedure: " + proc_object->toString());
+        throw LispError("Unimplemented: Cannot apply non-builtin procedure: " + brief_repr(*proc_object));
     }
 }
 
-std::vector<ValuePtr> EvalEnv::evalList(ValuePtr expr_containing_args) {
-    if (expr_containing_args->isNil()) {
-        return {};
+std::shared_ptr<EvalEnv> EvalEnv::enterLambda(LambdaValue& lambda, std::vector<ValuePtr>&& args) {
+    if (lambda.optimized_epoch != redefinition_epoch()) {
+        refresh_lambda(lambda);
     }
-    if (!expr_containing_args->isPair()) {
-        throw LispError("Invalid argument list structure for evalList: expected a proper list, got " + expr_containing_args->toString()); 
+    const auto& formal_params = lambda.get_params();
+    const LambdaCode& code = *lambda.code;
+    if (formal_params.size() != args.size()) {
+        throw LispError("Eval::apply error.");
     }
-
-    std::vector<ValuePtr> result;
-    std::vector<ValuePtr> unevaluated_arg_expressions;
-    try {
-        unevaluated_arg_expressions = expr_containing_args->toVector();
-    } catch (const std::runtime_error& e) {
-        throw LispError("Invalid argument list structure during toVector in evalList: "s + e.what()); 
+    auto call_env = code.frame_escapes ? std::make_shared<EvalEnv>(lambda.captured_env)
+                                       : make_stack_frame(lambda.captured_env);
+    for (size_t i = 0; i < formal_params.size(); ++i) {
+        call_env->defineBinding(formal_params[i], std::move(args[i]));
+    }
+    for (const auto& name : code.boxed_bindings) {
+        call_env->boxBinding(name);
     }
+    return call_env;
+}
 
-    for (ValuePtr& expr_to_eval : unevaluated_arg_expressions) { 
-        result.push_back(this->eval(expr_to_eval));
+ValuePtr EvalEnv::callBuiltin(const BuiltinDescriptor& builtin, const std::vector<ValuePtr>& args) {
+    try {
+        return builtin.fn(args, *this);
+    } catch (const UnhandledCondition&) {
+        throw;
+    } catch (const LispError& e) {
+        if (current_handlers) {
+            // 有处理器时在这里转为 raise，不必把异常一路抛到 guard
+            return raise_condition(*this, error_condition(e), false);
+        }
+        throw;
+    } catch (const std::exception& e) {
+        LispError error("Exception in builtin procedure " + std::string(builtin.name) + ": " + e.what());
+        if (current_handlers) {
+            return raise_condition(*this, error_condition(error), false);
+        }
+        throw error;
     }
-    return result;
 }
 
 EvalEnv::EvalEnv() : parent(nullptr) {
@@ -171,18 +366,113 @@ EvalEnv::EvalEnv() : parent(nullptr) {
     }
 }
 
-ValuePtr EvalEnv::lookupBinding(const std::string& name) {
-    std::shared_ptr<EvalEnv> current_env = shared_from_this();
-    while (current_env) {
+const ValuePtr* EvalEnv::findLocal(const std::string& name, EvalEnv*& root) {
+    EvalEnv* current_env = this;
+    for (; current_env->parent; current_env = current_env->parent.get()) {
         auto it = current_env->symbol_map.find(name);
         if (it != current_env->symbol_map.end()) {
-            return it->second;
+            if (typeid(*it->second) == typeid(BoxValue)) {
+                const ValuePtr& boxed = static_cast<BoxValue&>(*it->second).value;
+                if (boxed) {
+                    return &boxed;
+                }
+                // 内部 define 尚未执行（或在未执行的分支中），名字仍指向外层的绑定
+                continue;
+            }
+            return &it->second;
         }
-        current_env = current_env->parent; 
     }
-    throw LispError("Variable " + name + " not defined.");
+    root = current_env;
+    return nullptr;
+}
+
+ValuePtr EvalEnv::lookupSymbol(const SymbolValue& symbol) {
+    EvalEnv* root = nullptr;
+    const ValuePtr* local = findLocal(symbol.getName(), root);
+    const ValuePtr& value = local ? *local : root->globalValue(symbol);
+    if (!value) {
+        throw LispError("Variable " + symbol.getName() + " not defined.");
+    }
+    return value;
+}
+
+ValuePtr EvalEnv::lookupBinding(const std::string& name) {
+    return lookupSymbol(static_cast<SymbolValue&>(*create_or_get_symbol(name)));
+}
+
+const ValuePtr& EvalEnv::globalValue(const SymbolValue& symbol) const {
+    static const ValuePtr unbound;
+    size_t id = symbol.getId();
+    return id < global_cells.size() && global_cells[id] ? global_cells[id]->value : unbound;
+}
+
+std::shared_ptr<BoxValue> EvalEnv::globalCell(const SymbolValue& symbol) {
+    size_t id = symbol.getId();
+    if (id >= global_cells.size()) {
+        global_cells.resize(id + 1);
+    }
+    if (!global_cells[id]) {
+        global_cells[id] = std::make_shared<BoxValue>();
+    }
+    return global_cells[id];
 }
 
 void EvalEnv::defineBinding(const std::string& name, ValuePtr value) {
-    symbol_map[name] = value;
+    if (!parent) {
+        // 全局 define 原地更新绑定格，已改写为 GlobalRefValue 的引用随之看到新值
+        globalCell(static_cast<SymbolValue&>(*create_or_get_symbol(name)))->value = std::move(value);
+        return;
+    }
+    auto [it, inserted] = symbol_map.try_emplace(name, std::move(value));
+    if (!inserted) {
+        if (typeid(*it->second) == typeid(BoxValue)) {
+            static_cast<BoxValue&>(*it->second).value = std::move(value);
+        } else {
+            it->second = std::move(value);
+        }
+    }
+}
+
+bool EvalEnv::assignBinding(const std::string& name, ValuePtr value) {
+    EvalEnv* current_env = this;
+    for (; current_env->parent; current_env = current_env->parent.get()) {
+        auto it = current_env->symbol_map.find(name);
+        if (it != current_env->symbol_map.end()) {
+            if (typeid(*it->second) == typeid(BoxValue)) {
+                auto& box = static_cast<BoxValue&>(*it->second);
+                if (!box.value) {
+                    // 与查找一致：尚未执行的内部 define 不遮蔽外层的绑定
+                    continue;
+                }
+                box.value = std::move(value);
+            } else {
+                it->second = std::move(value);
+            }
+            return false;
+        }
+    }
+    auto& symbol = static_cast<SymbolValue&>(*create_or_get_symbol(name));
+    if (!current_env->globalValue(symbol)) {
+        throw LispError("set!: variable " + name + " not defined.");
+    }
+    current_env->globalCell(symbol)->value = std::move(value);
+    return true;
+}
+
+void EvalEnv::clearBindings() {
+    symbol_map.clear();
+    for (auto& cell : global_cells) {
+        if (cell) {
+            cell->value = nullptr;
+        }
+    }
+}
+
+void EvalEnv::boxBinding(const std::string& name) {
+    auto [it, inserted] = symbol_map.try_emplace(name, nullptr);
+    if (inserted) {
+        it->second = std::make_shared<BoxValue>();
+    } else if (typeid(*it->second) != typeid(BoxValue)) {
+        it->second = std::make_shared<BoxValue>(std::move(it->second));
+    }
 }
\ No newline at end of file
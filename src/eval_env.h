@@ -2,6 +2,8 @@
 #define EVAL_ENV_H 
 
 #include <map>
+#include <memory_resource>
+#include "./error.h"
 #include "./value.h"
 #include "./builtins.h"
 #include "./forms.h"
@@ -12,22 +14,81 @@ extern const ValuePtr LISP_FALSE;
 extern std::unordered_map<std::string, ValuePtr> global_symbol_table;
 ValuePtr create_or_get_symbol(const std::string& name);
 
+// 调用逃逸续延时，求值器沿返回路径逐层原样传回这个标记，直到创建该续延的 call/cc，
+// 中间的帧照常释放，不经 C++ 异常。逃逸的目标与实参暂存在 pending_escape() 中
+extern const ValuePtr LISP_ESCAPE;
+// 本线程正在传回的逃逸；没有时 target 为 nullptr
+ContinuationJump& pending_escape();
+// 把正在传回的逃逸改为抛出 ContinuationJump，用于不认识 LISP_ESCAPE 的调用方
+[[noreturn]] void throw_pending_escape();
+
 class EvalEnv : public std::enable_shared_from_this<EvalEnv>{
 public:
+    // 展开 quasiquote 模板：不含 unquote 的子结构原样共享，只在通向 unquote、unquote-splicing 的路径上分配序对
     ValuePtr expandQuasiquote(const ValuePtr& tmpl);
     std::shared_ptr<EvalEnv> parent = nullptr;
     EvalEnv();
     EvalEnv(std::shared_ptr<EvalEnv> parent_env) : parent(parent_env) {}
+    // 绑定表的结点从 resource 分配（见 frame_arena.h）
+    EvalEnv(std::shared_ptr<EvalEnv> parent_env, std::pmr::memory_resource* resource)
+        : parent(std::move(parent_env)), symbol_map(resource) {}
     EvalEnv(const EvalEnv& v)=default;
-    std::map<std::string,ValuePtr> symbol_map{};
-    ValuePtr eval(const ValuePtr &expr);
-    std::vector<ValuePtr> evalList(ValuePtr expr);
-    ValuePtr apply(ValuePtr proc, std::vector<ValuePtr> args);
+    // 局部环境的绑定；全局环境的绑定存放在 global_cells 中
+    std::pmr::map<std::string,ValuePtr> symbol_map{};
+    // 全局环境的绑定格，按符号编号索引。绑定格一旦创建便不再替换，可以被 GlobalRefValue 直接引用
+    std::vector<std::shared_ptr<BoxValue>> global_cells;
+    // 会话的顶层环境（服务模式的请求、进程池的任务）：它是全局环境的子环境，但其中的定义按全局定义对待，
+    // 可以先引用、后定义或重新定义。闭包转换与全局绑定格的改写不越过这一层（见 optimizer.cpp）
+    bool toplevel = false;
+    // 求值器内部与特殊形式使用：经过这里的续延逃逸以返回 LISP_ESCAPE 的方式传回，调用方须立即原样返回它
+    ValuePtr evalOrEscape(const ValuePtr& expr);
+    ValuePtr applyOrEscape(ValuePtr proc, std::vector<ValuePtr> args);
+    // 不会返回 LISP_ESCAPE：经过的逃逸改为抛出 ContinuationJump
+    ValuePtr eval(const ValuePtr& expr) {
+        ValuePtr result = evalOrEscape(expr);
+        if (result == LISP_ESCAPE) {
+            throw_pending_escape();
+        }
+        return result;
+    }
+    ValuePtr apply(ValuePtr proc, std::vector<ValuePtr> args) {
+        ValuePtr result = applyOrEscape(std::move(proc), std::move(args));
+        if (result == LISP_ESCAPE) {
+            throw_pending_escape();
+        }
+        return result;
+    }
+    // 调用内建过程，调用方负责检查元数
+    ValuePtr callBuiltin(const BuiltinDescriptor& builtin, const std::vector<ValuePtr>& args);
     ValuePtr lookupBinding(const std::string& name);
+    ValuePtr lookupSymbol(const SymbolValue& symbol);
+    // 已装箱的绑定只更新盒子中的值
     void defineBinding(const std::string& name, ValuePtr value);
+    // 把本层的绑定装进 BoxValue；尚未绑定时放入一个空盒子，查找时跳过空盒子
+    void boxBinding(const std::string& name);
+    // set!：修改最内层的已有绑定（已装箱的修改盒中的值），没有绑定时报错；修改的是全局绑定时返回 true
+    bool assignBinding(const std::string& name, ValuePtr value);
+    // 全局环境中符号的绑定格，不存在时创建一个空的（只在全局环境上调用）
+    std::shared_ptr<BoxValue> globalCell(const SymbolValue& symbol);
+    // 全局环境中符号的值，未绑定时为空
+    const ValuePtr& globalValue(const SymbolValue& symbol) const;
+    // 清空全部绑定，用于打破闭包与环境之间的引用环
+    void clearBindings();
     std::shared_ptr<EvalEnv> get_shared_this() {
         return shared_from_this();
     }
+
+private:
+    // expr 为结构正确的 (if ...) 时求值条件，返回应求值的分支（无 else 分支时为 LISP_NIL）；否则返回 nullptr
+    const ValuePtr* ifBranch(const ValuePtr& expr);
+    // 为调用 lambda 创建调用帧并绑定实参（优化结果过时时先重新优化），之后求值 lambda.get_code() 的过程体
+    static std::shared_ptr<EvalEnv> enterLambda(LambdaValue& lambda, std::vector<ValuePtr>&& args);
+    // 展开宏调用 expr（macro 为 MacroValue 或 SyntaxRulesValue）。与 eval 分开，使 eval 的栈帧保持较小
+    ValuePtr expandMacroCall(const ValuePtr& macro, const ValuePtr& expr);
+    // level 为 quasiquote 的嵌套层数；模板中没有需要求值的部分时返回 nullptr
+    ValuePtr expandTemplate(const ValuePtr& tmpl, int level);
+    // 在局部环境链中查找（已装箱的绑定返回盒中的值）；找不到时 root 置为全局环境
+    const ValuePtr* findLocal(const std::string& name, EvalEnv*& root);
 };
 
 #endif 
\ No newline at end of file
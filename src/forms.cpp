@@ -1,8 +1,12 @@
 #include "forms.h"
 #include "error.h"
 #include "eval_env.h"
+#include "handler_stack.h"
+#include "optimizer.h"
+#include "syntax_rules.h"
 #include "value.h"
 #include <iostream>
+#include <utility>
 
 std::vector<std::string> get_parameter_names(ValuePtr param_list_node) {
     std::vector<std::string> names;
@@ -60,7 +64,8 @@ ValuePtr defineForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
         if (body_expressions.empty()){
             throw LispError("Function body cannot be empty.");
         }
-        auto lambda_val = std::make_shared<LambdaValue>(function_name_str, param_names_vec, body_expressions, env.shared_from_this());
+        auto lambda_val = make_lambda(function_name_str, param_names_vec, body_expressions, env.shared_from_this());
+        note_definition(function_name_str, lambda_val);
         env.defineBinding(function_name_str, lambda_val); 
         return LISP_NIL;
     }
@@ -74,7 +79,11 @@ ValuePtr defineForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
         }
         const std::string& variable_name = *var_name_opt;
         ValuePtr value_to_be_evaluated = args[1];
-        ValuePtr evaluated_value = env.eval(value_to_be_evaluated);
+        ValuePtr evaluated_value = env.evalOrEscape(value_to_be_evaluated);
+        if (evaluated_value == LISP_ESCAPE) {
+            return evaluated_value;
+        }
+        note_definition(variable_name, evaluated_value);
         env.defineBinding(variable_name, evaluated_value);
         return LISP_NIL;
     }
@@ -96,16 +105,22 @@ ValuePtr condForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
             throw LispError("Invalid Cond : else error.");
         }
         if(it_vector.size() == 1){
-            return env.eval(it_vector[0]);
+            return env.evalOrEscape(it_vector[0]);
         }
         if(it_vector[0]->toString() == "else" && it == args.back()){
-            return env.eval(it_vector.back());
+            return env.evalOrEscape(it_vector.back());
+        }
+        ValuePtr test = env.evalOrEscape(it_vector[0]);
+        if (test == LISP_ESCAPE) {
+            return test;
         }
-        if(!env.eval(it_vector[0])->isLispFalse()){
-            for(auto i : it_vector){
-                env.eval(i);
+        if(!test->isLispFalse()){
+            for (size_t i = 1; i + 1 < it_vector.size(); ++i) {
+                if (env.evalOrEscape(it_vector[i]) == LISP_ESCAPE) {
+                    return LISP_ESCAPE;
+                }
             }
-            return env.eval(it_vector.back());
+            return env.evalOrEscape(it_vector.back());
         }
         else{
             continue;
@@ -118,13 +133,375 @@ ValuePtr beginForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     if (args.empty()){
         throw LispError("Invalid Begin.");
     }
-    for(auto it : args){
-        env.eval(it);
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (env.evalOrEscape(args[i]) == LISP_ESCAPE) {
+            return LISP_ESCAPE;
+        }
     }
-    return env.eval(args.back());
+    return env.evalOrEscape(args.back());
+}
+
+namespace {
+
+// 表达式中是否出现了名字 name（不区分出现的位置）
+bool mentions(const ValuePtr& expr, const std::string& name) {
+    if (expr->isSymbol()) {
+        return static_cast<SymbolValue&>(*expr).getName() == name;
+    }
+    for (ValuePtr rest = expr; rest->isPair(); rest = static_cast<PairValue&>(*rest).r) {
+        if (mentions(static_cast<PairValue&>(*rest).l, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isForm(const std::vector<ValuePtr>& elements, const char* op) {
+    return !elements.empty() && elements[0]->isSymbol() && static_cast<SymbolValue&>(*elements[0]).getName() == op;
+}
+
+// 命名 let 的循环名 name 是否只出现在尾位置上、以 argc 个实参调用。只认识 if、cond、begin、and、or
+// 中的尾位置；其他形式（lambda、let 等）中出现 name 时保守地返回 false
+bool onlyTailCalls(const ValuePtr& expr, const std::string& name, size_t argc, bool tail) {
+    if (!expr->isPair()) {
+        return !mentions(expr, name);
+    }
+    std::vector<ValuePtr> elements;
+    try {
+        elements = expr->toVector();
+    } catch (const std::exception&) {
+        return !mentions(expr, name);
+    }
+    auto all = [&](size_t from, size_t to, bool tail_position) {
+        for (size_t i = from; i < to; ++i) {
+            if (!onlyTailCalls(elements[i], name, argc, tail_position)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (isForm(elements, name.c_str())) {
+        return tail && elements.size() - 1 == argc && all(1, elements.size(), false);
+    }
+    if (isForm(elements, "quote")) {
+        return true;
+    }
+    if (isForm(elements, "if")) {
+        return all(1, std::min<size_t>(2, elements.size()), false) && all(2, elements.size(), tail);
+    }
+    if (isForm(elements, "begin") || isForm(elements, "and") || isForm(elements, "or")) {
+        return all(1, elements.size() - 1, false) && all(elements.size() - 1, elements.size(), tail);
+    }
+    if (isForm(elements, "cond")) {
+        for (size_t i = 1; i < elements.size(); ++i) {
+            if (!elements[i]->isPair()) {
+                return !mentions(expr, name);
+            }
+            std::vector<ValuePtr> clause = elements[i]->toVector();
+            for (size_t j = 0; j < clause.size(); ++j) {
+                if (!onlyTailCalls(clause[j], name, argc, tail && j > 0 && j + 1 == clause.size())) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    if (elements[0]->isSymbol() && SPECIAL_FORMS.count(static_cast<SymbolValue&>(*elements[0]).getName())) {
+        return !mentions(expr, name);
+    }
+    return all(0, elements.size(), false);
+}
+
+// 以循环方式执行命名 let 的过程体：尾位置上对循环名的调用不递归，
+// 而是把实参的值写入 next，由调用方原地更新循环变量后进入下一轮。每一轮都会执行，直接沿序对访问各部分
+class LoopBody {
+public:
+    LoopBody(EvalEnv& env, const std::string& name, std::vector<ValuePtr>& next) : env(env), name(name), next(next) {}
+
+    // 尾调用循环名时返回 nullptr；续延逃逸时返回 LISP_ESCAPE
+    ValuePtr evalTail(const ValuePtr& expr) {
+        if (!expr->isPair()) {
+            return env.evalOrEscape(expr);
+        }
+        auto& form = static_cast<PairValue&>(*expr);
+        if (typeid(*form.l) != typeid(SymbolValue)) {
+            return env.evalOrEscape(expr);
+        }
+        const std::string& op = static_cast<SymbolValue&>(*form.l).getName();
+        const PairValue* args = form.r->isPair() ? &static_cast<PairValue&>(*form.r) : nullptr;
+        if (op == name) {
+            size_t i = 0;
+            for (; args; args = next_pair(*args)) {
+                next[i] = env.evalOrEscape(args->l);
+                if (next[i++] == LISP_ESCAPE) {
+                    return LISP_ESCAPE;
+                }
+            }
+            return nullptr;
+        }
+        if (op == "if" && args && args->r->isPair()) {
+            const PairValue* branches = &static_cast<PairValue&>(*args->r);
+            const PairValue* alternative = next_pair(*branches);
+            if (alternative && !alternative->r->isNil()) {
+                return env.evalOrEscape(expr);  // 形式不对，由 ifForm 报错
+            }
+            ValuePtr condition = env.evalOrEscape(args->l);
+            if (condition == LISP_ESCAPE) {
+                return condition;
+            }
+            if (!condition->isLispFalse()) {
+                return evalTail(branches->l);
+            }
+            return alternative ? evalTail(alternative->l) : std::make_shared<NilValue>();
+        }
+        if (op == "begin" && args) {
+            for (; next_pair(*args); args = next_pair(*args)) {
+                if (env.evalOrEscape(args->l) == LISP_ESCAPE) {
+                    return LISP_ESCAPE;
+                }
+            }
+            return evalTail(args->l);
+        }
+        if ((op == "and" || op == "or") && args) {
+            bool is_and = op == "and";
+            for (; next_pair(*args); args = next_pair(*args)) {
+                ValuePtr value = env.evalOrEscape(args->l);
+                if (value == LISP_ESCAPE) {
+                    return value;
+                }
+                if (value->isLispFalse() == is_and) {
+                    return is_and ? LISP_FALSE : value;
+                }
+            }
+            ValuePtr last = evalTail(args->l);
+            return last && last->isLispFalse() ? LISP_FALSE : last;
+        }
+        if (op == "cond" && args) {
+            // 与 condForm 相同的规则，只是子句的最后一个表达式按尾位置求值
+            std::vector<ValuePtr> clauses = form.r->toVector();
+            for (size_t i = 0; i < clauses.size(); ++i) {
+                std::vector<ValuePtr> clause = clauses[i]->toVector();
+                if (clause.empty()) {
+                    throw LispError("Invalid Cond.");
+                }
+                bool is_else = clause[0]->toString() == "else";
+                if (is_else && i + 1 != clauses.size()) {
+                    throw LispError("Invalid Cond : else error.");
+                }
+                if (clause.size() == 1) {
+                    return env.evalOrEscape(clause[0]);
+                }
+                ValuePtr test = is_else ? LISP_TRUE : env.evalOrEscape(clause[0]);
+                if (test == LISP_ESCAPE) {
+                    return test;
+                }
+                if (!test->isLispFalse()) {
+                    for (size_t j = 1; j + 1 < clause.size(); ++j) {
+                        if (env.evalOrEscape(clause[j]) == LISP_ESCAPE) {
+                            return LISP_ESCAPE;
+                        }
+                    }
+                    return evalTail(clause.back());
+                }
+            }
+            return clauses[0];
+        }
+        return env.evalOrEscape(expr);
+    }
+
+private:
+    EvalEnv& env;
+    const std::string& name;
+    std::vector<ValuePtr>& next;
+
+    static const PairValue* next_pair(const PairValue& pair) {
+        return pair.r->isPair() ? &static_cast<PairValue&>(*pair.r) : nullptr;
+    }
+};
+
+// 解析 ((var init) ...) 或 do 的 ((var init step) ...)，在 env 中求值各个初值
+void parseLoopBindings(const ValuePtr& bindings, const char* form, bool with_step, EvalEnv& env,
+                       std::vector<std::string>& names, std::vector<ValuePtr>& values, std::vector<ValuePtr>* steps) {
+    if (!bindings->isList() && !bindings->isNil()) {
+        throw LispError(std::string(form) + ": bindings must be a list. Got: " + bindings->toString());
+    }
+    if (bindings->isNil()) {
+        return;
+    }
+    for (const auto& binding : bindings->toVector()) {
+        std::vector<ValuePtr> parts = binding->isList() ? binding->toVector() : std::vector<ValuePtr>{};
+        if (parts.size() != 2 && !(with_step && parts.size() == 3)) {
+            throw LispError(std::string(form) + ": malformed binding " + binding->toString());
+        }
+        if (!parts[0]->isSymbol()) {
+            throw LispError(std::string(form) + ": variable name in binding must be a symbol. Got: " + parts[0]->toString());
+        }
+        names.push_back(*parts[0]->asSymbol());
+        values.push_back(env.eval(parts[1]));
+        if (steps) {
+            steps->push_back(parts.size() == 3 ? parts[2] : nullptr);
+        }
+    }
+}
+
+// (let name ((var init) ...) body ...)。name 只在尾位置被调用、过程体不会让帧逃逸时，
+// 整个循环只用一个帧，每一轮原地更新循环变量；否则按定义一个局部过程再调用它的方式执行。
+ValuePtr namedLetForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() < 3) {
+        throw LispError("let: named let requires a name, bindings and at least one body expression.");
+    }
+    std::string name = *args[0]->asSymbol();
+    std::vector<std::string> names;
+    std::vector<ValuePtr> values;
+    parseLoopBindings(args[1], "let", false, env, names, values, nullptr);
+    std::vector<ValuePtr> body(args.begin() + 2, args.end());
+
+    // 被闭包捕获后又被 set! 修改的循环变量需要装箱，按过程调用的方式执行
+    bool iterative = internal_definitions(body).empty();
+    for (size_t i = 0; iterative && i < body.size(); ++i) {
+        iterative = onlyTailCalls(body[i], name, names.size(), i + 1 == body.size());
+    }
+    auto loop_env = std::make_shared<EvalEnv>(env.shared_from_this());
+    for (size_t i = 0; i < names.size(); ++i) {
+        loop_env->defineBinding(names[i], values[i]);
+    }
+    if (iterative && !frame_may_escape(body, *loop_env) && assigned_captures(names, body, *loop_env).empty()) {
+        // 初值已在帧中，不再另外保留（如流的头部）；绑定表的结点地址不变，每一轮直接改写其中的值
+        values.clear();
+        std::vector<ValuePtr*> slots;
+        for (const auto& var : names) {
+            slots.push_back(&loop_env->symbol_map.find(var)->second);
+        }
+        std::vector<ValuePtr> next(names.size());
+        LoopBody loop(*loop_env, name, next);
+        while (true) {
+            for (size_t i = 0; i + 1 < body.size(); ++i) {
+                if (loop_env->evalOrEscape(body[i]) == LISP_ESCAPE) {
+                    return LISP_ESCAPE;
+                }
+            }
+            if (ValuePtr result = loop.evalTail(body.back())) {
+                return result;
+            }
+            for (size_t i = 0; i < slots.size(); ++i) {
+                *slots[i] = std::move(next[i]);
+            }
+        }
+    }
+    auto proc_env = std::make_shared<EvalEnv>(env.shared_from_this());
+    proc_env->boxBinding(name);
+    auto proc = make_lambda(name, names, body, proc_env);
+    proc_env->defineBinding(name, proc);
+    return proc_env->applyOrEscape(proc, values);
+}
+
+// 在 let 一类形式新建的帧 let_env（已绑定 names）中求值 body。与过程体相同：内部定义预先装箱，
+// 使先创建的闭包也能引用后定义的名字；被闭包捕获后又被 set! 修改的变量也装箱
+ValuePtr evalScopeBody(EvalEnv& let_env, const std::vector<std::string>& names, const std::vector<ValuePtr>& body) {
+    for (const auto& name : internal_definitions(body)) {
+        let_env.boxBinding(name);
+    }
+    if (!names.empty()) {
+        for (const auto& name : assigned_captures(names, body, let_env)) {
+            let_env.boxBinding(name);
+        }
+    }
+    ValuePtr result = LISP_NIL;
+    for (size_t i = 0; i < body.size() && result != LISP_ESCAPE; ++i) {
+        result = let_env.evalOrEscape(body[i]);
+    }
+    return result;
+}
+
+}  // namespace
+
+ValuePtr doForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() < 2 || !args[1]->isPair()) {
+        throw LispError("do: expects (do ((var init step) ...) (test expr ...) body ...)");
+    }
+    std::vector<std::string> names;
+    std::vector<ValuePtr> values;
+    std::vector<ValuePtr> steps;
+    parseLoopBindings(args[0], "do", true, env, names, values, &steps);
+    std::vector<ValuePtr> exit_clause = args[1]->toVector();
+    std::vector<ValuePtr> body(args.begin() + 2, args.end());
+
+    // 帧不会逃逸时各轮共用一个帧，原地更新变量；否则每一轮使用新的帧，先前创建的闭包看到的绑定不受影响。
+    // 被闭包捕获后又被 set! 修改的变量在每一轮的帧中装箱
+    std::vector<ValuePtr> analyzed(body);
+    analyzed.insert(analyzed.end(), exit_clause.begin(), exit_clause.end());
+    for (const auto& step : steps) {
+        if (step) {
+            analyzed.push_back(step);
+        }
+    }
+    auto loop_env = std::make_shared<EvalEnv>(env.shared_from_this());
+    for (size_t i = 0; i < names.size(); ++i) {
+        loop_env->defineBinding(names[i], std::move(values[i]));  // 不在这里保留初值（如流的头部）
+    }
+    std::vector<std::string> boxed = assigned_captures(names, analyzed, *loop_env);
+    for (const auto& name : boxed) {
+        loop_env->boxBinding(name);
+    }
+    bool reuse_frame =
+        boxed.empty() && internal_definitions(body).empty() && !frame_may_escape(analyzed, *loop_env);
+    std::vector<ValuePtr*> slots(names.size());
+    auto find_slots = [&] {
+        for (size_t i = 0; i < names.size(); ++i) {
+            slots[i] = &loop_env->symbol_map.find(names[i])->second;
+        }
+    };
+    auto current = [&](size_t i) {
+        const ValuePtr& slot = *slots[i];
+        return typeid(*slot) == typeid(BoxValue) ? static_cast<BoxValue&>(*slot).value : slot;
+    };
+    find_slots();
+    std::vector<ValuePtr> next(names.size());
+    while (true) {
+        ValuePtr done = loop_env->evalOrEscape(exit_clause[0]);
+        if (done == LISP_ESCAPE) {
+            return done;
+        }
+        if (!done->isLispFalse()) {
+            break;
+        }
+        for (const auto& expr : body) {
+            if (loop_env->evalOrEscape(expr) == LISP_ESCAPE) {
+                return LISP_ESCAPE;
+            }
+        }
+        for (size_t i = 0; i < names.size(); ++i) {
+            next[i] = steps[i] ? loop_env->evalOrEscape(steps[i]) : current(i);
+            if (next[i] == LISP_ESCAPE) {
+                return LISP_ESCAPE;
+            }
+        }
+        if (reuse_frame) {
+            for (size_t i = 0; i < names.size(); ++i) {
+                *slots[i] = std::move(next[i]);
+            }
+        } else {
+            loop_env = std::make_shared<EvalEnv>(env.shared_from_this());
+            for (const auto& name : boxed) {
+                loop_env->boxBinding(name);
+            }
+            for (size_t i = 0; i < names.size(); ++i) {
+                loop_env->defineBinding(names[i], std::move(next[i]));
+            }
+            find_slots();
+        }
+    }
+    ValuePtr result = LISP_NIL;
+    for (size_t i = 1; i < exit_clause.size() && result != LISP_ESCAPE; ++i) {
+        result = loop_env->evalOrEscape(exit_clause[i]);
+    }
+    return result;
 }
 
 ValuePtr letForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (!args.empty() && args[0]->isSymbol()) {
+        return namedLetForm(args, env);
+    }
     if (args.size() < 2) {
         throw LispError("let: requires bindings and at least one body expression.");
     }
@@ -150,18 +527,235 @@ ValuePtr letForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
                 throw LispError("let: variable name in binding must be a symbol. Got: " + var_symbol_ptr->toString());
             }
             auto var_name_opt = var_symbol_ptr->asSymbol();
-            ValuePtr evaluated_val = env.eval(val_expr_ptr);
+            ValuePtr evaluated_val = env.evalOrEscape(val_expr_ptr);
+            if (evaluated_val == LISP_ESCAPE) {
+                return evaluated_val;
+            }
             evaluated_bindings_for_let_env.push_back({*var_name_opt, evaluated_val});
         }
     }
+    std::vector<std::string> names;
     for (const auto& eb : evaluated_bindings_for_let_env) {
         let_env->defineBinding(eb.first, eb.second);
+        names.push_back(eb.first);
+    }
+    return evalScopeBody(*let_env, names, {args.begin() + 1, args.end()});
+}
+
+namespace {
+
+// 按 formals 把 produced（values 的结果或单个值）绑定到 frame 中并记下名字。
+// formals 为符号时绑定全部值组成的表，否则为符号的表，个数必须与值的个数相同
+void bindValues(const char* form, const ValuePtr& formals, const ValuePtr& produced, EvalEnv& frame,
+                std::vector<std::string>& names) {
+    const MultipleValuesValue* values = typeid(*produced) == typeid(MultipleValuesValue)
+                                            ? &static_cast<MultipleValuesValue&>(*produced)
+                                            : nullptr;
+    size_t count = values ? values->size() : 1;
+    auto value_at = [&](size_t i) -> const ValuePtr& { return values ? (*values)[i] : produced; };
+    if (formals->isSymbol()) {
+        std::vector<ValuePtr> all;
+        for (size_t i = 0; i < count; ++i) {
+            all.push_back(value_at(i));
+        }
+        names.push_back(*formals->asSymbol());
+        frame.defineBinding(names.back(), toList(all));
+    } else {
+        std::vector<std::string> formal_names = get_parameter_names(formals);
+        if (formal_names.size() != count) {
+            throw LispError(std::string(form) + ": expected " + std::to_string(formal_names.size()) +
+                            " values, got " + std::to_string(count) + ".");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            frame.defineBinding(formal_names[i], value_at(i));
+            names.push_back(std::move(formal_names[i]));
+        }
     }
-    ValuePtr result = LISP_NIL; 
-    for (size_t i = 1; i < args.size(); ++i) { 
-        result = let_env->eval(args[i]);
+    finish_values(produced);
+}
+
+ValuePtr letValues(const std::vector<ValuePtr>& args, EvalEnv& env, bool sequential) {
+    const char* form = sequential ? "let*-values" : "let-values";
+    if (args.size() < 2 || (!args[0]->isList() && !args[0]->isNil())) {
+        throw LispError(std::string(form) + ": expects (" + form + " ((formals expr) ...) body ...)");
     }
-    return result;
+    auto let_env = std::make_shared<EvalEnv>(env.shared_from_this());
+    std::vector<std::string> names;
+    for (const auto& binding : args[0]->isNil() ? std::vector<ValuePtr>{} : args[0]->toVector()) {
+        std::vector<ValuePtr> parts = binding->isList() ? binding->toVector() : std::vector<ValuePtr>{};
+        if (parts.size() != 2) {
+            throw LispError(std::string(form) + ": malformed binding " + brief_repr(*binding));
+        }
+        // let*-values 的每个表达式都能看到之前的绑定
+        ValuePtr produced = sequential ? let_env->evalOrEscape(parts[1]) : env.evalOrEscape(parts[1]);
+        if (produced == LISP_ESCAPE) {
+            return produced;
+        }
+        bindValues(form, parts[0], produced, *let_env, names);
+    }
+    return evalScopeBody(*let_env, names, {args.begin() + 1, args.end()});
+}
+
+}  // namespace
+
+ValuePtr letValuesForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    return letValues(args, env, false);
+}
+
+ValuePtr letStarValuesForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    return letValues(args, env, true);
+}
+
+ValuePtr receiveForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() < 3) {
+        throw LispError("receive: expects (receive formals expr body ...)");
+    }
+    ValuePtr produced = env.evalOrEscape(args[1]);
+    if (produced == LISP_ESCAPE) {
+        return produced;
+    }
+    auto let_env = std::make_shared<EvalEnv>(env.shared_from_this());
+    std::vector<std::string> names;
+    bindValues("receive", args[0], produced, *let_env, names);
+    return evalScopeBody(*let_env, names, {args.begin() + 2, args.end()});
+}
+
+namespace {
+
+ValuePtr makePromise(const ValuePtr& expr, EvalEnv& env, bool delay_force) {
+    auto state = std::make_shared<PromiseState>();
+    state->delay_force = delay_force;
+    state->expr = expr;
+    state->env = env.shared_from_this();
+    return std::make_shared<PromiseValue>(std::move(state));
+}
+
+}  // namespace
+
+ValuePtr delayForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() != 1) {
+        throw LispError("delay: expects (delay expr)");
+    }
+    return makePromise(args[0], env, false);
+}
+
+ValuePtr delayForceForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() != 1) {
+        throw LispError("delay-force: expects (delay-force expr)");
+    }
+    return makePromise(args[0], env, true);
+}
+
+ValuePtr consStreamForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() != 2) {
+        throw LispError("cons-stream: expects (cons-stream a b)");
+    }
+    ValuePtr head = env.evalOrEscape(args[0]);
+    if (head == LISP_ESCAPE) {
+        return head;
+    }
+    return std::make_shared<PairValue>(std::move(head), makePromise(args[1], env, false));
+}
+
+ValuePtr setForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() != 2) {
+        throw LispError("set!: expects (set! variable value)");
+    }
+    if (typeid(*args[0]) == typeid(GlobalRefValue)) {
+        // 优化后已绑定到全局绑定格的目标
+        auto& ref = static_cast<GlobalRefValue&>(*args[0]);
+        if (!ref.cell->value) {
+            throw LispError("set!: variable " + ref.symbol->toString() + " not defined.");
+        }
+        ValuePtr value = env.evalOrEscape(args[1]);
+        if (value == LISP_ESCAPE) {
+            return value;
+        }
+        ref.cell->value = value;
+        note_assignment(static_cast<SymbolValue&>(*ref.symbol).getName(), value);
+        return LISP_NIL;
+    }
+    if (!args[0]->isSymbol()) {
+        throw LispError("set!: variable name must be a symbol. Got: " + args[0]->toString());
+    }
+    const std::string& name = static_cast<SymbolValue&>(*args[0]).getName();
+    ValuePtr value = env.evalOrEscape(args[1]);
+    if (value == LISP_ESCAPE) {
+        return value;
+    }
+    if (env.assignBinding(name, value)) {
+        note_assignment(name, value);
+    }
+    return LISP_NIL;
+}
+
+// (guard (var clause ...) body ...)：body 中引发的条件对象绑定到 var 后按 cond 的规则选择子句，
+// 没有子句匹配时在外层重新引发。raise 与 error 经处理器栈以续延逃逸的方式直接回到这里
+ValuePtr guardForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() < 2 || !args[0]->isPair() || !static_cast<PairValue&>(*args[0]).l->isSymbol()) {
+        throw LispError("guard: expects (guard (variable clause ...) body ...)");
+    }
+    // 只用作逃逸的目标，不会交给 Lisp 代码
+    ContinuationValue target(nullptr);
+    HandlerFrame frame{current_handlers, nullptr, &target};
+    ValuePtr condition;
+    try {
+        HandlerScope scope(&frame);
+        ValuePtr result;
+        for (size_t i = 1; i < args.size(); ++i) {
+            result = env.evalOrEscape(args[i]);
+            if (result == LISP_ESCAPE) {
+                break;
+            }
+        }
+        if (result != LISP_ESCAPE || pending_escape().target != &target) {
+            return result;
+        }
+        condition = std::exchange(pending_escape(), ContinuationJump{nullptr, nullptr}).value;
+    } catch (const ContinuationJump& jump) {
+        if (jump.target != &target) {
+            throw;
+        }
+        condition = jump.value;
+    } catch (const UnhandledCondition&) {
+        throw;
+    } catch (const std::runtime_error& error) {
+        condition = error_condition(error);
+    }
+    auto& spec = static_cast<PairValue&>(*args[0]);
+    auto clause_env = std::make_shared<EvalEnv>(env.shared_from_this());
+    clause_env->defineBinding(static_cast<SymbolValue&>(*spec.l).getName(), condition);
+    // 子句直接沿表结构遍历，不复制成 vector：每次捕获都要走一遍
+    for (Value* clauses = spec.r.get(); clauses->isPair();
+         clauses = static_cast<PairValue*>(clauses)->r.get()) {
+        const ValuePtr& clause = static_cast<PairValue*>(clauses)->l;
+        if (!clause->isPair()) {
+            throw LispError("guard: invalid clause " + brief_repr(*clause));
+        }
+        auto& head = static_cast<PairValue&>(*clause);
+        bool is_else = head.l->isSymbol() && static_cast<SymbolValue&>(*head.l).getName() == "else";
+        if (is_else && static_cast<PairValue*>(clauses)->r->isPair()) {
+            throw LispError("guard: else must be the last clause.");
+        }
+        ValuePtr test = is_else ? LISP_TRUE : clause_env->evalOrEscape(head.l);
+        if (test == LISP_ESCAPE) {
+            return test;
+        }
+        if (test->isLispFalse()) {
+            continue;
+        }
+        if (!head.r->isPair()) {
+            return test;
+        }
+        PairValue* body = static_cast<PairValue*>(head.r.get());
+        for (; body->r->isPair(); body = static_cast<PairValue*>(body->r.get())) {
+            if (clause_env->evalOrEscape(body->l) == LISP_ESCAPE) {
+                return LISP_ESCAPE;
+            }
+        }
+        return clause_env->evalOrEscape(body->l);
+    }
+    return raise_condition(env, condition, true);
 }
 
 ValuePtr quoteForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
@@ -178,20 +772,52 @@ ValuePtr quasiquoteForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     return env.expandQuasiquote(args[0]);
 }
 
+TemplateKeyword template_keyword(const ValuePtr& tmpl) {
+    if (!tmpl->isPair()) {
+        return TemplateKeyword::NONE;
+    }
+    const ValuePtr& head = static_cast<PairValue&>(*tmpl).l;
+    if (typeid(*head) != typeid(SymbolValue)) {
+        return TemplateKeyword::NONE;
+    }
+    const std::string& name = static_cast<SymbolValue&>(*head).getName();
+    if (name == "unquote") {
+        return TemplateKeyword::UNQUOTE;
+    }
+    if (name == "unquote-splicing") {
+        return TemplateKeyword::UNQUOTE_SPLICING;
+    }
+    if (name == "quasiquote") {
+        return TemplateKeyword::QUASIQUOTE;
+    }
+    return TemplateKeyword::NONE;
+}
+
+ValuePtr template_operand(const ValuePtr& form) {
+    auto& pair = static_cast<PairValue&>(*form);
+    if (!pair.r->isPair() || !static_cast<PairValue&>(*pair.r).r->isNil()) {
+        throw LispError(*pair.l->asSymbol() + ": expects exactly one argument");
+    }
+    return static_cast<PairValue&>(*pair.r).l;
+}
+
 ValuePtr ifForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     if (args.size() != 2 && args.size() != 3) {
         throw LispError("if: bad syntax. Expected (if condition then-expr [else-expr])");
     }
     
     ValuePtr condition_expression = args[0];
-    ValuePtr condition_result = env.eval(condition_expression);
+    ValuePtr condition_result = env.evalOrEscape(condition_expression);
+    if (condition_result == LISP_ESCAPE) {
+        return condition_result;
+    }
     if (!condition_result->isLispFalse()) {
         ValuePtr then_branch = args[1];
-        return env.eval(then_branch);
+        return env.evalOrEscape(then_branch);
     } else {
         if (args.size() == 3) {
             ValuePtr else_branch = args[2];
-            return env.eval(else_branch);
+            return env.evalOrEscape(else_branch);
         } else {
             return std::make_shared<NilValue>(); 
         }
@@ -204,7 +830,10 @@ ValuePtr andForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     }
     ValuePtr last_eval_result = nullptr; 
     for (const auto& expr : args) { 
-        last_eval_result = env.eval(expr);
+        last_eval_result = env.evalOrEscape(expr);
+        if (last_eval_result == LISP_ESCAPE) {
+            return last_eval_result;
+        }
         if (last_eval_result->isLispFalse()) {
             return LISP_FALSE;
         }
@@ -215,7 +844,10 @@ ValuePtr andForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
 ValuePtr orForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     for(auto i : args){
         ValuePtr branch = i;
-        auto judge_env = env.eval(branch);
+        auto judge_env = env.evalOrEscape(branch);
+        if (judge_env == LISP_ESCAPE) {
+            return judge_env;
+        }
         auto judge = (!judge_env->isLispFalse())?LISP_TRUE:LISP_FALSE;
         if(judge->getboolValue()){
             return judge_env;
@@ -239,7 +871,7 @@ ValuePtr lambdaForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     if (body_expressions.empty()){
         throw LispError("Lambda body cannot be empty.");
     }
-    return std::make_shared<LambdaValue>("<lambda>", param_names_vec, body_expressions, env.shared_from_this());
+    return make_lambda("<lambda>", param_names_vec, body_expressions, env.shared_from_this());
 }
 
 ValuePtr defineMacroForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
@@ -254,20 +886,42 @@ ValuePtr defineMacroForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
     // 宏体
     ValuePtr body = args[2];
     auto macro = std::make_shared<MacroValue>(param_names, body);
+    note_definition(name_sym->toString(), macro);
     env.defineBinding(name_sym->toString(), macro);
     return macro;
 }
 
+ValuePtr defineSyntaxForm(const std::vector<ValuePtr>& args, EvalEnv& env) {
+    if (args.size() != 2 || !args[0]->isSymbol()) {
+        throw LispError("define-syntax: expects (define-syntax name (syntax-rules (literal ...) rule ...))");
+    }
+    std::string name = *args[0]->asSymbol();
+    auto macro = std::make_shared<SyntaxRulesValue>(std::make_shared<const SyntaxRules>(name, args[1]));
+    note_definition(name, macro);
+    env.defineBinding(name, macro);
+    return macro;
+}
+
 const std::unordered_map<std::string, SpecialFormType*> SPECIAL_FORMS{
     {"cond", condForm},
     {"begin", beginForm},
     {"let", letForm},
+    {"do", doForm},
     {"define", defineForm}, 
+    {"set!", setForm},
+    {"guard", guardForm},
+    {"let-values", letValuesForm},
+    {"let*-values", letStarValuesForm},
+    {"receive", receiveForm},
+    {"delay", delayForm},
+    {"delay-force", delayForceForm},
+    {"cons-stream", consStreamForm},
     {"quote",  quoteForm},
     {"quasiquote",  quasiquoteForm},
     {"if", ifForm},
     {"and", andForm},
     {"or", orForm},
     {"lambda",lambdaForm},
-    {"define-macro", defineMacroForm}
+    {"define-macro", defineMacroForm},
+    {"define-syntax", defineSyntaxForm}
 };
\ No newline at end of file
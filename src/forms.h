@@ -12,10 +12,20 @@ class EvalEnv;
 using SpecialFormType = ValuePtr(const std::vector<ValuePtr>& args, EvalEnv& env);
 
 extern const std::unordered_map<std::string, SpecialFormType*> SPECIAL_FORMS;
+std::vector<std::string> get_parameter_names(ValuePtr param_list_node);
 ValuePtr beginForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr condForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr defineForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr setForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr guardForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr letForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr doForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr letValuesForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr letStarValuesForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr receiveForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr delayForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr delayForceForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr consStreamForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr quoteForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr quasiquoteForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr unquoteForm(const std::vector<ValuePtr>& args, EvalEnv& env);
@@ -24,4 +34,11 @@ ValuePtr andForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr orForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr lambdaForm(const std::vector<ValuePtr>& args, EvalEnv& env);
 ValuePtr defineMacroForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr defineSyntaxForm(const std::vector<ValuePtr>& args, EvalEnv& env);
+
+// quasiquote 模板中有特殊含义的形式 (quasiquote x)、(unquote x) 与 (unquote-splicing x)
+enum class TemplateKeyword { NONE, QUASIQUOTE, UNQUOTE, UNQUOTE_SPLICING };
+TemplateKeyword template_keyword(const ValuePtr& tmpl);
+// 上述形式的操作数，操作数不是恰好一个时报错
+ValuePtr template_operand(const ValuePtr& form);
 #endif 
\ No newline at end of file
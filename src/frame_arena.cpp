@@ -0,0 +1,67 @@
+#include "frame_arena.h"
+
+#include <new>
+
+#include "eval_env.h"
+
+FrameArena& FrameArena::current() {
+    thread_local FrameArena arena;
+    return arena;
+}
+
+FrameArena::~FrameArena() {
+    if (!blocks.empty()) {
+        // 仍有帧被保留（例如被其他线程中的闭包引用），不能归还这些内存
+        for (auto& chunk : chunks) {
+            chunk.data.release();
+        }
+    }
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    if (alignment > alignof(std::max_align_t)) {
+        throw std::bad_alloc();
+    }
+    size_t need = HEADER_SIZE + (bytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) *
+                                    alignof(std::max_align_t);
+    while (current_chunk < chunks.size() && chunks[current_chunk].used + need > chunks[current_chunk].size) {
+        ++current_chunk;
+    }
+    if (current_chunk == chunks.size()) {
+        size_t size = std::max(CHUNK_SIZE, need);
+        chunks.push_back({std::make_unique<std::byte[]>(size), size, 0});
+    }
+    Chunk& chunk = chunks[current_chunk];
+    auto* header = new (chunk.data.get() + chunk.used) Header{current_chunk, chunk.used, {false}};
+    chunk.used += need;
+    blocks.push_back(header);
+    return reinterpret_cast<std::byte*>(header) + HEADER_SIZE;
+}
+
+void FrameArena::do_deallocate(void* p, size_t, size_t) {
+    auto* header = reinterpret_cast<Header*>(static_cast<std::byte*>(p) - HEADER_SIZE);
+    header->freed.store(true, std::memory_order_release);
+    // 只有所属线程回收内存；其他线程释放的块留待所属线程下次释放时一并回收
+    if (&current() == this) {
+        popFreed();
+    }
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void FrameArena::popFreed() {
+    while (!blocks.empty() && blocks.back()->freed.load(std::memory_order_acquire)) {
+        Header* header = blocks.back();
+        blocks.pop_back();
+        chunks[header->chunk].used = header->offset;
+        current_chunk = header->chunk;
+        header->~Header();
+    }
+}
+
+std::shared_ptr<EvalEnv> make_stack_frame(const std::shared_ptr<EvalEnv>& parent) {
+    FrameArena& arena = FrameArena::current();
+    return std::allocate_shared<EvalEnv>(std::pmr::polymorphic_allocator<EvalEnv>(&arena), parent, &arena);
+}
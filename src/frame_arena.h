@@ -0,0 +1,52 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+class EvalEnv;
+
+// 每个线程一块按栈的方式使用的内存，存放不会逃逸的过程调用帧（EvalEnv 及其绑定表的结点）。
+// 分配只需移动栈顶；释放时若位于栈顶则立即回收，否则先做标记，等上方的块都释放后一并回收。
+// 因此即使释放顺序与分配顺序不同（协程交替执行、帧意外被保留）也是安全的，只是回收会推迟。
+class FrameArena : public std::pmr::memory_resource {
+public:
+    static FrameArena& current();
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    ~FrameArena() override;
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+        size_t used;
+    };
+    struct Header {
+        size_t chunk;
+        size_t offset;
+        std::atomic<bool> freed;
+    };
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    static constexpr size_t HEADER_SIZE =
+        (sizeof(Header) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    std::vector<Chunk> chunks;
+    size_t current_chunk = 0;
+    std::vector<Header*> blocks;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    void popFreed();
+};
+
+// 在当前线程的 FrameArena 中创建调用帧
+std::shared_ptr<EvalEnv> make_stack_frame(const std::shared_ptr<EvalEnv>& parent);
+
+#endif
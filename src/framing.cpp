@@ -0,0 +1,123 @@
+#include "framing.h"
+
+#include <cerrno>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+bool readExact(int fd, char* data, size_t size) {
+    while (size > 0) {
+        auto n = ::read(fd, data, static_cast<unsigned>(size));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeExact(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        auto n = ::write(fd, data, static_cast<unsigned>(size));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void appendFrame(std::string& out, const std::string& payload) {
+    auto length = static_cast<uint32_t>(payload.size());
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((length >> shift) & 0xff));
+    }
+    out += payload;
+}
+
+uint32_t frameLength(const unsigned char* header) {
+    return (uint32_t{header[0]} << 24) | (uint32_t{header[1]} << 16) | (uint32_t{header[2]} << 8) |
+           uint32_t{header[3]};
+}
+
+}  // namespace
+
+bool readFrame(int fd, std::string& payload) {
+    unsigned char header[4];
+    if (!readExact(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    uint32_t length = frameLength(header);
+    if (length > MAX_FRAME_SIZE) {
+        return false;
+    }
+    payload.resize(length);
+    return readExact(fd, payload.data(), length);
+}
+
+FrameStatus frameStatus(const std::string& buffer, size_t offset) {
+    if (buffer.size() - offset < 4) {
+        return FrameStatus::Incomplete;
+    }
+    uint32_t length = frameLength(reinterpret_cast<const unsigned char*>(buffer.data() + offset));
+    if (length > MAX_FRAME_SIZE) {
+        return FrameStatus::Invalid;
+    }
+    return buffer.size() - offset - 4 < length ? FrameStatus::Incomplete : FrameStatus::Complete;
+}
+
+FrameStatus parseFrame(const std::string& buffer, size_t& offset, std::string& payload) {
+    FrameStatus status = frameStatus(buffer, offset);
+    if (status == FrameStatus::Complete) {
+        uint32_t length = frameLength(reinterpret_cast<const unsigned char*>(buffer.data() + offset));
+        payload.assign(buffer, offset + 4, length);
+        offset += 4 + length;
+    }
+    return status;
+}
+
+bool writeFrame(int fd, const std::string& payload) {
+    std::string frame;
+    frame.reserve(4 + payload.size());
+    appendFrame(frame, payload);
+    return writeExact(fd, frame.data(), frame.size());
+}
+
+bool readResult(int fd, RunResult& result) {
+    char status;
+    if (!readExact(fd, &status, 1)) {
+        return false;
+    }
+    result.ok = status == 0;
+    return readFrame(fd, result.output) && readFrame(fd, result.value);
+}
+
+bool writeResult(int fd, const RunResult& result) {
+    std::string frame = encodeResult(result);
+    return writeExact(fd, frame.data(), frame.size());
+}
+
+std::string encodeResult(const RunResult& result) {
+    std::string frame;
+    frame.reserve(9 + result.output.size() + result.value.size());
+    frame.push_back(result.ok ? 0 : 1);
+    appendFrame(frame, result.output);
+    appendFrame(frame, result.value);
+    return frame;
+}
@@ -0,0 +1,26 @@
+#ifndef FRAMING_H
+#define FRAMING_H
+
+#include <string>
+
+#include "runner.h"
+
+// 基于文件描述符的简单帧协议，供服务模式与工作进程池共用。
+// 帧：4 字节大端长度 + 内容
+
+bool readFrame(int fd, std::string& payload);
+bool writeFrame(int fd, const std::string& payload);
+
+// 从已收到的字节中解析帧（用于非阻塞的连接）。frameStatus 只检查 buffer 中 offset 处的帧是否已经完整；
+// parseFrame 在帧完整时取出内容并前移 offset
+enum class FrameStatus { Complete, Incomplete, Invalid };
+FrameStatus frameStatus(const std::string& buffer, size_t offset);
+FrameStatus parseFrame(const std::string& buffer, size_t& offset, std::string& payload);
+
+// 求值结果：1 字节状态（0 成功，1 出错）+ 输出帧 + 值/错误信息帧
+bool readResult(int fd, RunResult& result);
+bool writeResult(int fd, const RunResult& result);
+// writeResult 写出的字节
+std::string encodeResult(const RunResult& result);
+
+#endif
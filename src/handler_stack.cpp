@@ -0,0 +1,52 @@
+#include "handler_stack.h"
+
+#include "error.h"
+#include "eval_env.h"
+
+thread_local HandlerFrame* current_handlers = nullptr;
+
+namespace {
+
+std::string uncaught_message(const ValuePtr& condition) {
+    if (typeid(*condition) == typeid(ErrorObjectValue)) {
+        return static_cast<ErrorObjectValue&>(*condition).describe();
+    }
+    return "Uncaught exception: " + brief_repr(*condition);
+}
+
+}  // namespace
+
+ValuePtr raise_condition(EvalEnv& env, ValuePtr condition, bool continuable, HandlerFrame* frame) {
+    while (frame && !frame->handler && !frame->guard) {
+        frame = frame->outer;
+    }
+    if (!frame) {
+        // 格式化推迟到确实没有处理器、要作为错误报告时
+        throw UnhandledCondition(uncaught_message(condition));
+    }
+    if (frame->guard) {
+        pending_escape() = ContinuationJump{frame->guard, std::move(condition)};
+        return LISP_ESCAPE;
+    }
+    HandlerScope outer(frame->outer);
+    ValuePtr result;
+    try {
+        result = env.applyOrEscape(frame->handler, {condition});
+    } catch (const UnhandledCondition&) {
+        throw;
+    } catch (const std::runtime_error& error) {
+        // 处理过程中的错误属于外层的处理器，不能让原生栈上更内层的 guard、with-exception-handler 捕获
+        return raise_condition(env, error_condition(error), false);
+    }
+    if (continuable || result == LISP_ESCAPE) {
+        return result;
+    }
+    return raise_condition(env,
+                           std::make_shared<ErrorObjectValue>("handler returned from non-continuable exception:",
+                                                              std::make_shared<PairValue>(condition, LISP_NIL)),
+                           false);
+}
+
+ValuePtr error_condition(const std::exception& error) {
+    return std::make_shared<ErrorObjectValue>(error.what(), LISP_NIL);
+}
@@ -0,0 +1,45 @@
+#ifndef HANDLER_STACK_H
+#define HANDLER_STACK_H
+
+#include <exception>
+
+#include "value.h"
+
+class EvalEnv;
+class ContinuationValue;
+
+// 异常处理器栈。guard 与 with-exception-handler 在自己的原生栈帧中建立一层，经 outer 连成链，
+// raise 直接找到最内层的一层：guard 以续延逃逸的方式（LISP_ESCAPE）接收条件对象，沿途不经 C++ 异常；
+// with-exception-handler 的处理过程在 raise 处调用。协程任务各有自己的处理器栈，由调度器在切换时保存与恢复
+// 两者都没有的一层只把条件交给 outer（生成器中处理器栈的底层，见 iterator.h）
+struct HandlerFrame {
+    HandlerFrame* outer;
+    ValuePtr handler;                          // with-exception-handler 的处理过程
+    const ContinuationValue* guard = nullptr;  // guard 建立的一层：条件对象经它逃逸到 guard
+};
+
+extern thread_local HandlerFrame* current_handlers;
+
+// 在作用域内以 frame 为最内层的处理器，离开时恢复
+class HandlerScope {
+public:
+    explicit HandlerScope(HandlerFrame* frame) : saved(current_handlers) {
+        current_handlers = frame;
+    }
+    ~HandlerScope() {
+        current_handlers = saved;
+    }
+    HandlerScope(const HandlerScope&) = delete;
+    HandlerScope& operator=(const HandlerScope&) = delete;
+
+private:
+    HandlerFrame* saved;
+};
+
+// 以 condition 引发异常，交给 frame（默认为最内层的处理器）：guard 时返回 LISP_ESCAPE；处理过程在外层的处理器下调用，
+// continuable 时返回它的结果，否则处理过程返回后再引发一个错误。没有处理器时抛出 UnhandledCondition
+ValuePtr raise_condition(EvalEnv& env, ValuePtr condition, bool continuable, HandlerFrame* frame = current_handlers);
+// 求值中抛出的 C++ 错误（LispError 等）对应的条件对象
+ValuePtr error_condition(const std::exception& error);
+
+#endif
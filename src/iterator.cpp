@@ -0,0 +1,226 @@
+#include "iterator.h"
+
+#include <utility>
+
+#include "error.h"
+#include "eval_env.h"
+#include "stack_segments.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+RangeIterator::RangeIterator(double start, double end, double step) : start(start), end(end), step(step) {
+    if (step == 0) {
+        throw LispError("in-range: step must not be zero.");
+    }
+}
+
+ValuePtr RangeIterator::next(EvalEnv& env) {
+    double value = start + index * step;
+    if (step > 0 ? value >= end : value <= end) {
+        return nullptr;
+    }
+    index += 1;
+    return std::make_shared<NumericValue>(value);
+}
+
+ValuePtr LinesIterator::next(EvalEnv& env) {
+    if (port->isClosed()) {
+        throw LispError("in-lines: port is closed.");
+    }
+    auto line = port->readLine();
+    if (!line) {
+        return nullptr;
+    }
+    return std::make_shared<StringValue>(*line);
+}
+
+ValuePtr MapIterator::next(EvalEnv& env) {
+    ValuePtr item = source->next(env);
+    if (!item || item == LISP_ESCAPE) {
+        return item;
+    }
+    return env.applyOrEscape(proc, {std::move(item)});
+}
+
+ValuePtr FilterIterator::next(EvalEnv& env) {
+    while (true) {
+        ValuePtr item = source->next(env);
+        if (!item || item == LISP_ESCAPE) {
+            return item;
+        }
+        ValuePtr keep = env.applyOrEscape(pred, {item});
+        if (keep == LISP_ESCAPE) {
+            return keep;
+        }
+        if (!keep->isLispFalse()) {
+            return item;
+        }
+    }
+}
+
+namespace {
+
+// 释放尚未取完的生成器时，在它挂起的 generator-yield 处抛出，展开它的栈。不是 std::exception，不会被 guard 等捕获
+struct GeneratorExit {};
+
+thread_local GeneratorValue* running_generator = nullptr;
+
+#ifndef _WIN32
+constexpr size_t GENERATOR_STACK_SIZE = 1024 * 1024;
+// 与 stack_segments 相同的用途：低于此位置时换到新的栈段上继续求值
+constexpr size_t STACK_SAFETY_MARGIN = 256 * 1024;
+
+// 缓存几段释放的栈，循环中反复创建生成器时不必每次 mmap。只含指针，线程结束时不析构
+struct StackCache {
+    static constexpr size_t CAPACITY = 4;
+    char* stacks[CAPACITY];
+    size_t count;
+
+    char* acquire() {
+        if (count > 0) {
+            return stacks[--count];
+        }
+        void* mem = mmap(nullptr, GENERATOR_STACK_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem == MAP_FAILED) {
+            throw LispError("make-generator: failed to allocate a generator stack.");
+        }
+        // 最低的一页作为保护页
+        mprotect(mem, sysconf(_SC_PAGESIZE), PROT_NONE);
+        return static_cast<char*>(mem);
+    }
+
+    void release(char* stack) {
+        if (count < CAPACITY) {
+            stacks[count++] = stack;
+        } else {
+            munmap(stack, GENERATOR_STACK_SIZE);
+        }
+    }
+};
+
+thread_local StackCache stack_cache{};
+#endif
+
+}  // namespace
+
+#ifndef _WIN32
+struct GeneratorContext {
+    ucontext_t ctx;
+    ucontext_t caller;
+    char* stack = nullptr;
+    // 挂起时生成器的栈下界与处理器栈；生成器可能在它自己换到的栈段上挂起
+    const char* limit = nullptr;
+    HandlerFrame* handlers = nullptr;
+
+    ~GeneratorContext() {
+        if (stack) {
+            stack_cache.release(stack);
+        }
+    }
+};
+#else
+struct GeneratorContext {};
+#endif
+
+GeneratorValue::GeneratorValue(ValuePtr thunk, std::shared_ptr<EvalEnv> env)
+    : thunk(std::move(thunk)), env(std::move(env)) {}
+
+GeneratorValue::~GeneratorValue() {
+    if (state == State::Suspended) {
+        cancelled = true;
+        resume();
+    }
+}
+
+ValuePtr GeneratorValue::next(EvalEnv& caller_env) {
+#ifdef _WIN32
+    throw LispError("make-generator: generators are not supported on this platform.");
+#else
+    if (state == State::Running) {
+        throw LispError("generator: already running.");
+    }
+    if (state == State::Done) {
+        return nullptr;
+    }
+    if (state == State::NotStarted) {
+        context = std::make_unique<GeneratorContext>();
+        context->stack = stack_cache.acquire();
+        context->limit = context->stack + STACK_SAFETY_MARGIN;
+        context->handlers = &base;
+        getcontext(&context->ctx);
+        context->ctx.uc_stack.ss_sp = context->stack;
+        context->ctx.uc_stack.ss_size = GENERATOR_STACK_SIZE;
+        context->ctx.uc_link = &context->caller;
+        makecontext(&context->ctx, &GeneratorValue::entry, 0);
+    }
+    resume();
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+    if (state == State::Done) {
+        return std::exchange(escaped, false) ? LISP_ESCAPE : nullptr;
+    }
+    return std::move(yielded);
+#endif
+}
+
+void GeneratorValue::resume() {
+#ifndef _WIN32
+    GeneratorValue* outer_generator = std::exchange(running_generator, this);
+    const char* outer_limit = std::exchange(stack_limit, context->limit);
+    // 生成器中引发的条件经 base 交给这一次调用方的处理器
+    base.outer = current_handlers;
+    HandlerFrame* outer_handlers = std::exchange(current_handlers, context->handlers);
+    state = State::Running;
+    swapcontext(&context->caller, &context->ctx);
+    current_handlers = outer_handlers;
+    base.outer = nullptr;
+    stack_limit = outer_limit;
+    running_generator = outer_generator;
+    if (state == State::Done) {
+        thunk = nullptr;
+        env = nullptr;
+        context.reset();
+    }
+#endif
+}
+
+void GeneratorValue::entry() {
+    GeneratorValue* self = running_generator;
+    try {
+        ValuePtr result = self->env->applyOrEscape(self->thunk, {});
+        self->escaped = result == LISP_ESCAPE;
+    } catch (const GeneratorExit&) {
+    } catch (...) {
+        self->error = std::current_exception();
+    }
+    self->state = State::Done;
+    // 返回后经 uc_link 回到 resume
+}
+
+void GeneratorValue::yield(ValuePtr value) {
+#ifndef _WIN32
+    GeneratorValue* self = running_generator;
+    if (!self) {
+        throw LispError("generator-yield: not inside a generator.");
+    }
+    if (self->cancelled) {
+        throw GeneratorExit{};
+    }
+    self->yielded = std::move(value);
+    self->state = State::Suspended;
+    self->context->limit = stack_limit;
+    self->context->handlers = current_handlers;
+    swapcontext(&self->context->ctx, &self->context->caller);
+    if (self->cancelled) {
+        throw GeneratorExit{};
+    }
+#else
+    throw LispError("generator-yield: not inside a generator.");
+#endif
+}
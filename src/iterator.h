@@ -0,0 +1,104 @@
+#ifndef ITERATOR_H
+#define ITERATOR_H
+
+#include <exception>
+#include <memory>
+
+#include "handler_stack.h"
+#include "port.h"
+#include "value.h"
+
+class EvalEnv;
+struct GeneratorContext;
+
+// 惰性序列：in-range、in-lines、生成器以及在它们之上的 map、filter。
+// map、filter、reduce、for-each 等内建过程逐个取出元素，不先把整个序列构造成表
+class IteratorValue : public Value {
+public:
+    // 下一个元素；已经取完时返回 nullptr，途中发生续延逃逸时返回 LISP_ESCAPE
+    virtual ValuePtr next(EvalEnv& env) = 0;
+    std::string toString() const override {
+        return "#<iterator>";
+    }
+};
+
+// (in-range start end step)：从 start 开始、每次加 step、不越过 end 的数
+class RangeIterator : public IteratorValue {
+public:
+    RangeIterator(double start, double end, double step);
+    ValuePtr next(EvalEnv& env) override;
+
+private:
+    double start;
+    double end;
+    double step;
+    double index = 0;  // 按 start + index * step 计算，不累积舍入误差
+};
+
+// (in-lines port)：端口中的各行（不含换行符）
+class LinesIterator : public IteratorValue {
+public:
+    explicit LinesIterator(PortPtr port) : port(std::move(port)) {}
+    ValuePtr next(EvalEnv& env) override;
+
+private:
+    PortPtr port;
+};
+
+// 对迭代器使用 map：取出一个元素时才调用过程
+class MapIterator : public IteratorValue {
+public:
+    MapIterator(ValuePtr proc, std::shared_ptr<IteratorValue> source)
+        : proc(std::move(proc)), source(std::move(source)) {}
+    ValuePtr next(EvalEnv& env) override;
+
+private:
+    ValuePtr proc;
+    std::shared_ptr<IteratorValue> source;
+};
+
+// 对迭代器使用 filter
+class FilterIterator : public IteratorValue {
+public:
+    FilterIterator(ValuePtr pred, std::shared_ptr<IteratorValue> source)
+        : pred(std::move(pred)), source(std::move(source)) {}
+    ValuePtr next(EvalEnv& env) override;
+
+private:
+    ValuePtr pred;
+    std::shared_ptr<IteratorValue> source;
+};
+
+// (make-generator thunk)：thunk 在自己的执行栈上运行，每次 (generator-yield v) 挂起并交出 v，
+// 下一次取元素时从挂起处继续；thunk 返回即取完。尚未取完就被释放时，在挂起处抛出一个内部异常展开它的栈
+class GeneratorValue : public IteratorValue {
+public:
+    GeneratorValue(ValuePtr thunk, std::shared_ptr<EvalEnv> env);
+    ~GeneratorValue() override;
+    ValuePtr next(EvalEnv& env) override;
+    std::string toString() const override {
+        return "#<generator>";
+    }
+
+    // generator-yield：挂起当前线程中最内层正在运行的生成器
+    static void yield(ValuePtr value);
+
+private:
+    enum class State { NotStarted, Suspended, Running, Done };
+
+    ValuePtr thunk;
+    std::shared_ptr<EvalEnv> env;
+    State state = State::NotStarted;
+    std::unique_ptr<GeneratorContext> context;
+    ValuePtr yielded;
+    bool escaped = false;    // thunk 经续延逃逸离开（LISP_ESCAPE）
+    bool cancelled = false;  // 释放时展开栈
+    std::exception_ptr error;
+    // 生成器中处理器栈的底层，不处理条件，只把它交给每次恢复时调用方的处理器
+    HandlerFrame base{nullptr, nullptr};
+
+    void resume();
+    static void entry();
+};
+
+#endif
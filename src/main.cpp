@@ -1,5 +1,7 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <cstdio>
 #include <fstream> 
 #include <sstream>  
 #include "rjsj_test.hpp"
@@ -8,6 +10,11 @@
 #include "./parser.h"
 #include "./eval_env.h"
 #include "./error.h"
+#include "./server.h"
+#include "./worker_pool.h"
+#include "./batch.h"
+#include "./mini_lisp.h"
+#include "./stack_segments.h"
 
 std::string readFileToString(const std::string& filePath) {
     std::ifstream fileStream(filePath);
@@ -21,63 +28,114 @@ std::string readFileToString(const std::string& filePath) {
 }
 
 struct TestCtx {
-    std::shared_ptr<EvalEnv> env = std::make_shared<EvalEnv>(); 
-    TestCtx() = default; 
+    mini_lisp::Interpreter interpreter;
     std::string eval(std::string input) {
-        auto tokens = Tokenizer::tokenize(input);
+        return interpreter.eval(input).repr();
+    }
+};
+
+// 依次求值文件中的所有表达式；失败时返回非零状态码
+int runFile(const std::shared_ptr<EvalEnv>& env, const std::string& filePath) {
+    std::string fileContent = readFileToString(filePath);
+    if (fileContent.empty() && !std::ifstream(filePath).good()) {
+        return 1; // 文件读取失败，直接退出
+    }
+    try {
+        auto tokens = Tokenizer::tokenize(fileContent);
         Parser parser(std::move(tokens));
-        std::string last_result_str;
+
+        // 循环执行文件中的所有表达式
         while (!parser.isAtEnd()) {
             auto value = parser.parse();
-            if (!value) break;
-            auto result = env->eval(std::move(value));
-            if (result) {
-                 last_result_str = result->toString();
+            if (!value) {
+                break;
             }
+            // 只求值，不打印结果，除非遇到 display 等函数
+            env->eval(value);
         }
-        return last_result_str;
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1; // 执行出错，以非零状态码退出
     }
-};
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
     //RJSJ_TEST(TestCtx, Lv2, Lv3, Lv4, Lv5, Lv5Extra, Lv6, Lv7, Lv7Lib, Sicp);
 
     auto env = std::make_shared<EvalEnv>();
 
-    if (argc > 2) {
-        std::cerr << "Usage: " << argv[0] << " [optional_filepath]" << std::endl;
+    std::string prelude_path;
+    std::string serve_path;
+    std::string file_path;
+    std::vector<std::string> batch_files;
+    bool batch = false;
+    int workers = 0;
+    bool bad_usage = false;
+    for (int i = 1; i < argc && !bad_usage; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--prelude" && i + 1 < argc) {
+            prelude_path = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serve_path = argv[++i];
+        } else if (arg == "--max-stack" && i + 1 < argc) {
+            // 深层递归可以使用的栈总量（MB），见 stack_segments.h
+            int megabytes = std::atoi(argv[++i]);
+            bad_usage = megabytes <= 0;
+            set_max_stack_size(static_cast<size_t>(megabytes) << 20);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+            bad_usage = workers <= 0;
+        } else if (arg == "--batch") {
+            // 其余参数均为脚本路径；以 @ 开头的参数为清单文件，每行一个路径
+            batch = true;
+            while (++i < argc) {
+                std::string path = argv[i];
+                if (path.rfind("@", 0) != 0) {
+                    batch_files.push_back(path);
+                    continue;
+                }
+                std::ifstream manifest(path.substr(1));
+                bad_usage = bad_usage || !manifest.is_open();
+                std::string line;
+                while (std::getline(manifest, line)) {
+                    if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                        batch_files.push_back(line);
+                    }
+                }
+            }
+            bad_usage = bad_usage || batch_files.empty();
+        } else if (file_path.empty() && arg.rfind("--", 0) != 0) {
+            file_path = arg;
+        } else {
+            bad_usage = true;
+        }
+    }
+    int modes = !file_path.empty() + !serve_path.empty() + (workers > 0) + batch;
+    if (bad_usage || modes > 1) {
+        std::cerr << "Usage: " << argv[0] << " [--prelude file] [--max-stack MB] [optional_filepath | --serve socket_path | --workers N | --batch file...]" << std::endl;
         return 1; 
     }
 
-    
-    if (argc == 2) {
-        std::string filePath = argv[1];
-        std::string fileContent = readFileToString(filePath);
+    if (batch) {
+        // 每个文件都在自己的根环境中执行 prelude
+        return runBatch(batch_files, prelude_path.empty() ? "" : readFileToString(prelude_path));
+    }
 
-       
-        if (fileContent.empty() && !std::ifstream(filePath).good()) {
-            return 1; // 文件读取失败，直接退出
-        }
-        
-        try {
-            auto tokens = Tokenizer::tokenize(fileContent);
-            Parser parser(std::move(tokens));
+    if (!prelude_path.empty() && runFile(env, prelude_path) != 0) {
+        return 1;
+    }
 
-            // 循环执行文件中的所有表达式
-            while (!parser.isAtEnd()) {
-                auto value = parser.parse();
-                if (!value) {
-                    break;
-                }
-                // 只求值，不打印结果，除非遇到 display 等函数
-                env->eval(value);
-            }
-        } catch (const std::runtime_error& e) {
-            std::cerr << "Error: " << e.what() << std::endl;
-            return 1; // 执行出错，以非零状态码退出
-        }
-        
-        return 0; // 文件成功执行完毕，正常退出
+    if (!serve_path.empty()) {
+        return runServer(serve_path, env);
+    }
+
+    if (workers > 0) {
+        return runWorkerPool(workers, env, fileno(stdin));
+    }
+
+    if (!file_path.empty()) {
+        return runFile(env, file_path); // 文件成功执行完毕时返回 0
     }
 
     while (true) {
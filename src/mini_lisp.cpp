@@ -0,0 +1,237 @@
+#include "mini_lisp.h"
+
+#include <optional>
+#include <typeinfo>
+
+#include "builtins.h"
+#include "error.h"
+#include "eval_env.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "stack_segments.h"
+#include "tokenizer.h"
+
+namespace mini_lisp {
+
+namespace {
+
+// 在宿主调用期间重定向输出并拦截 exit
+template <typename F>
+ValuePtr guarded(std::ostream* output, F&& body) {
+    std::optional<OutputRedirect> redirect;
+    if (output) {
+        redirect.emplace(*output);
+    }
+    ExitTrap trap;
+    try {
+        return body();
+    } catch (const ExitRequest& request) {
+        throw Exit(request.code);
+    }
+}
+
+}  // namespace
+
+Object Object::number(double value) {
+    return Object(std::make_shared<NumericValue>(value));
+}
+
+Object Object::string(std::string_view value) {
+    return Object(std::make_shared<StringValue>(std::string(value)));
+}
+
+Object Object::symbol(std::string_view name) {
+    return Object(create_or_get_symbol(std::string(name)));
+}
+
+Object Object::boolean(bool value) {
+    return Object(value ? LISP_TRUE : LISP_FALSE);
+}
+
+Object Object::nil() {
+    return Object(LISP_NIL);
+}
+
+Object Object::list(const std::vector<Object>& items) {
+    ValuePtr result = LISP_NIL;
+    for (auto it = items.rbegin(); it != items.rend(); ++it) {
+        result = std::make_shared<PairValue>(it->value, result);
+    }
+    return Object(result);
+}
+
+Object Object::vector(const std::vector<Object>& items) {
+    std::vector<ValuePtr> elements;
+    elements.reserve(items.size());
+    for (const auto& item : items) {
+        elements.push_back(item.value);
+    }
+    return Object(std::make_shared<VectorValue>(std::move(elements)));
+}
+
+Type Object::type() const {
+    if (!value) {
+        return Type::Other;
+    }
+    const std::type_info& t = typeid(*value);
+    if (t == typeid(NilValue)) return Type::Nil;
+    if (t == typeid(BooleanValue)) return Type::Boolean;
+    if (t == typeid(NumericValue) || t == typeid(RationalValue)) return Type::Number;
+    if (t == typeid(StringValue)) return Type::String;
+    if (t == typeid(SymbolValue)) return Type::Symbol;
+    if (t == typeid(PairValue)) return Type::Pair;
+    if (t == typeid(VectorValue)) return Type::Vector;
+    if (value->isProcedure()) return Type::Procedure;
+    return Type::Other;
+}
+
+bool Object::truthy() const {
+    return value && !value->isLispFalse();
+}
+
+double Object::toNumber() const {
+    if (!value || !value->isNumber()) {
+        throw LispError("Object is not a number: " + repr());
+    }
+    return value->asNumber();
+}
+
+bool Object::toBool() const {
+    if (!value || !value->isBoolean()) {
+        throw LispError("Object is not a boolean: " + repr());
+    }
+    return value->getboolValue();
+}
+
+std::string_view Object::toStringView() const {
+    if (auto str = dynamic_cast<const StringValue*>(value.get())) {
+        return str->getValue();
+    }
+    if (auto sym = dynamic_cast<const SymbolValue*>(value.get())) {
+        return sym->getName();
+    }
+    throw LispError("Object is not a string or symbol: " + repr());
+}
+
+Object Object::car() const {
+    if (auto pair = dynamic_cast<const PairValue*>(value.get())) {
+        return Object(pair->l);
+    }
+    throw LispError("Object is not a pair: " + repr());
+}
+
+Object Object::cdr() const {
+    if (auto pair = dynamic_cast<const PairValue*>(value.get())) {
+        return Object(pair->r);
+    }
+    throw LispError("Object is not a pair: " + repr());
+}
+
+std::vector<Object> Object::toList() const {
+    std::vector<Object> items;
+    const Value* current = value.get();
+    while (auto pair = dynamic_cast<const PairValue*>(current)) {
+        items.push_back(Object(pair->l));
+        current = pair->r.get();
+    }
+    if (!current || typeid(*current) != typeid(NilValue)) {
+        throw LispError("Object is not a proper list: " + repr());
+    }
+    return items;
+}
+
+std::vector<Object> Object::toVector() const {
+    auto vector = dynamic_cast<const VectorValue*>(value.get());
+    if (!vector) {
+        throw LispError("Object is not a vector: " + repr());
+    }
+    std::vector<Object> items;
+    items.reserve(vector->elements.size());
+    for (const auto& element : vector->elements) {
+        items.push_back(Object(element));
+    }
+    return items;
+}
+
+std::string Object::repr() const {
+    return value ? value->toString() : "#<none>";
+}
+
+Program Program::parse(const std::string& source) {
+    Program program;
+    Parser parser(Tokenizer::tokenize(source));
+    while (!parser.isAtEnd()) {
+        auto value = parser.parse();
+        if (!value) {
+            break;
+        }
+        program.forms.push_back(std::move(value));
+    }
+    return program;
+}
+
+Exit::Exit(int code) : std::runtime_error("exit " + std::to_string(code)), exit_code(code) {}
+
+Interpreter::Interpreter() : env(std::make_shared<EvalEnv>()) {}
+
+Interpreter::~Interpreter() {
+    if (env) {
+        // 全局定义的闭包引用着 env，清空绑定以打破引用环
+        env->clearBindings();
+    }
+}
+
+Interpreter::Interpreter(Interpreter&&) noexcept = default;
+
+Interpreter& Interpreter::operator=(Interpreter&& other) noexcept {
+    if (this != &other) {
+        if (env) {
+            env->clearBindings();
+        }
+        env = std::move(other.env);
+        output = other.output;
+    }
+    return *this;
+}
+
+void Interpreter::setMaxStackSize(size_t bytes) {
+    set_max_stack_size(bytes);
+}
+
+Object Interpreter::eval(const std::string& source) {
+    return eval(Program::parse(source));
+}
+
+Object Interpreter::eval(const Program& program) {
+    return Object(guarded(output, [&] {
+        ValuePtr last = LISP_NIL;
+        for (const auto& form : program.forms) {
+            last = env->eval(form);
+        }
+        return last;
+    }));
+}
+
+void Interpreter::define(const std::string& name, const Object& value) {
+    note_definition(name, value.value);
+    env->defineBinding(name, value.value);
+}
+
+Object Interpreter::lookup(const std::string& name) {
+    return Object(env->lookupBinding(name));
+}
+
+Object Interpreter::call(const Object& procedure, const std::vector<Object>& args) {
+    std::vector<ValuePtr> values;
+    values.reserve(args.size());
+    for (const auto& arg : args) {
+        values.push_back(arg.value);
+    }
+    return Object(guarded(output, [&] { return env->apply(procedure.value, std::move(values)); }));
+}
+
+Object Interpreter::call(const std::string& name, const std::vector<Object>& args) {
+    return call(lookup(name), args);
+}
+
+}  // namespace mini_lisp
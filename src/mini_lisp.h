@@ -0,0 +1,118 @@
+#ifndef MINI_LISP_H
+#define MINI_LISP_H
+
+// mini_lisp_core 的宿主 API。宿主程序只需包含本头文件并链接 mini_lisp_core，
+// 即可在进程内创建解释器、求值源代码或预先解析好的程序，并直接读取结果。
+// 本头文件不依赖解释器内部头文件，内部实现的变化不会影响宿主代码。
+
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Value;
+class EvalEnv;
+
+namespace mini_lisp {
+
+enum class Type { Nil, Boolean, Number, String, Symbol, Pair, Vector, Procedure, Other };
+
+// 对解释器中一个值的引用，复制它只增加引用计数
+class Object {
+public:
+    Object() = default;
+
+    static Object number(double value);
+    static Object string(std::string_view value);
+    static Object symbol(std::string_view name);
+    static Object boolean(bool value);
+    static Object nil();
+    static Object list(const std::vector<Object>& items);
+    static Object vector(const std::vector<Object>& items);
+
+    Type type() const;
+    bool isNil() const { return type() == Type::Nil; }
+    bool isNumber() const { return type() == Type::Number; }
+    bool isString() const { return type() == Type::String; }
+    bool isPair() const { return type() == Type::Pair; }
+    bool isVector() const { return type() == Type::Vector; }
+    // 除 #f 以外的值均为真
+    bool truthy() const;
+
+    // 以下访问函数在类型不符时抛出 std::runtime_error
+    double toNumber() const;
+    bool toBool() const;
+    // 字符串或符号的内容，引用在 Object 存活期间有效
+    std::string_view toStringView() const;
+    Object car() const;
+    Object cdr() const;
+    std::vector<Object> toList() const;
+    // 向量的元素（复制各元素的引用，之后对向量的修改不影响返回值）
+    std::vector<Object> toVector() const;
+
+    // 外部表示，与 REPL 中打印的结果相同
+    std::string repr() const;
+
+    explicit operator bool() const { return value != nullptr; }
+
+private:
+    friend class Interpreter;
+    explicit Object(std::shared_ptr<::Value> value) : value(std::move(value)) {}
+    std::shared_ptr<::Value> value;
+};
+
+// 解析好的一段源代码，可以在任意解释器中重复求值而无需再次解析
+class Program {
+public:
+    static Program parse(const std::string& source);
+    size_t size() const { return forms.size(); }
+
+private:
+    friend class Interpreter;
+    std::vector<std::shared_ptr<::Value>> forms;
+};
+
+// 源代码中调用 (exit n) 时抛出，解释器不会结束宿主进程
+class Exit : public std::runtime_error {
+public:
+    explicit Exit(int code);
+    int code() const { return exit_code; }
+
+private:
+    int exit_code;
+};
+
+// 一个独立的解释器实例，拥有自己的全局环境。
+// 不同实例可以在不同线程中同时使用，同一实例不能被多个线程同时使用。
+class Interpreter {
+public:
+    Interpreter();
+    ~Interpreter();
+    Interpreter(Interpreter&&) noexcept;
+    Interpreter& operator=(Interpreter&&) noexcept;
+
+    // 依次求值全部表达式，返回最后一个表达式的值；出错时抛出 std::runtime_error
+    Object eval(const std::string& source);
+    Object eval(const Program& program);
+
+    void define(const std::string& name, const Object& value);
+    Object lookup(const std::string& name);
+    Object call(const Object& procedure, const std::vector<Object>& args);
+    Object call(const std::string& name, const std::vector<Object>& args);
+
+    // 重定向 display 等过程的输出，传入 nullptr 恢复为标准输出
+    void setOutput(std::ostream* output) { this->output = output; }
+
+    // 深层递归在原生栈之外可以使用的栈总量（字节，对所有解释器生效，默认 1GB），超出时求值抛出 std::runtime_error
+    static void setMaxStackSize(size_t bytes);
+
+private:
+    std::shared_ptr<EvalEnv> env;
+    std::ostream* output = nullptr;
+};
+
+}  // namespace mini_lisp
+
+#endif
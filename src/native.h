@@ -0,0 +1,278 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "builtins.h"
+#include "error.h"
+#include "value.h"
+
+extern const ValuePtr LISP_NIL;
+extern const ValuePtr LISP_TRUE;
+extern const ValuePtr LISP_FALSE;
+
+// 由普通 C++ 函数生成内建过程描述：
+//
+//     static double builtin_hypot(double x, double y) { return std::sqrt(x * x + y * y); }
+//     native_builtin<"hypot", &builtin_hypot>(BUILTIN_PURE | BUILTIN_ALLOCATES)
+//
+// 参数与返回值的类型在编译期推导，元数检查、拆箱与装箱代码由模板生成。
+// 支持的参数类型：double、std::int64_t（要求为整数）、std::string_view（字符串）、
+// bool（除 #f 外均为真）、const ValuePtr&（不做转换），以及只能作为最后一个参数的
+// std::span<const double> / std::span<const ValuePtr>（接收剩余的全部实参）。
+// 第一个参数可以是 EvalEnv&，它不计入元数。
+// 支持的返回类型：double、std::int64_t、bool、std::string、ValuePtr 与 void。
+namespace native {
+
+// 错误路径放在单独的函数中，使拆箱代码保持短小、便于内联
+[[noreturn, gnu::noinline]] inline void argumentError(const char* name, size_t index, const char* expected,
+                                                     const Value& got) {
+    throw LispError(std::string(name) + ": argument " + std::to_string(index + 1) + " must be " + expected +
+                    ". Got: " + brief_repr(got));
+}
+
+template <typename T>
+struct ArgTraits {
+    static_assert(sizeof(T) == 0, "native_builtin: unsupported parameter type");
+};
+
+template <>
+struct ArgTraits<double> {
+    static double unbox(const ValuePtr& value, const char* name, size_t index) {
+        const Value& v = *value;
+        if (typeid(v) == typeid(NumericValue)) {
+            return static_cast<const NumericValue&>(v).getValue();
+        }
+        if (typeid(v) == typeid(RationalValue)) {
+            const auto& rational = static_cast<const RationalValue&>(v);
+            return static_cast<double>(rational.getNumerator()) / rational.getDenominator();
+        }
+        argumentError(name, index, "a number", v);
+    }
+};
+
+template <>
+struct ArgTraits<std::int64_t> {
+    static std::int64_t unbox(const ValuePtr& value, const char* name, size_t index) {
+        double number = ArgTraits<double>::unbox(value, name, index);
+        // [-2^63, 2^63) 之外的值（包括无穷大）无法转换为 int64，也按非整数报错
+        if (std::trunc(number) != number || number < -0x1p63 || number >= 0x1p63) {
+            argumentError(name, index, "an integer", *value);
+        }
+        return static_cast<std::int64_t>(number);
+    }
+};
+
+template <>
+struct ArgTraits<std::string_view> {
+    static std::string_view unbox(const ValuePtr& value, const char* name, size_t index) {
+        const Value& v = *value;
+        if (typeid(v) != typeid(StringValue)) {
+            argumentError(name, index, "a string", v);
+        }
+        return static_cast<const StringValue&>(v).getValue();
+    }
+};
+
+template <>
+struct ArgTraits<bool> {
+    static bool unbox(const ValuePtr& value, const char*, size_t) {
+        // #f 只有 LISP_FALSE 一个实例
+        return value.get() != LISP_FALSE.get();
+    }
+};
+
+template <>
+struct ArgTraits<ValuePtr> {
+    static const ValuePtr& unbox(const ValuePtr& value, const char*, size_t) {
+        return value;
+    }
+};
+
+// std::span<const double> 剩余参数的存放处，参数不多时不在堆上分配
+class NumberBuffer {
+    std::array<double, 8> small;
+    std::vector<double> large;
+public:
+    std::span<double> reserve(size_t count) {
+        if (count <= small.size()) {
+            return {small.data(), count};
+        }
+        large.resize(count);
+        return large;
+    }
+};
+
+template <typename T>
+struct IsRest : std::false_type {};
+template <>
+struct IsRest<std::span<const double>> : std::true_type {};
+template <>
+struct IsRest<std::span<const ValuePtr>> : std::true_type {};
+
+inline ValuePtr box(double value) {
+    return std::make_shared<NumericValue>(value);
+}
+inline ValuePtr box(std::int64_t value) {
+    return std::make_shared<NumericValue>(static_cast<double>(value));
+}
+inline ValuePtr box(bool value) {
+    return value ? LISP_TRUE : LISP_FALSE;
+}
+inline ValuePtr box(const std::string& value) {
+    return std::make_shared<StringValue>(value);
+}
+inline ValuePtr box(ValuePtr value) {
+    return value;
+}
+
+template <typename F>
+struct Signature;
+
+template <typename R, typename... Args>
+struct Signature<R (*)(Args...)> {
+    using Return = R;
+    using Params = std::tuple<std::remove_cvref_t<Args>...>;
+};
+
+// 去掉开头的 EvalEnv& 之后的参数列表
+template <typename Tuple>
+struct StripEnv {
+    using Params = Tuple;
+    static constexpr bool takes_env = false;
+};
+template <typename... Rest>
+struct StripEnv<std::tuple<EvalEnv, Rest...>> {
+    using Params = std::tuple<Rest...>;
+    static constexpr bool takes_env = true;
+};
+
+// 用作模板实参的字符串字面量
+template <size_t N>
+struct FixedString {
+    char value[N];
+    constexpr FixedString(const char (&text)[N]) {
+        std::copy_n(text, N, value);
+    }
+};
+
+template <FixedString Name, auto Fn>
+struct Binding {
+    using Sig = Signature<decltype(Fn)>;
+    using Return = typename Sig::Return;
+    using Params = typename StripEnv<typename Sig::Params>::Params;
+    static constexpr bool takes_env = StripEnv<typename Sig::Params>::takes_env;
+    static constexpr size_t param_count = std::tuple_size_v<Params>;
+    static constexpr const char* name = Name.value;
+
+    template <size_t... I>
+    static constexpr bool restOnlyLast(std::index_sequence<I...>) {
+        return ((!IsRest<std::tuple_element_t<I, Params>>::value || I + 1 == param_count) && ...);
+    }
+    static_assert(restOnlyLast(std::make_index_sequence<param_count>{}),
+                  "native_builtin: a span parameter must be the last one");
+
+    static constexpr bool variadic = [] {
+        if constexpr (param_count == 0) {
+            return false;
+        } else {
+            return IsRest<std::tuple_element_t<param_count - 1, Params>>::value;
+        }
+    }();
+    static constexpr bool needs_buffer = [] {
+        if constexpr (variadic) {
+            return std::is_same_v<std::tuple_element_t<param_count - 1, Params>, std::span<const double>>;
+        } else {
+            return false;
+        }
+    }();
+    static constexpr size_t min_arity = variadic ? param_count - 1 : param_count;
+    static constexpr size_t max_arity = variadic ? ARITY_VARIADIC : param_count;
+
+    template <typename... Unboxed>
+    static ValuePtr call(EvalEnv& env, Unboxed&&... unboxed) {
+        if constexpr (std::is_void_v<Return>) {
+            if constexpr (takes_env) {
+                Fn(env, unboxed...);
+            } else {
+                Fn(unboxed...);
+            }
+            return LISP_NIL;
+        } else if constexpr (takes_env) {
+            return box(Fn(env, unboxed...));
+        } else {
+            return box(Fn(unboxed...));
+        }
+    }
+
+    template <typename T, typename Buffer>
+    static decltype(auto) unboxAt(const std::vector<ValuePtr>& args, size_t index, Buffer& buffer) {
+        if constexpr (std::is_same_v<T, std::span<const ValuePtr>>) {
+            return std::span<const ValuePtr>(args.data() + index, args.size() - index);
+        } else if constexpr (std::is_same_v<T, std::span<const double>>) {
+            std::span<double> numbers = buffer.reserve(args.size() - index);
+            for (size_t i = index; i < args.size(); ++i) {
+                numbers[i - index] = ArgTraits<double>::unbox(args[i], name, i);
+            }
+            return std::span<const double>(numbers);
+        } else {
+            return ArgTraits<T>::unbox(args[index], name, index);
+        }
+    }
+
+    template <size_t... I>
+    static ValuePtr invoke(const std::vector<ValuePtr>& args, EvalEnv& env, std::index_sequence<I...>) {
+        [[maybe_unused]] std::conditional_t<needs_buffer, NumberBuffer, std::tuple<>> buffer;
+        auto forward = [&](auto&&... unboxed) {
+            return call(env, unboxed...);
+        };
+        // 花括号初始化保证实参按从左到右的顺序拆箱
+        return std::apply(forward, std::tuple<decltype(unboxAt<std::tuple_element_t<I, Params>>(args, I, buffer))...>{
+                                       unboxAt<std::tuple_element_t<I, Params>>(args, I, buffer)...});
+    }
+
+    // 元数已由调用方检查（见 check_arity）
+    static ValuePtr thunk(const std::vector<ValuePtr>& args, EvalEnv& env) {
+        return invoke(args, env, std::make_index_sequence<param_count>{});
+    }
+
+    static ValuePtr thunk1(const ValuePtr& a, EvalEnv& env) {
+        using A = std::tuple_element_t<0, Params>;
+        return call(env, ArgTraits<A>::unbox(a, name, 0));
+    }
+
+    static ValuePtr thunk2(const ValuePtr& a, const ValuePtr& b, EvalEnv& env) {
+        using A = std::tuple_element_t<0, Params>;
+        using B = std::tuple_element_t<1, Params>;
+        decltype(auto) first = ArgTraits<A>::unbox(a, name, 0);
+        decltype(auto) second = ArgTraits<B>::unbox(b, name, 1);
+        return call(env, first, second);
+    }
+};
+
+}  // namespace native
+
+// 生成内建过程描述；元数固定为 1 或 2 时同时提供专用入口
+template <native::FixedString Name, auto Fn>
+constexpr BuiltinDescriptor native_builtin(unsigned flags) {
+    using B = native::Binding<Name, Fn>;
+    BuiltinDescriptor descriptor{B::name, &B::thunk, B::min_arity, B::max_arity, flags};
+    if constexpr (!B::variadic && B::param_count == 1) {
+        descriptor.fn1 = &B::thunk1;
+    } else if constexpr (!B::variadic && B::param_count == 2) {
+        descriptor.fn2 = &B::thunk2;
+    }
+    return descriptor;
+}
+
+#endif
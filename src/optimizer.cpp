@@ -0,0 +1,1644 @@
+#include "optimizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "builtins.h"
+#include "error.h"
+#include "eval_env.h"
+#include "forms.h"
+#include "syntax_rules.h"
+
+namespace {
+
+std::atomic<std::uint64_t> epoch{0};
+
+// 优化结果所依赖的全局名字（被内联的过程、被预先展开的宏及宏展开时用到的全局变量），
+// 重新定义它们时需要使优化结果失效
+std::mutex dependency_mutex;
+std::unordered_set<std::string> dependency_names;
+
+void noteDependency(const std::string& name) {
+    std::lock_guard<std::mutex> lock(dependency_mutex);
+    dependency_names.insert(name);
+}
+
+bool isDependency(const std::string& name) {
+    std::lock_guard<std::mutex> lock(dependency_mutex);
+    return dependency_names.count(name) != 0;
+}
+
+// 曾被 set! 修改（或在优化时见到 set! 目标）的全局名字。优化把未被修改的全局过程当作常量，
+// 某个名字第一次被记入时使之前的优化结果失效
+std::unordered_set<std::string> assigned_globals;
+
+void noteAssignedGlobal(const std::string& name) {
+    std::lock_guard<std::mutex> lock(dependency_mutex);
+    if (assigned_globals.insert(name).second) {
+        epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool isAssignedGlobal(const std::string& name) {
+    std::lock_guard<std::mutex> lock(dependency_mutex);
+    return assigned_globals.count(name) != 0;
+}
+
+constexpr size_t INLINE_SIZE_LIMIT = 24;  // 可内联过程体的最大结点数
+constexpr int INLINE_DEPTH_LIMIT = 4;     // 内联结果中再次内联的最大层数
+constexpr int EXPAND_DEPTH_LIMIT = 64;    // 宏展开结果中再次展开的最大层数，防止无限递归的宏
+
+std::optional<std::string> symbolName(const ValuePtr& value) {
+    return value->isSymbol() ? value->asSymbol() : std::nullopt;
+}
+
+// define-macro 或 define-syntax 定义的宏
+bool isMacro(const ValuePtr& value) {
+    return value && (typeid(*value) == typeid(MacroValue) || typeid(*value) == typeid(SyntaxRulesValue));
+}
+
+// 字面量表达式求值的结果；不是字面量时返回 nullptr
+ValuePtr literalValue(const ValuePtr& expr) {
+    if (expr->isNumber() || expr->isString() || expr->isBoolean() || expr->isNil()) {
+        return expr;
+    }
+    if (expr->isPair()) {
+        auto& pair = static_cast<PairValue&>(*expr);
+        auto name = symbolName(pair.l);
+        if (name && *name == "quote" && pair.r->isPair() && static_cast<PairValue&>(*pair.r).r->isNil()) {
+            return static_cast<PairValue&>(*pair.r).l;
+        }
+    }
+    return nullptr;
+}
+
+// 求值时不会出错、没有副作用、可以重复求值的表达式
+bool isTrivial(const ValuePtr& expr) {
+    return !expr->isPair() || literalValue(expr) != nullptr;
+}
+
+ValuePtr toLiteral(const ValuePtr& value) {
+    if (value->isNumber() || value->isString() || value->isBoolean() || value->isNil()) {
+        return value;
+    }
+    std::vector<ValuePtr> quoted{create_or_get_symbol("quote"), value};
+    return toList(quoted);
+}
+
+// 内部 define 的名字在整个过程体中都是局部的。if、cond 等子表达式中的 define
+// 只在运行到时才绑定，因此也视为可能遮蔽外层绑定，并另外记入 conditional（不为空时）；
+// 只有嵌套的过程体与引用的数据不必查看
+void collect_definitions(const ValuePtr& expr, std::vector<std::string>& out,
+                         std::vector<std::string>* conditional = nullptr, bool nested = false) {
+    if (!expr->isPair()) {
+        return;
+    }
+    auto& pair = static_cast<PairValue&>(*expr);
+    auto op = symbolName(pair.l);
+    if (op && (*op == "quote" || *op == "quasiquote" || *op == "lambda")) {
+        return;
+    }
+    if (op && (*op == "define" || *op == "define-macro" || *op == "define-syntax") && pair.r->isPair()) {
+        ValuePtr target = static_cast<PairValue&>(*pair.r).l;
+        if (target->isPair()) {
+            // (define (f ...) ...) 的过程体属于 f 自己
+            target = static_cast<PairValue&>(*target).l;
+        }
+        if (auto name = symbolName(target)) {
+            out.push_back(*name);
+            if (nested && conditional) {
+                conditional->push_back(*name);
+            }
+        }
+        if (!static_cast<PairValue&>(*pair.r).l->isSymbol()) {
+            return;
+        }
+    }
+    // begin 中的表达式与所在的过程体一样按顺序执行
+    bool in_begin = op && *op == "begin";
+    for (ValuePtr rest = expr; rest->isPair(); rest = static_cast<PairValue&>(*rest).r) {
+        collect_definitions(static_cast<PairValue&>(*rest).l, out, conditional, nested || !in_begin);
+    }
+}
+
+// 表达式中是否有 lambda 或内部定义的过程。let、do 每次求值都要检查，这里不分配内存
+bool createsClosure(const ValuePtr& expr) {
+    if (!expr->isPair()) {
+        return false;
+    }
+    auto& pair = static_cast<PairValue&>(*expr);
+    if (typeid(*pair.l) == typeid(SymbolValue)) {
+        const std::string& op = static_cast<SymbolValue&>(*pair.l).getName();
+        if (op == "quote") {
+            return false;
+        }
+        if (op == "lambda" || (op == "define" && pair.r->isPair() && static_cast<PairValue&>(*pair.r).l->isPair()) ||
+            (op == "let" && pair.r->isPair() && static_cast<PairValue&>(*pair.r).l->isSymbol())) {
+            // 命名 let 不能按循环执行时会创建局部过程
+            return true;
+        }
+    }
+    for (ValuePtr rest = expr; rest->isPair(); rest = static_cast<PairValue&>(*rest).r) {
+        if (createsClosure(static_cast<PairValue&>(*rest).l)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 正在记录分析与优化时查询过哪些外部名字的绑定（见 refresh_lambda）；为空时不记录
+thread_local std::vector<std::string>* consulted_names = nullptr;
+
+void noteConsulted(const std::string& name) {
+    if (consulted_names) {
+        consulted_names->push_back(name);
+    }
+}
+
+class ConsultedScope {
+public:
+    explicit ConsultedScope(std::vector<std::string>& names) : outer(std::exchange(consulted_names, &names)) {}
+    ~ConsultedScope() {
+        consulted_names = outer;
+    }
+    ConsultedScope(const ConsultedScope&) = delete;
+    ConsultedScope& operator=(const ConsultedScope&) = delete;
+
+private:
+    std::vector<std::string>* outer;
+};
+
+// 闭包转换用的自由变量分析。过程体中出现宏调用、eval 等使用调用处环境的内建过程
+// 或不认识的特殊形式时，无法确定它会访问哪些变量，walkLambda 返回 false。
+class FreeVariables {
+public:
+    explicit FreeVariables(EvalEnv& env) : env(env) {}
+
+    bool walkLambda(const std::vector<std::string>& params, const std::vector<ValuePtr>& body) {
+        size_t mark = scope.size();
+        scope.insert(scope.end(), params.begin(), params.end());
+        bool ok = walkBody(body);
+        scope.resize(mark);
+        return ok;
+    }
+
+    std::vector<std::string> names;  // 按首次出现的顺序
+    // set! 的目标，包括嵌套过程中的（只按名字记录，不区分被哪一层绑定）
+    std::vector<std::string> assigned;
+
+    bool isAssigned(const std::string& name) const {
+        return std::find(assigned.begin(), assigned.end(), name) != assigned.end();
+    }
+
+    // 过程体运行时可能在自己的帧中引入新的绑定、遮蔽全局绑定：引用了 eval 等使用调用处环境的内建过程，
+    // 或经局部变量、表达式调用过程（被调用的可能是作为值传入的 eval）
+    bool dynamic_bindings = false;
+
+private:
+    EvalEnv& env;
+    std::vector<std::string> scope;
+
+    // 过程体中以过程形式定义的名字（内部 (define (f ...) ...)），调用它们不是间接调用
+    std::vector<std::string> procedure_names;
+
+    // 名字绑定在过程体或外层过程的局部环境中，且不是已知的局部过程
+    bool localName(const std::string& name) const {
+        if (std::find(procedure_names.begin(), procedure_names.end(), name) != procedure_names.end()) {
+            return false;
+        }
+        if (bound(name)) {
+            return true;
+        }
+        for (EvalEnv* frame = &env; frame->parent; frame = frame->parent.get()) {
+            if (frame->symbol_map.count(name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool bound(const std::string& name) const {
+        return std::find(scope.begin(), scope.end(), name) != scope.end();
+    }
+
+    static bool isLambdaExpression(const ValuePtr& expr) {
+        if (!expr->isPair()) {
+            return false;
+        }
+        auto op = symbolName(static_cast<PairValue&>(*expr).l);
+        return op && *op == "lambda";
+    }
+
+    // let-values、receive 的 formals：单个符号或符号的表
+    static std::vector<std::string> formalNames(const ValuePtr& formals) {
+        if (auto name = symbolName(formals)) {
+            return {*name};
+        }
+        return get_parameter_names(formals);
+    }
+
+    ValuePtr binding(const std::string& name) const {
+        noteConsulted(name);
+        try {
+            return env.lookupBinding(name);
+        } catch (const LispError&) {
+            return nullptr;
+        }
+    }
+
+    bool walkBody(const std::vector<ValuePtr>& body) {
+        size_t mark = scope.size();
+        size_t procedures_mark = procedure_names.size();
+        std::vector<std::string> definitions, conditional;
+        for (const auto& expr : body) {
+            collect_definitions(expr, definitions, &conditional);
+            if (expr->isPair() && static_cast<PairValue&>(*expr).r->isPair()) {
+                auto op = symbolName(static_cast<PairValue&>(*expr).l);
+                ValuePtr target = static_cast<PairValue&>(*static_cast<PairValue&>(*expr).r).l;
+                if (op && *op == "define" && target->isPair()) {
+                    if (auto name = symbolName(static_cast<PairValue&>(*target).l)) {
+                        procedure_names.push_back(*name);
+                    }
+                }
+            }
+        }
+        // 条件执行的 define 未执行时，名字仍指向外层的绑定，需要一并捕获
+        for (const auto& name : conditional) {
+            if (!walk(create_or_get_symbol(name))) {
+                return false;
+            }
+        }
+        scope.insert(scope.end(), definitions.begin(), definitions.end());
+        bool ok = std::all_of(body.begin(), body.end(), [this](const ValuePtr& e) { return walk(e); });
+        scope.resize(mark);
+        procedure_names.resize(procedures_mark);
+        return ok;
+    }
+
+    bool walk(const ValuePtr& expr) {
+        if (auto name = symbolName(expr)) {
+            if (bound(*name) || std::find(names.begin(), names.end(), *name) != names.end()) {
+                return true;
+            }
+            ValuePtr value = binding(*name);
+            if (value && typeid(*value) == typeid(BuiltinProcValue) &&
+                static_cast<BuiltinProcValue&>(*value).get_descriptor().capturesEnv()) {
+                dynamic_bindings = true;
+                return false;
+            }
+            names.push_back(*name);
+            return true;
+        }
+        if (typeid(*expr) == typeid(VectorValue)) {
+            // quasiquote 模板中的向量可能含有 unquote；字面量向量也这样处理，只会多捕获
+            const auto& items = static_cast<VectorValue&>(*expr).elements;
+            return std::all_of(items.begin(), items.end(), [this](const ValuePtr& e) { return walk(e); });
+        }
+        if (!expr->isPair() || literalValue(expr)) {
+            return true;
+        }
+        try {
+            std::vector<ValuePtr> elements = expr->toVector();
+            auto op = symbolName(elements[0]);
+            if (op && SPECIAL_FORMS.count(*op)) {
+                return walkSpecialForm(*op, elements);
+            }
+            if (op && !bound(*op)) {
+                ValuePtr value = binding(*op);
+                if (isMacro(value)) {
+                    return false;
+                }
+            }
+            if (op ? localName(*op) : !isLambdaExpression(elements[0])) {
+                dynamic_bindings = true;
+            }
+            return std::all_of(elements.begin(), elements.end(), [this](const ValuePtr& e) { return walk(e); });
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool walkSpecialForm(const std::string& op, const std::vector<ValuePtr>& elements) {
+        if (op == "lambda" && elements.size() >= 3) {
+            return walkLambda(get_parameter_names(elements[1]), {elements.begin() + 2, elements.end()});
+        }
+        if (op == "define" && elements.size() >= 3 && elements[1]->isPair()) {
+            auto& spec = static_cast<PairValue&>(*elements[1]);
+            return walkLambda(get_parameter_names(spec.r), {elements.begin() + 2, elements.end()});
+        }
+        if (op == "let" && elements.size() >= 4 && elements[1]->isSymbol()) {
+            std::vector<std::string> loop_names{*elements[1]->asSymbol()};
+            for (const auto& binding : elements[2]->toVector()) {
+                std::vector<ValuePtr> pair = binding->toVector();
+                if (pair.size() != 2 || !pair[0]->isSymbol() || !walk(pair[1])) {
+                    return false;
+                }
+                loop_names.push_back(*pair[0]->asSymbol());
+            }
+            // 调用循环名是回到循环开头，不是间接调用
+            procedure_names.push_back(loop_names[0]);
+            bool ok = walkLambda(loop_names, {elements.begin() + 3, elements.end()});
+            procedure_names.pop_back();
+            return ok;
+        }
+        if (op == "do" && elements.size() >= 3) {
+            std::vector<std::string> vars;
+            std::vector<ValuePtr> inner;
+            for (const auto& spec : elements[1]->toVector()) {
+                std::vector<ValuePtr> parts = spec->toVector();
+                if (parts.size() < 2 || parts.size() > 3 || !parts[0]->isSymbol() || !walk(parts[1])) {
+                    return false;
+                }
+                vars.push_back(*parts[0]->asSymbol());
+                if (parts.size() == 3) {
+                    inner.push_back(parts[2]);
+                }
+            }
+            std::vector<ValuePtr> exit_clause = elements[2]->toVector();
+            inner.insert(inner.end(), exit_clause.begin(), exit_clause.end());
+            inner.insert(inner.end(), elements.begin() + 3, elements.end());
+            return walkLambda(vars, inner);
+        }
+        if (op == "let" && elements.size() >= 3) {
+            std::vector<std::string> let_names;
+            for (const auto& binding : elements[1]->toVector()) {
+                std::vector<ValuePtr> pair = binding->toVector();
+                if (pair.size() != 2 || !pair[0]->isSymbol() || !walk(pair[1])) {
+                    return false;
+                }
+                let_names.push_back(*pair[0]->asSymbol());
+            }
+            return walkLambda(let_names, {elements.begin() + 2, elements.end()});
+        }
+        if (op == "quote") {
+            return true;
+        }
+        if (op == "guard" && elements.size() >= 3 && elements[1]->isPair()) {
+            // 子句在绑定了条件变量的作用域中，与 cond 一样逐个子句按表达式处理
+            auto& spec = static_cast<PairValue&>(*elements[1]);
+            auto var = symbolName(spec.l);
+            if (!var || !std::all_of(elements.begin() + 2, elements.end(), [this](const ValuePtr& e) { return walk(e); })) {
+                return false;
+            }
+            return walkLambda({*var}, spec.r->isNil() ? std::vector<ValuePtr>{} : spec.r->toVector());
+        }
+        if (op == "receive" && elements.size() >= 4) {
+            return walk(elements[2]) && walkLambda(formalNames(elements[1]), {elements.begin() + 3, elements.end()});
+        }
+        if ((op == "let-values" || op == "let*-values") && elements.size() >= 3) {
+            // let*-values 的表达式在已绑定之前各组变量的作用域中
+            size_t mark = scope.size();
+            std::vector<std::string> bound_names;
+            bool ok = true;
+            for (const auto& binding : elements[1]->isNil() ? std::vector<ValuePtr>{} : elements[1]->toVector()) {
+                std::vector<ValuePtr> parts = binding->toVector();
+                if (parts.size() != 2 || !walk(parts[1])) {
+                    ok = false;
+                    break;
+                }
+                std::vector<std::string> formals = formalNames(parts[0]);
+                bound_names.insert(bound_names.end(), formals.begin(), formals.end());
+                if (op == "let*-values") {
+                    scope.insert(scope.end(), formals.begin(), formals.end());
+                }
+            }
+            scope.resize(mark);
+            return ok && walkLambda(bound_names, {elements.begin() + 2, elements.end()});
+        }
+        if (op == "set!" && elements.size() == 3) {
+            if (auto name = symbolName(elements[1]); name && !isAssigned(*name)) {
+                assigned.push_back(*name);
+            }
+            return walk(elements[1]) && walk(elements[2]);
+        }
+        if (op == "define" || op == "if" || op == "and" || op == "or" || op == "begin" || op == "cond" ||
+            op == "quasiquote") {
+            // define 的目标名已由 collect_definitions 记入作用域；quasiquote 模板按代码处理，只会多捕获
+            return std::all_of(elements.begin() + 1, elements.end(), [this](const ValuePtr& e) { return walk(e); });
+        }
+        return false;
+    }
+};
+
+// 环境链中有会话的顶层环境（见 EvalEnv::toplevel）
+bool inToplevelSession(const EvalEnv& env) {
+    for (const EvalEnv* frame = &env; frame; frame = frame->parent.get()) {
+        if (frame->toplevel) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class Folder {
+public:
+    // templates_only 为真时只编译 quasiquote 模板，不做依赖于绑定的折叠、内联与宏展开
+    explicit Folder(EvalEnv& env, bool templates_only = false) : env(env), templates_only(templates_only) {}
+
+    // 过程体中 set! 的目标（见 FreeVariables::assigned）；nullptr 表示无法确定，所有局部变量都可能被修改
+    void setAssigned(const FreeVariables* free) {
+        assigned = free;
+    }
+
+    // 过程体运行时可能引入遮蔽全局绑定的局部绑定（见 FreeVariables::dynamic_bindings）：
+    // 不依据全局绑定做折叠、内联与宏的预先展开
+    void setDynamicBindings(bool dynamic) {
+        dynamic_bindings = dynamic;
+    }
+
+    std::vector<ValuePtr> foldBody(const std::vector<ValuePtr>& body) {
+        size_t mark = scope.size();
+        for (const auto& expr : body) {
+            collect_definitions(expr, scope);
+        }
+        std::vector<ValuePtr> result;
+        result.reserve(body.size());
+        for (const auto& expr : body) {
+            result.push_back(fold(expr));
+        }
+        scope.resize(mark);
+        return result;
+    }
+
+    void bind(const std::string& name) {
+        scope.push_back(name);
+    }
+
+    // 把过程体中未被局部绑定遮蔽的变量引用改写为指向全局绑定格的 GlobalRefValue。
+    // 嵌套的 lambda 与内部定义的过程在它们自己被优化时再改写。
+    std::vector<ValuePtr> bindGlobalsInBody(const std::vector<ValuePtr>& body) {
+        size_t mark = scope.size();
+        for (const auto& expr : body) {
+            collect_definitions(expr, scope);
+        }
+        std::vector<ValuePtr> result;
+        result.reserve(body.size());
+        for (const auto& expr : body) {
+            result.push_back(bindGlobals(expr));
+        }
+        scope.resize(mark);
+        return result;
+    }
+
+private:
+    EvalEnv& env;
+    bool templates_only;
+    std::vector<std::string> scope;  // 过程内部绑定的名字，它们会遮蔽外层绑定
+    const FreeVariables* assigned = nullptr;
+    bool dynamic_bindings = false;
+    int inline_depth = 0;
+    int expand_depth = 0;
+
+    // 过程体中形参的一次出现：形参下标，以及该处是否一定会被求值
+    struct Occurrence {
+        size_t param;
+        bool strict;
+    };
+
+    bool isLocal(const std::string& name) const {
+        return std::find(scope.begin(), scope.end(), name) != scope.end();
+    }
+
+    // 名字在过程外部的绑定；未绑定或被局部遮蔽时返回 nullptr
+    ValuePtr outerBinding(const std::string& name) const {
+        if (isLocal(name)) {
+            return nullptr;
+        }
+        noteConsulted(name);
+        try {
+            return env.lookupBinding(name);
+        } catch (const LispError&) {
+            return nullptr;
+        }
+    }
+
+    // 变量的值在过程执行期间不会改变，读取它的位置可以移动：不是过程体中 set! 的目标，
+    // 且是局部变量、外层未装箱的局部绑定（被修改的外层绑定都已装箱）或未被修改过的全局过程
+    bool stable(const std::string& name) const {
+        if (!assigned || assigned->isAssigned(name)) {
+            return false;
+        }
+        if (isLocal(name)) {
+            return true;
+        }
+        noteConsulted(name);
+        for (EvalEnv* frame = &env; frame->parent && !frame->toplevel; frame = frame->parent.get()) {
+            auto it = frame->symbol_map.find(name);
+            if (it != frame->symbol_map.end()) {
+                return typeid(*it->second) != typeid(BoxValue);
+            }
+        }
+        ValuePtr value = dynamic_bindings ? nullptr : globalBinding(name);
+        return value && value->isProcedure() && !isAssignedGlobal(name);
+    }
+
+    // 对 elements[from..] 逐个折叠；没有变化时返回 false
+    bool foldElements(std::vector<ValuePtr>& elements, size_t from) {
+        bool changed = false;
+        for (size_t i = from; i < elements.size(); ++i) {
+            ValuePtr folded = fold(elements[i]);
+            if (folded != elements[i]) {
+                elements[i] = std::move(folded);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    static ValuePtr rebuild(const ValuePtr& original, std::vector<ValuePtr>& elements, bool changed) {
+        return changed ? toList(elements) : original;
+    }
+
+    ValuePtr bindGlobals(const ValuePtr& expr) {
+        if (auto name = symbolName(expr)) {
+            if (shadowed(*name)) {
+                return expr;
+            }
+            ValuePtr symbol = create_or_get_symbol(*name);
+            return std::make_shared<GlobalRefValue>(root().globalCell(static_cast<SymbolValue&>(*symbol)), symbol);
+        }
+        if (!expr->isPair() || literalValue(expr)) {
+            return expr;
+        }
+        std::vector<ValuePtr> elements;
+        try {
+            elements = expr->toVector();
+        } catch (const std::exception&) {
+            return expr;
+        }
+        auto op = symbolName(elements[0]);
+        size_t from = 0;
+        if (op && SPECIAL_FORMS.count(*op)) {
+            if (*op == "define") {
+                if (elements.size() != 3 || !elements[1]->isSymbol()) {
+                    return expr;
+                }
+                from = 2;
+            } else if (*op == "cond") {
+                bool changed = false;
+                for (size_t i = 1; i < elements.size(); ++i) {
+                    std::vector<ValuePtr> clause;
+                    try {
+                        clause = elements[i]->toVector();
+                    } catch (const std::exception&) {
+                        return expr;
+                    }
+                    auto head = symbolName(clause[0]);
+                    if (bindElements(clause, head && *head == "else" ? 1 : 0)) {
+                        elements[i] = toList(clause);
+                        changed = true;
+                    }
+                }
+                return rebuild(expr, elements, changed);
+            } else if ((*op == "let" && elements.size() >= 4 && elements[1]->isSymbol()) ||
+                       (*op == "do" && elements.size() >= 3)) {
+                try {
+                    return foldLoop(expr, *op, elements, &Folder::bindGlobals);
+                } catch (const std::exception&) {
+                    return expr;
+                }
+            } else if (*op == "let" && elements.size() >= 3) {
+                std::vector<std::string> names;
+                std::vector<ValuePtr> bindings;
+                bool changed = false;
+                try {
+                    bindings = elements[1]->toVector();
+                    for (auto& binding : bindings) {
+                        std::vector<ValuePtr> pair = binding->toVector();
+                        if (pair.size() != 2 || !pair[0]->isSymbol()) {
+                            return expr;
+                        }
+                        names.push_back(*pair[0]->asSymbol());
+                        if (bindElements(pair, 1)) {
+                            binding = toList(pair);
+                            changed = true;
+                        }
+                    }
+                } catch (const std::exception&) {
+                    return expr;
+                }
+                if (changed) {
+                    elements[1] = toList(bindings);
+                }
+                size_t mark = scope.size();
+                scope.insert(scope.end(), names.begin(), names.end());
+                std::vector<ValuePtr> body(elements.begin() + 2, elements.end());
+                std::vector<ValuePtr> bound = bindGlobalsInBody(body);
+                scope.resize(mark);
+                for (size_t i = 0; i < bound.size(); ++i) {
+                    if (bound[i] != body[i]) {
+                        elements[i + 2] = bound[i];
+                        changed = true;
+                    }
+                }
+                return rebuild(expr, elements, changed);
+            } else if (*op == "if" || *op == "and" || *op == "or" || *op == "begin" ||
+                       (*op == "set!" && elements.size() == 3)) {
+                from = 1;
+            } else {
+                return expr;
+            }
+        } else if (op) {
+            ValuePtr binding = outerBinding(*op);
+            if (isMacro(binding)) {
+                return expr;
+            }
+        }
+        return rebuild(expr, elements, bindElements(elements, from));
+    }
+
+    // 对命名 let 或 do 的各部分应用 transform（fold 或 bindGlobals）：初值在外层作用域中，
+    // 其余部分在绑定了循环名与循环变量的作用域中
+    ValuePtr foldLoop(const ValuePtr& expr, const std::string& op, std::vector<ValuePtr>& elements,
+                      ValuePtr (Folder::*transform)(const ValuePtr&)) {
+        bool named = op == "let";
+        size_t bindings_at = named ? 2 : 1;
+        std::vector<ValuePtr> bindings = elements[bindings_at]->toVector();
+        std::vector<std::string> names;
+        if (named) {
+            names.push_back(*elements[1]->asSymbol());
+        }
+        bool changed = false;
+        for (auto& binding : bindings) {
+            std::vector<ValuePtr> parts = binding->toVector();
+            if (parts.size() < 2 || parts.size() > (named ? 2u : 3u) || !parts[0]->isSymbol()) {
+                return expr;
+            }
+            names.push_back(*parts[0]->asSymbol());
+            ValuePtr init = (this->*transform)(parts[1]);
+            if (init != parts[1]) {
+                parts[1] = init;
+                binding = toList(parts);
+                changed = true;
+            }
+        }
+        size_t mark = scope.size();
+        scope.insert(scope.end(), names.begin(), names.end());
+        std::vector<ValuePtr> body(elements.begin() + bindings_at + 1, elements.end());
+        for (const auto& expr_in_body : body) {
+            collect_definitions(expr_in_body, scope);
+        }
+        auto apply = [&](ValuePtr& target) {
+            ValuePtr result = (this->*transform)(target);
+            if (result != target) {
+                target = result;
+                return true;
+            }
+            return false;
+        };
+        if (!named) {
+            for (auto& binding : bindings) {
+                std::vector<ValuePtr> parts = binding->toVector();
+                if (parts.size() == 3 && apply(parts[2])) {
+                    binding = toList(parts);
+                    changed = true;
+                }
+            }
+            std::vector<ValuePtr> exit_clause = elements[2]->toVector();
+            bool exit_changed = false;
+            for (auto& part : exit_clause) {
+                exit_changed |= apply(part);
+            }
+            if (exit_changed) {
+                elements[2] = toList(exit_clause);
+                changed = true;
+            }
+        }
+        for (size_t i = 0; i < body.size(); ++i) {
+            if (apply(body[i])) {
+                elements[bindings_at + 1 + i] = body[i];
+                changed = true;
+            }
+        }
+        scope.resize(mark);
+        if (changed) {
+            elements[bindings_at] = toList(bindings);
+        }
+        return rebuild(expr, elements, changed);
+    }
+
+    bool bindElements(std::vector<ValuePtr>& elements, size_t from) {
+        bool changed = false;
+        for (size_t i = from; i < elements.size(); ++i) {
+            ValuePtr bound = bindGlobals(elements[i]);
+            if (bound != elements[i]) {
+                elements[i] = std::move(bound);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+public:
+    // 逃逸分析：表达式求值时当前调用帧是否可能在过程返回后仍被引用。
+    // 创建无法做闭包转换的闭包、调用宏（展开结果未知）以及引用 eval、spawn 等会保留调用处环境的内建过程时，
+    // 帧可能逃逸；不认识的特殊形式也按逃逸处理。
+    bool mayEscape(const ValuePtr& expr) const {
+        if (auto name = symbolName(expr)) {
+            ValuePtr binding = outerBinding(*name);
+            return binding && typeid(*binding) == typeid(BuiltinProcValue) &&
+                   static_cast<BuiltinProcValue&>(*binding).get_descriptor().capturesEnv();
+        }
+        if (!expr->isPair()) {
+            return false;
+        }
+        if (literalValue(expr)) {
+            return false;
+        }
+        std::vector<ValuePtr> elements;
+        try {
+            elements = expr->toVector();
+        } catch (const std::exception&) {
+            return true;
+        }
+        size_t from = 0;
+        if (auto op = symbolName(elements[0])) {
+            if (SPECIAL_FORMS.count(*op)) {
+                static const std::unordered_set<std::string> local_forms{
+                    "if",  "and",        "or",    "begin",      "cond",        "let",    "do",
+                    "define", "set!", "quasiquote", "guard", "let-values", "let*-values", "receive"};
+                bool creates_closure = *op == "lambda" || (*op == "define" && elements.size() > 1 && elements[1]->isPair());
+                if (creates_closure) {
+                    // 平坦闭包只复制自由变量，不引用当前帧
+                    FreeVariables free(env);
+                    return !free.walkLambda({}, {expr});
+                }
+                if (*op == "let" && elements.size() > 1 && elements[1]->isSymbol()) {
+                    // 命名 let 可能创建局部过程，同样要求能做闭包转换
+                    FreeVariables free(env);
+                    if (!free.walkLambda({}, {expr})) {
+                        return true;
+                    }
+                }
+                if (!local_forms.count(*op)) {
+                    return true;
+                }
+                from = 1;
+            } else {
+                ValuePtr binding = outerBinding(*op);
+                if (isMacro(binding)) {
+                    return true;
+                }
+            }
+        }
+        return std::any_of(elements.begin() + from, elements.end(), [this](const ValuePtr& e) { return mayEscape(e); });
+    }
+
+    ValuePtr fold(const ValuePtr& expr) {
+        if (!expr->isPair()) {
+            return expr;
+        }
+        try {
+            return foldPair(expr);
+        } catch (const std::exception&) {
+            // 结构不合法的表达式保持原样，由求值器报告错误
+            return expr;
+        }
+    }
+
+private:
+    ValuePtr foldPair(const ValuePtr& expr) {
+        std::vector<ValuePtr> elements = expr->toVector();
+        auto op = symbolName(elements[0]);
+        if (op && SPECIAL_FORMS.count(*op)) {
+            return foldSpecialForm(expr, *op, elements);
+        }
+        if (op) {
+            ValuePtr binding = outerBinding(*op);
+            if (isMacro(binding)) {
+                // 宏的实参是语法，不能改写；能预先展开时折叠展开的结果
+                ValuePtr expanded =
+                    templates_only || dynamic_bindings ? nullptr : expandMacro(*op, binding, expr, elements);
+                if (!expanded) {
+                    return expr;
+                }
+                ++expand_depth;
+                ValuePtr result = fold(expanded);
+                --expand_depth;
+                return result;
+            }
+        }
+        bool changed = foldElements(elements, op ? 1 : 0);
+        if (templates_only || dynamic_bindings) {
+            return rebuild(expr, elements, changed);
+        }
+        if (op) {
+            if (ValuePtr folded = foldCall(*op, elements)) {
+                return folded;
+            }
+            if (ValuePtr inlined = inlineCall(*op, elements)) {
+                return inlined;
+            }
+        } else if (ValuePtr inlined = inlineImmediate(elements)) {
+            return inlined;
+        }
+        return rebuild(expr, elements, changed);
+    }
+
+    // 在优化时展开全局宏的调用。syntax-rules 宏的展开不依赖任何绑定，总可以预先展开；
+    // define-macro 的宏体只能引用它的形参、未被调用处遮蔽的全局变量和纯内建过程，
+    // 这样展开结果与在调用处求值宏体时相同。宏本身或宏体用到的全局变量被重新定义时优化结果失效。
+    // 不满足条件或展开出错时返回 nullptr，留到运行时展开。
+    ValuePtr expandMacro(const std::string& op, const ValuePtr& binding, const ValuePtr& expr,
+                         const std::vector<ValuePtr>& elements) {
+        if (expand_depth >= EXPAND_DEPTH_LIMIT || shadowed(op)) {
+            return nullptr;
+        }
+        if (typeid(*binding) == typeid(SyntaxRulesValue)) {
+            try {
+                ValuePtr expanded = static_cast<SyntaxRulesValue&>(*binding).rules->expand(expr);
+                noteDependency(op);
+                return expanded;
+            } catch (const std::exception&) {
+                return nullptr;
+            }
+        }
+        auto& macro = static_cast<MacroValue&>(*binding);
+        if (macro.params.size() != elements.size() - 1) {
+            return nullptr;
+        }
+        FreeVariables free(env);
+        if (!free.walkLambda(macro.params, {macro.body})) {
+            return nullptr;
+        }
+        for (const auto& name : free.names) {
+            // 展开在优化时进行，宏体只能调用没有副作用的内建过程
+            ValuePtr value = globalBinding(name);
+            if (!value || (value->isProcedure() && (typeid(*value) != typeid(BuiltinProcValue) ||
+                                                    !static_cast<BuiltinProcValue&>(*value).get_descriptor().isPure()))) {
+                return nullptr;
+            }
+        }
+        auto macro_env = std::make_shared<EvalEnv>(root().shared_from_this());
+        for (size_t i = 0; i < macro.params.size(); ++i) {
+            macro_env->defineBinding(macro.params[i], elements[i + 1]);
+        }
+        ValuePtr expanded;
+        try {
+            refresh_macro(macro, root());
+            expanded = macro_env->eval(macro.code);
+        } catch (const std::exception&) {
+            return nullptr;
+        }
+        noteDependency(op);
+        for (const auto& name : free.names) {
+            noteDependency(name);
+        }
+        return expanded;
+    }
+
+    // 名字被过程内部或外层过程的局部绑定遮蔽
+    bool shadowed(const std::string& name) const {
+        if (isLocal(name)) {
+            return true;
+        }
+        noteConsulted(name);
+        for (EvalEnv* frame = &env; frame->parent; frame = frame->parent.get()) {
+            if (frame->symbol_map.count(name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 名字在全局环境中的绑定；被局部绑定遮蔽或未绑定时返回 nullptr
+    ValuePtr globalBinding(const std::string& name) const {
+        if (shadowed(name)) {
+            return nullptr;
+        }
+        return root().globalValue(static_cast<SymbolValue&>(*create_or_get_symbol(name)));
+    }
+
+    EvalEnv& root() const {
+        EvalEnv* root = &env;
+        while (root->parent) {
+            root = root->parent.get();
+        }
+        return *root;
+    }
+
+    // 检查过程体能否内联：只含调用、if、and、or、begin、cond 与 quote，不引用宏、过程自身
+    // 以及 eval 等使用调用处环境的内建过程，且（capture 为真时）自由变量不会被调用处的局部绑定捕获
+    bool inlinable(const ValuePtr& expr, const std::vector<std::string>& params, const std::string* self,
+                   bool capture, size_t& size) const {
+        if (++size > INLINE_SIZE_LIMIT) {
+            return false;
+        }
+        if (auto name = symbolName(expr)) {
+            if (std::find(params.begin(), params.end(), *name) != params.end()) {
+                return true;
+            }
+            if ((self && *name == *self) || (capture && shadowed(*name))) {
+                return false;
+            }
+            ValuePtr binding = globalBinding(*name);
+            if (binding && typeid(*binding) == typeid(BuiltinProcValue) &&
+                static_cast<BuiltinProcValue&>(*binding).get_descriptor().capturesEnv()) {
+                return false;
+            }
+            return !isMacro(binding);
+        }
+        if (!expr->isPair()) {
+            return true;
+        }
+        if (literalValue(expr)) {
+            return true;
+        }
+        std::vector<ValuePtr> elements = expr->toVector();
+        size_t from = 0;
+        if (auto op = symbolName(elements[0]); op && SPECIAL_FORMS.count(*op)) {
+            if (*op != "if" && *op != "and" && *op != "or" && *op != "begin" && *op != "cond") {
+                return false;
+            }
+            from = 1;
+        }
+        for (size_t i = from; i < elements.size(); ++i) {
+            if (!inlinable(elements[i], params, self, capture, size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 按求值顺序记录形参的出现位置；if、and、or、cond 中不一定被求值的部分 strict 为假
+    static void collectOccurrences(const ValuePtr& expr, const std::vector<std::string>& params, bool strict,
+                                   std::vector<Occurrence>& out) {
+        if (auto name = symbolName(expr)) {
+            auto it = std::find(params.begin(), params.end(), *name);
+            if (it != params.end()) {
+                out.push_back({static_cast<size_t>(it - params.begin()), strict});
+            }
+            return;
+        }
+        if (!expr->isPair() || literalValue(expr)) {
+            return;
+        }
+        std::vector<ValuePtr> elements = expr->toVector();
+        auto op = symbolName(elements[0]);
+        if (op && (*op == "if" || *op == "and" || *op == "or")) {
+            for (size_t i = 1; i < elements.size(); ++i) {
+                collectOccurrences(elements[i], params, strict && i == 1, out);
+            }
+        } else if (op && *op == "cond") {
+            for (size_t i = 1; i < elements.size(); ++i) {
+                std::vector<ValuePtr> clause = elements[i]->toVector();
+                for (size_t j = 0; j < clause.size(); ++j) {
+                    collectOccurrences(clause[j], params, strict && i == 1 && j == 0, out);
+                }
+            }
+        } else {
+            for (size_t i = (op && *op == "begin") ? 1 : 0; i < elements.size(); ++i) {
+                collectOccurrences(elements[i], params, strict, out);
+            }
+        }
+    }
+
+    static ValuePtr substitute(const ValuePtr& expr, const std::vector<std::string>& params,
+                               const std::vector<ValuePtr>& args) {
+        if (auto name = symbolName(expr)) {
+            auto it = std::find(params.begin(), params.end(), *name);
+            return it == params.end() ? expr : args[it - params.begin()];
+        }
+        if (!expr->isPair() || literalValue(expr)) {
+            return expr;
+        }
+        std::vector<ValuePtr> elements = expr->toVector();
+        for (auto& element : elements) {
+            element = substitute(element, params, args);
+        }
+        return toList(elements);
+    }
+
+    // 没有副作用、可以移到别处求值的表达式：字面量、值不会改变的变量，以及实参均满足条件的纯内建过程调用
+    bool isPure(const ValuePtr& expr) const {
+        if (auto name = symbolName(expr)) {
+            return stable(*name);
+        }
+        if (!expr->isPair() || literalValue(expr)) {
+            return true;
+        }
+        std::vector<ValuePtr> elements = expr->toVector();
+        auto op = symbolName(elements[0]);
+        if (!op || SPECIAL_FORMS.count(*op) || dynamic_bindings) {
+            return false;
+        }
+        ValuePtr binding = outerBinding(*op);
+        if (!binding || typeid(*binding) != typeid(BuiltinProcValue) ||
+            !static_cast<BuiltinProcValue&>(*binding).get_descriptor().isPure()) {
+            return false;
+        }
+        return std::all_of(elements.begin() + 1, elements.end(), [this](const ValuePtr& arg) { return isPure(arg); });
+    }
+
+    // 把 (lambda params body) 对 args 的调用改写为代入实参后的 body；不满足条件时返回 nullptr。
+    // 值不会改变的变量实参可以任意代入；其他实参必须没有副作用、在过程体中恰好出现一次且一定会被求值，
+    // 并且这些实参的求值顺序保持不变。
+    ValuePtr betaReduce(const std::vector<std::string>& params, const ValuePtr& body,
+                        const std::vector<ValuePtr>& args, const std::string* self, bool capture) {
+        if (inline_depth >= INLINE_DEPTH_LIMIT || params.size() != args.size()) {
+            return nullptr;
+        }
+        size_t size = 0;
+        if (!inlinable(body, params, self, capture, size)) {
+            return nullptr;
+        }
+        std::vector<Occurrence> occurrences;
+        collectOccurrences(body, params, true, occurrences);
+        size_t last_moved = 0;
+        bool moved_any = false;
+        for (size_t i = 0; i < params.size(); ++i) {
+            if (auto name = symbolName(args[i])) {
+                if (!isLocal(*name) && !outerBinding(*name)) {
+                    return nullptr;  // 未绑定的变量须在运行时报错
+                }
+                if (!stable(*name)) {
+                    return nullptr;  // 代入后读取的可能是被 set! 修改之后的值
+                }
+                continue;
+            }
+            if (isTrivial(args[i])) {
+                continue;
+            }
+            size_t count = 0;
+            bool strict = false;
+            for (const auto& occurrence : occurrences) {
+                if (occurrence.param == i) {
+                    ++count;
+                    strict = occurrence.strict;
+                }
+            }
+            if (count != 1 || !strict || !isPure(args[i])) {
+                return nullptr;
+            }
+        }
+        for (const auto& occurrence : occurrences) {
+            if (isTrivial(args[occurrence.param])) {
+                continue;
+            }
+            if (moved_any && occurrence.param < last_moved) {
+                return nullptr;
+            }
+            last_moved = occurrence.param;
+            moved_any = true;
+        }
+        ++inline_depth;
+        ValuePtr result = fold(substitute(body, params, args));
+        --inline_depth;
+        return result;
+    }
+
+    // 调用全局定义的小过程时内联其过程体
+    ValuePtr inlineCall(const std::string& op, const std::vector<ValuePtr>& elements) {
+        ValuePtr binding = globalBinding(op);
+        if (!binding || typeid(*binding) != typeid(LambdaValue)) {
+            return nullptr;
+        }
+        auto& callee = static_cast<LambdaValue&>(*binding);
+        if (callee.source_body.size() != 1 || !callee.captured_env || callee.captured_env->parent) {
+            return nullptr;
+        }
+        std::vector<ValuePtr> args(elements.begin() + 1, elements.end());
+        ValuePtr result = betaReduce(callee.params, callee.source_body[0], args, &op, true);
+        if (result) {
+            noteDependency(op);
+        }
+        return result;
+    }
+
+    // ((lambda (params) body) args)
+    ValuePtr inlineImmediate(const std::vector<ValuePtr>& elements) {
+        if (!elements[0]->isPair()) {
+            return nullptr;
+        }
+        std::vector<ValuePtr> lambda = elements[0]->toVector();
+        auto op = symbolName(lambda[0]);
+        if (!op || *op != "lambda" || lambda.size() != 3) {
+            return nullptr;
+        }
+        std::vector<std::string> params = get_parameter_names(lambda[1]);
+        std::vector<ValuePtr> args(elements.begin() + 1, elements.end());
+        return betaReduce(params, lambda[2], args, nullptr, false);
+    }
+
+    ValuePtr foldSpecialForm(const ValuePtr& expr, const std::string& op, std::vector<ValuePtr>& elements) {
+        if (op == "if" || op == "and" || op == "or" || op == "begin") {
+            return rebuild(expr, elements, foldElements(elements, 1));
+        }
+        if (op == "define") {
+            // 函数定义的过程体在它自己的 define 执行时优化
+            if (elements.size() == 3 && elements[1]->isSymbol()) {
+                return rebuild(expr, elements, foldElements(elements, 2));
+            }
+            return expr;
+        }
+        if (op == "set!") {
+            if (elements.size() != 3) {
+                return expr;
+            }
+            if (auto name = symbolName(elements[1]); name && !templates_only && !shadowed(*name)) {
+                noteAssignedGlobal(*name);
+            }
+            return rebuild(expr, elements, foldElements(elements, 2));
+        }
+        if (op == "cond") {
+            bool changed = false;
+            for (size_t i = 1; i < elements.size(); ++i) {
+                std::vector<ValuePtr> clause = elements[i]->toVector();
+                if (foldElements(clause, 0)) {
+                    elements[i] = toList(clause);
+                    changed = true;
+                }
+            }
+            return rebuild(expr, elements, changed);
+        }
+        if ((op == "let" && elements.size() >= 4 && elements[1]->isSymbol()) || (op == "do" && elements.size() >= 3)) {
+            return foldLoop(expr, op, elements, &Folder::fold);
+        }
+        if (op == "let" && elements.size() >= 3) {
+            bool changed = false;
+            std::vector<ValuePtr> bindings = elements[1]->toVector();
+            std::vector<std::string> names;
+            for (auto& binding : bindings) {
+                std::vector<ValuePtr> pair = binding->toVector();
+                if (pair.size() != 2 || !pair[0]->isSymbol()) {
+                    return expr;
+                }
+                names.push_back(*pair[0]->asSymbol());
+                if (foldElements(pair, 1)) {
+                    binding = toList(pair);
+                    changed = true;
+                }
+            }
+            if (elements.size() == 3 && !templates_only) {
+                std::vector<ValuePtr> inits;
+                for (const auto& binding : bindings) {
+                    inits.push_back(binding->toVector()[1]);
+                }
+                if (ValuePtr inlined = betaReduce(names, elements[2], inits, nullptr, false)) {
+                    return inlined;
+                }
+            }
+            if (changed) {
+                elements[1] = toList(bindings);
+            }
+            size_t mark = scope.size();
+            for (const auto& name : names) {
+                bind(name);
+            }
+            std::vector<ValuePtr> body(elements.begin() + 2, elements.end());
+            std::vector<ValuePtr> folded = foldBody(body);
+            scope.resize(mark);
+            for (size_t i = 0; i < folded.size(); ++i) {
+                if (folded[i] != body[i]) {
+                    elements[i + 2] = folded[i];
+                    changed = true;
+                }
+            }
+            return rebuild(expr, elements, changed);
+        }
+        if (op == "quasiquote" && elements.size() == 2) {
+            ValuePtr code = compileTemplate(elements[1], 0);
+            return code ? code : toLiteral(elements[1]);
+        }
+        // quote、lambda、define-macro 等保持原样
+        return expr;
+    }
+
+    // 把 quasiquote 模板编译为构造代码：直接调用内建的 cons 与 append（不受同名全局变量重新定义的影响），
+    // 不含 unquote 的子结构作为常量共享，只在通向 unquote、unquote-splicing 的路径上分配。
+    // 与 EvalEnv::expandQuasiquote 的语义相同；模板中没有需要求值的部分时返回 nullptr。
+    ValuePtr compileTemplate(const ValuePtr& tmpl, int level) {
+        if (typeid(*tmpl) == typeid(VectorValue)) {
+            std::vector<ValuePtr> elements = static_cast<VectorValue&>(*tmpl).elements;
+            ValuePtr code = compileTemplate(toList(elements), level);
+            if (!code) {
+                return nullptr;
+            }
+            std::vector<ValuePtr> call{get_builtin_procedures().at("list->vector"), code};
+            return toList(call);
+        }
+        if (!tmpl->isPair()) {
+            return nullptr;
+        }
+        auto& pair = static_cast<PairValue&>(*tmpl);
+        switch (template_keyword(tmpl)) {
+            case TemplateKeyword::UNQUOTE:
+                if (level == 0) {
+                    return fold(template_operand(tmpl));
+                }
+                --level;
+                break;
+            case TemplateKeyword::UNQUOTE_SPLICING:
+                if (level == 0) {
+                    throw LispError("unquote-splicing: must appear inside a list template");
+                }
+                --level;
+                break;
+            case TemplateKeyword::QUASIQUOTE:
+                ++level;
+                break;
+            case TemplateKeyword::NONE:
+                break;
+        }
+        if (level == 0 && template_keyword(pair.l) == TemplateKeyword::UNQUOTE_SPLICING) {
+            ValuePtr spliced = fold(template_operand(pair.l));
+            ValuePtr rest = compileTemplate(pair.r, level);
+            if (!rest && pair.r->isNil()) {
+                return spliced;
+            }
+            return construct("append", spliced, rest ? rest : toLiteral(pair.r));
+        }
+        ValuePtr car = compileTemplate(pair.l, level);
+        ValuePtr cdr = compileTemplate(pair.r, level);
+        if (!car && !cdr) {
+            return nullptr;
+        }
+        return construct("cons", car ? car : toLiteral(pair.l), cdr ? cdr : toLiteral(pair.r));
+    }
+
+    static ValuePtr construct(const char* builtin, const ValuePtr& first, const ValuePtr& second) {
+        std::vector<ValuePtr> call{get_builtin_procedures().at(builtin), first, second};
+        return toList(call);
+    }
+
+    // 实参都是字面量的纯内建过程调用：在此求值，返回结果的字面量表达式
+    ValuePtr foldCall(const std::string& op, const std::vector<ValuePtr>& elements) {
+        ValuePtr binding = outerBinding(op);
+        if (!binding || typeid(*binding) != typeid(BuiltinProcValue)) {
+            return nullptr;
+        }
+        const auto& builtin = static_cast<BuiltinProcValue&>(*binding).get_descriptor();
+        if (!builtin.isPure() || !builtin.accepts(elements.size() - 1)) {
+            return nullptr;
+        }
+        std::vector<ValuePtr> args;
+        args.reserve(elements.size() - 1);
+        for (size_t i = 1; i < elements.size(); ++i) {
+            ValuePtr value = literalValue(elements[i]);
+            if (!value) {
+                return nullptr;
+            }
+            args.push_back(std::move(value));
+        }
+        try {
+            ValuePtr result = builtin.fn(args, env);
+            if (result->isPair()) {
+                // 每次调用都应得到新的序对（eq? 可以区分），不能共享同一个常量
+                return nullptr;
+            }
+            return toLiteral(result);
+        } catch (const std::exception&) {
+            // 出错的调用留到运行时再报告
+            return nullptr;
+        }
+    }
+};
+
+// 分析与优化结果所依赖的一个外部绑定的形态：是否被局部绑定（是否装箱），
+// 以及局部绑定的值为内建过程或宏时是哪一个（折叠、内联会依据它们改写）。全局绑定的值由重定义计数负责
+struct BindingShape {
+    enum class Kind : unsigned char { Global, Local, Boxed };
+    Kind kind = Kind::Global;
+    const void* tag = nullptr;
+    bool operator==(const BindingShape&) const = default;
+};
+
+BindingShape bindingShape(EvalEnv& env, const std::string& name) {
+    for (EvalEnv* frame = &env; frame->parent; frame = frame->parent.get()) {
+        auto it = frame->symbol_map.find(name);
+        if (it == frame->symbol_map.end()) {
+            continue;
+        }
+        BindingShape shape{BindingShape::Kind::Local, nullptr};
+        const ValuePtr* value = &it->second;
+        if (typeid(**value) == typeid(BoxValue)) {
+            shape.kind = BindingShape::Kind::Boxed;
+            value = &static_cast<BoxValue&>(**value).value;
+        }
+        if (*value && typeid(**value) == typeid(BuiltinProcValue)) {
+            shape.tag = &static_cast<BuiltinProcValue&>(**value).get_descriptor();
+        } else if (isMacro(*value)) {
+            shape.tag = value->get();
+        }
+        return shape;
+    }
+    return {};
+}
+
+struct EnvShape {
+    const EvalEnv* root = nullptr;
+    bool toplevel_session = false;
+    std::vector<std::string> names;
+    std::vector<BindingShape> bindings;
+};
+
+const EvalEnv* rootOf(const EvalEnv& env) {
+    const EvalEnv* root = &env;
+    while (root->parent) {
+        root = root->parent.get();
+    }
+    return root;
+}
+
+EnvShape captureShape(EvalEnv& env, std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    EnvShape shape{rootOf(env), inToplevelSession(env), std::move(names), {}};
+    shape.bindings.reserve(shape.names.size());
+    for (const auto& name : shape.names) {
+        shape.bindings.push_back(bindingShape(env, name));
+    }
+    return shape;
+}
+
+bool matchesShape(EvalEnv& env, const EnvShape& shape) {
+    if (rootOf(env) != shape.root || inToplevelSession(env) != shape.toplevel_session) {
+        return false;
+    }
+    for (size_t i = 0; i < shape.names.size(); ++i) {
+        if (!(bindingShape(env, shape.names[i]) == shape.bindings[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 同一个 lambda 表达式每次求值创建的过程共用的自由变量分析与优化结果。
+// 只在重定义计数未变、且新过程所在环境中相关绑定的形态与得出结果时相同的情况下复用
+struct FormCache {
+    // 用于确认是同一个表达式：只比较控制块，表达式释放后不会被新的对象冒用
+    std::vector<std::weak_ptr<Value>> body;
+    std::vector<std::string> params;
+    std::uint64_t epoch = 0;
+    // make_lambda 的自由变量分析
+    bool analyzed = false;
+    bool known = false;
+    std::vector<std::string> free_names;
+    std::vector<std::string> assigned;
+    EnvShape analysis_shape;
+    // refresh_lambda 的优化结果
+    std::shared_ptr<const LambdaCode> code;
+    EnvShape code_shape;
+
+    bool sameForm(const std::vector<std::string>& other_params, const std::vector<ValuePtr>& other_body) const {
+        if (params != other_params || body.size() != other_body.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < body.size(); ++i) {
+            if (body[i].owner_before(other_body[i]) || other_body[i].owner_before(body[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool expired() const {
+        return std::any_of(body.begin(), body.end(), [](const std::weak_ptr<Value>& e) { return e.expired(); });
+    }
+};
+
+constexpr size_t FORM_CACHE_SWEEP_MIN = 1024;
+
+// 按过程体第一个表达式的地址索引。表达式被释放的项在表增长一倍时清除
+thread_local std::unordered_map<const Value*, FormCache> form_cache;
+thread_local size_t form_cache_sweep_at = FORM_CACHE_SWEEP_MIN;
+
+FormCache* formCache(const std::vector<std::string>& params, const std::vector<ValuePtr>& body) {
+    if (body.empty()) {
+        return nullptr;
+    }
+    if (form_cache.size() >= form_cache_sweep_at) {
+        std::erase_if(form_cache, [](const auto& item) { return item.second.expired(); });
+        form_cache_sweep_at = std::max(FORM_CACHE_SWEEP_MIN, form_cache.size() * 2);
+    }
+    std::uint64_t current = epoch.load(std::memory_order_relaxed);
+    auto [it, inserted] = form_cache.try_emplace(body.front().get());
+    FormCache& form = it->second;
+    if (!inserted && !form.sameForm(params, body)) {
+        form = FormCache{};
+        inserted = true;
+    }
+    if (inserted) {
+        form.body.assign(body.begin(), body.end());
+        form.params = params;
+        form.epoch = current;
+    } else if (form.epoch != current) {
+        form.analyzed = false;
+        form.code = nullptr;
+        form.epoch = current;
+    }
+    return &form;
+}
+
+}  // namespace
+
+std::uint64_t redefinition_epoch() {
+    return epoch.load(std::memory_order_relaxed);
+}
+
+void note_definition(const std::string& name, const ValuePtr& value) {
+    // 名字成为 eval 等使用调用处环境的内建过程的别名时，之前的自由变量分析也不再成立
+    bool captures_env = typeid(*value) == typeid(BuiltinProcValue) &&
+                        static_cast<BuiltinProcValue&>(*value).get_descriptor().capturesEnv();
+    if (find_builtin(name) || isMacro(value) || captures_env || isDependency(name)) {
+        epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+namespace {
+
+// frame 及其外层的局部环境（不含全局环境与会话顶层环境）中是否绑定了 name
+bool boundInOuterFrame(EvalEnv* frame, const std::string& name) {
+    for (; frame && frame->parent && !frame->toplevel; frame = frame->parent.get()) {
+        if (frame->symbol_map.count(name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+void note_assignment(const std::string& name, const ValuePtr& value) {
+    noteAssignedGlobal(name);
+    note_definition(name, value);
+}
+
+std::shared_ptr<LambdaValue> make_lambda(std::string name, const std::vector<std::string>& params,
+                                         const std::vector<ValuePtr>& body, const std::shared_ptr<EvalEnv>& env) {
+    if (!env->parent || env->toplevel) {
+        return std::make_shared<LambdaValue>(std::move(name), params, body, env);
+    }
+    FormCache* form = formCache(params, body);
+    if (!form) {
+        return std::make_shared<LambdaValue>(std::move(name), params, body, env);
+    }
+    if (!form->analyzed || !matchesShape(*env, form->analysis_shape)) {
+        std::vector<std::string> consulted;
+        FreeVariables free(*env);
+        {
+            ConsultedScope scope(consulted);
+            form->known = free.walkLambda(params, body);
+        }
+        form->free_names = std::move(free.names);
+        form->assigned = std::move(free.assigned);
+        form->analysis_shape = captureShape(*env, std::move(consulted));
+        form->analyzed = true;
+    }
+    if (!form->known) {
+        return std::make_shared<LambdaValue>(std::move(name), params, body, env);
+    }
+    // 闭包转换：只复制在局部环境中绑定的自由变量，全局变量（包括会话顶层环境中的定义）仍在原处查找
+    EvalEnv* root = env.get();
+    while (root->parent && !root->toplevel) {
+        root = root->parent.get();
+    }
+    std::shared_ptr<EvalEnv> captured;
+    for (const auto& var : form->free_names) {
+        for (EvalEnv* frame = env.get(); frame != root; frame = frame->parent.get()) {
+            auto it = frame->symbol_map.find(var);
+            if (it != frame->symbol_map.end()) {
+                if (typeid(*it->second) == typeid(BoxValue) && !static_cast<BoxValue&>(*it->second).value &&
+                    boundInOuterFrame(frame->parent.get(), var)) {
+                    // 尚未执行的内部 define 之外还有同名的局部绑定，只能保留整个环境链
+                    return std::make_shared<LambdaValue>(std::move(name), params, body, env);
+                }
+                if (typeid(*it->second) != typeid(BoxValue) &&
+                    std::find(form->assigned.begin(), form->assigned.end(), var) != form->assigned.end()) {
+                    // 闭包要修改的绑定必须与外层共享；外层没有预先装箱时在这里装箱
+                    frame->boxBinding(var);
+                }
+                if (!captured) {
+                    captured = std::make_shared<EvalEnv>(root->shared_from_this());
+                }
+                captured->symbol_map.emplace(var, it->second);
+                break;
+            }
+        }
+    }
+    return std::make_shared<LambdaValue>(std::move(name), params, body,
+                                         captured ? captured : root->shared_from_this());
+}
+
+std::vector<std::string> internal_definitions(const std::vector<ValuePtr>& body) {
+    std::vector<std::string> names;
+    for (const auto& expr : body) {
+        collect_definitions(expr, names);
+    }
+    return names;
+}
+
+std::vector<std::string> assigned_captures(const std::vector<std::string>& names, const std::vector<ValuePtr>& body,
+                                           EvalEnv& env) {
+    if (names.empty() || std::none_of(body.begin(), body.end(), [](const ValuePtr& e) { return createsClosure(e); })) {
+        return {};
+    }
+    FreeVariables free(env);
+    if (!free.walkLambda(names, body)) {
+        return names;
+    }
+    std::vector<std::string> result;
+    std::copy_if(names.begin(), names.end(), std::back_inserter(result),
+                 [&](const std::string& name) { return free.isAssigned(name); });
+    return result;
+}
+
+void refresh_lambda(LambdaValue& lambda) {
+    std::uint64_t current = redefinition_epoch();
+    if (lambda.optimized_epoch == current) {
+        return;
+    }
+    FormCache* form = formCache(lambda.params, lambda.source_body);
+    if (form && form->code && matchesShape(*lambda.captured_env, form->code_shape)) {
+        lambda.code = form->code;
+        lambda.optimized_epoch = current;
+        return;
+    }
+    std::vector<std::string> consulted;
+    ConsultedScope scope(consulted);
+    auto fold = [&](const FreeVariables* assigned, bool dynamic) {
+        Folder folder(*lambda.captured_env);
+        folder.setAssigned(assigned);
+        folder.setDynamicBindings(dynamic);
+        for (const auto& param : lambda.params) {
+            folder.bind(param);
+        }
+        return folder.foldBody(lambda.source_body);
+    };
+    // 赋值分析：源过程体中的宏调用展开后才能看到其中的 set!，这时按展开结果重新折叠一次
+    FreeVariables source(*lambda.captured_env);
+    bool source_known = source.walkLambda(lambda.params, lambda.source_body);
+    LambdaCode code;
+    code.body = fold(source_known ? &source : nullptr, source.dynamic_bindings);
+    FreeVariables free(*lambda.captured_env);
+    bool known = free.walkLambda(lambda.params, code.body);
+    // 内联的结果中可能出现 eval 等，这时也要按可能引入新绑定重新折叠
+    bool dynamic = source.dynamic_bindings || free.dynamic_bindings;
+    bool newly_assigned = known && (!source_known || std::any_of(free.assigned.begin(), free.assigned.end(),
+                                                                 [&](const std::string& name) {
+                                                                     return !source.isAssigned(name);
+                                                                 }));
+    if (newly_assigned || dynamic != source.dynamic_bindings) {
+        code.body = fold(known ? &free : (source_known ? &source : nullptr), dynamic);
+    }
+    Folder folder(*lambda.captured_env);
+    for (const auto& param : lambda.params) {
+        folder.bind(param);
+    }
+    if (known && !dynamic && !inToplevelSession(*lambda.captured_env)) {
+        // 过程体不会在运行时引入新的局部绑定（没有宏调用、eval 等，也不经局部变量调用可能是 eval 的过程），
+        // 全局引用可以直接绑定到绑定格。会话顶层环境中随时可能出现新的定义遮蔽全局绑定，其中的过程体不做改写
+        code.body = folder.bindGlobalsInBody(code.body);
+    }
+    code.frame_escapes =
+        std::any_of(code.body.begin(), code.body.end(), [&](const ValuePtr& e) { return folder.mayEscape(e); });
+    if (std::any_of(code.body.begin(), code.body.end(), [](const ValuePtr& e) { return createsClosure(e); })) {
+        // 内部定义总是装箱；形参只在被 set! 修改时装箱，其余的由闭包直接复制值
+        code.boxed_bindings = internal_definitions(code.body);
+        for (const auto& param : lambda.params) {
+            if (!known || free.isAssigned(param)) {
+                code.boxed_bindings.push_back(param);
+            }
+        }
+    }
+    lambda.code = std::make_shared<const LambdaCode>(std::move(code));
+    lambda.optimized_epoch = current;
+    if (form) {
+        form->code = lambda.code;
+        form->code_shape = captureShape(*lambda.captured_env, std::move(consulted));
+    }
+}
+
+void refresh_macro(MacroValue& macro, EvalEnv& env) {
+    std::uint64_t current = redefinition_epoch();
+    if (macro.optimized_epoch == current) {
+        return;
+    }
+    Folder folder(env, true);
+    for (const auto& param : macro.params) {
+        folder.bind(param);
+    }
+    macro.code = folder.foldBody({macro.body})[0];
+    macro.optimized_epoch = current;
+}
+
+bool frame_may_escape(const std::vector<ValuePtr>& exprs, EvalEnv& env) {
+    Folder folder(env);
+    return std::any_of(exprs.begin(), exprs.end(), [&](const ValuePtr& e) { return folder.mayEscape(e); });
+}
+
+std::vector<ValuePtr> optimize_body(const std::vector<std::string>& params, const std::vector<ValuePtr>& body,
+                                    EvalEnv& env) {
+    FreeVariables free(env);
+    Folder folder(env);
+    folder.setAssigned(free.walkLambda(params, body) ? &free : nullptr);
+    folder.setDynamicBindings(free.dynamic_bindings);
+    for (const auto& param : params) {
+        folder.bind(param);
+    }
+    return folder.foldBody(body);
+}
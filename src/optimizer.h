@@ -0,0 +1,50 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "value.h"
+
+class EvalEnv;
+
+// 重定义计数。优化依赖于“某个名字绑定的是哪个内建过程、哪些名字是宏”，
+// 重新定义内建过程的名字或定义宏时计数递增，之前的优化结果随之失效。
+std::uint64_t redefinition_epoch();
+// define 等绑定名字时调用；必要时使优化结果失效
+void note_definition(const std::string& name, const ValuePtr& value);
+// set! 修改全局绑定时调用。第一次修改某个名字时使优化结果失效（优化把未被修改过的全局过程当作常量）
+void note_assignment(const std::string& name, const ValuePtr& value);
+
+// 创建过程。过程体在第一次调用时优化，那时它调用的全局过程通常都已定义。
+// 在局部环境中创建的过程做闭包转换：只复制过程体中自由变量的绑定（已装箱的绑定复制盒子），
+// 不再引用整个外层环境链；过程体可能访问整个环境（eval、宏等）时仍捕获 env。
+std::shared_ptr<LambdaValue> make_lambda(std::string name, const std::vector<std::string>& params,
+                                         const std::vector<ValuePtr>& body, const std::shared_ptr<EvalEnv>& env);
+// 调用前确认过程体的优化结果仍然有效，失效时从原始过程体重新优化（同一个 lambda 表达式创建的过程共用优化结果），并重新做逃逸分析
+// 和装箱分析（赋值转换）：过程体中有闭包时，内部定义在调用开始时即装箱，闭包可以先于定义捕获它们；
+// 被 set! 修改的形参也装箱，使闭包与过程体共享同一个绑定。其余形参不会改变，闭包直接复制它们的值
+void refresh_lambda(LambdaValue& lambda);
+// names 为 body 所在帧的绑定：其中需要装箱的（body 中有闭包，且该名字可能被 set! 修改）。
+// let、命名 let 与 do 据此决定哪些变量装箱
+std::vector<std::string> assigned_captures(const std::vector<std::string>& names, const std::vector<ValuePtr>& body,
+                                           EvalEnv& env);
+// 宏体只做 quasiquote 模板的编译（宏体在调用处的环境中求值，不能依据全局绑定做其他变换），
+// 结果存入 macro.code；定义了新的宏等情况下重新编译。env 用于判断哪些调用是宏调用
+void refresh_macro(MacroValue& macro, EvalEnv& env);
+// 在 env 中求值 exprs 时，env 这一帧是否可能在求值结束后仍被引用（命名 let 与 do 据此决定能否原地更新循环变量）
+bool frame_may_escape(const std::vector<ValuePtr>& exprs, EvalEnv& env);
+// 过程体中内部 define 的名字（包括 begin 中的）
+std::vector<std::string> internal_definitions(const std::vector<ValuePtr>& body);
+
+// 常量折叠：实参均为字面量的纯内建过程调用在优化时求值并替换为结果。
+// 内联：调用全局定义的小过程、直接调用 lambda 表达式以及 let 在条件允许时改写为代入实参后的过程体。
+// quasiquote 模板编译为直接调用内建 cons、append 的构造代码，常量部分共享。
+// 宏的预先展开：宏体只依赖形参、全局常量和纯内建过程的宏调用在优化时展开，调用处直接换成展开结果。
+// params 为过程的形参，env 为过程定义所在的环境。未改动的子表达式与 body 共享。
+std::vector<ValuePtr> optimize_body(const std::vector<std::string>& params, const std::vector<ValuePtr>& body,
+                                    EvalEnv& env);
+
+#endif
@@ -34,6 +34,9 @@ ValuePtr Parser::parse() {
         case TokenType::LEFT_PAREN: {
             return this->parseTails();
         }
+        case TokenType::VECTOR_BEGIN: {
+            return this->parseVector();
+        }
         case TokenType::QUOTE: {
             if (tokens.empty()) {
                 throw SyntaxError("Unexpected end of input after ' (quote). Expected an expression.");
@@ -64,6 +67,16 @@ ValuePtr Parser::parse() {
                 std::make_shared<PairValue>(expr, LISP_NIL)
             );
         }
+        case TokenType::UNQUOTE_SPLICING: {
+            if (tokens.empty()) {
+                throw SyntaxError("Unexpected end of input after ,@ (unquote-splicing). Expected an expression.");
+            }
+            ValuePtr expr = this->parse();
+            return std::make_shared<PairValue>(
+                create_or_get_symbol("unquote-splicing"),
+                std::make_shared<PairValue>(expr, LISP_NIL)
+            );
+        }
         case TokenType::RIGHT_PAREN:
             throw SyntaxError("Unexpected ')' token encountered. It should only appear within a list structure handled by parseTails.");
         case TokenType::DOT:
@@ -104,4 +117,21 @@ ValuePtr Parser::parseTails() {
         ValuePtr cdr_list_part = this->parseTails();
         return std::make_shared<PairValue>(car, cdr_list_part);
     }
-}
\ No newline at end of file
+}
+
+ValuePtr Parser::parseVector() {
+    std::vector<ValuePtr> elements;
+    while (true) {
+        if (tokens.empty()) {
+            throw SyntaxError("Unexpected end of input in vector literal: expected ')' or an element.");
+        }
+        if (tokens.front()->getType() == TokenType::RIGHT_PAREN) {
+            tokens.pop_front();
+            return std::make_shared<VectorValue>(std::move(elements));
+        }
+        if (tokens.front()->getType() == TokenType::DOT) {
+            throw SyntaxError("Unexpected '.' token in vector literal.");
+        }
+        elements.push_back(this->parse());
+    }
+}
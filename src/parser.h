@@ -12,6 +12,8 @@ public:
     Parser(std::deque<TokenPtr>tokens):tokens(std::move(tokens)){}
     ValuePtr parse();
     ValuePtr parseTails();
+    // #( 之后的元素直到 )，构造 VectorValue
+    ValuePtr parseVector();
     bool isAtEnd() const;
 };
 
@@ -0,0 +1,157 @@
+#include "port.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "error.h"
+#include "scheduler.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t READ_CHUNK_SIZE = 4096;
+// 不超过 PIPE_BUF，poll 报告可写后写入这么多字节不会阻塞
+constexpr size_t WRITE_CHUNK_SIZE = 512;
+
+[[noreturn]] void throwErrno(const std::string& what) {
+    throw LispError(what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+PortValue::PortValue(int fd, bool owns_fd) : fd(fd), owns_fd(owns_fd) {}
+
+PortValue::~PortValue() {
+    if (owns_fd) {
+        close();
+    }
+}
+
+std::string PortValue::toString() const {
+    return "#<port>";
+}
+
+bool PortValue::fill() {
+#ifdef _WIN32
+    throw LispError("port: not supported on this platform.");
+#else
+    if (isClosed()) {
+        throw LispError("port: read from a closed port.");
+    }
+    if (eof) {
+        return false;
+    }
+    Scheduler::current().waitIo(fd, POLLIN);
+    char chunk[READ_CHUNK_SIZE];
+    ssize_t n;
+    do {
+        n = ::read(fd, chunk, sizeof(chunk));
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throwErrno("port: read failed");
+    }
+    if (n == 0) {
+        eof = true;
+        return false;
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+    return true;
+#endif
+}
+
+std::optional<std::string> PortValue::readLine() {
+    size_t scanned = 0;
+    while (true) {
+        auto newline = buffer.find('\n', scanned);
+        if (newline != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            return line;
+        }
+        scanned = buffer.size();
+        if (!fill()) {
+            if (buffer.empty()) {
+                return std::nullopt;
+            }
+            return std::exchange(buffer, {});
+        }
+    }
+}
+
+std::optional<std::string> PortValue::readChunk() {
+    if (buffer.empty() && !fill()) {
+        return std::nullopt;
+    }
+    return std::exchange(buffer, {});
+}
+
+void PortValue::write(const std::string& data) {
+#ifdef _WIN32
+    throw LispError("port: not supported on this platform.");
+#else
+    if (isClosed()) {
+        throw LispError("port: write to a closed port.");
+    }
+    size_t written = 0;
+    while (written < data.size()) {
+        Scheduler::current().waitIo(fd, POLLOUT);
+        size_t len = std::min(WRITE_CHUNK_SIZE, data.size() - written);
+        ssize_t n = ::write(fd, data.data() + written, len);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            throwErrno("port: write failed");
+        }
+        written += static_cast<size_t>(n);
+    }
+#endif
+}
+
+void PortValue::close() {
+#ifndef _WIN32
+    if (fd >= 0 && owns_fd) {
+        ::close(fd);
+    }
+#endif
+    fd = -1;
+}
+
+PortPtr PortValue::openFile(const std::string& path, bool for_output) {
+#ifdef _WIN32
+    throw LispError("port: not supported on this platform.");
+#else
+    int flags = for_output ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY;
+    int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throwErrno("open: cannot open '" + path + "'");
+    }
+    return std::make_shared<PortValue>(fd);
+#endif
+}
+
+PortPtr PortValue::standardInput() {
+    thread_local PortPtr stdin_port = std::make_shared<PortValue>(0, false);
+    return stdin_port;
+}
+
+std::pair<PortPtr, PortPtr> PortValue::makePipe() {
+#ifdef _WIN32
+    throw LispError("port: not supported on this platform.");
+#else
+    int fds[2];
+    if (::pipe(fds) < 0) {
+        throwErrno("make-pipe: pipe failed");
+    }
+    for (int fd : fds) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return {std::make_shared<PortValue>(fds[0]), std::make_shared<PortValue>(fds[1])};
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef PORT_H
+#define PORT_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "value.h"
+
+// 基于文件描述符的端口。读写前先通过调度器等待 fd 就绪，
+// 因此在任务中调用不会阻塞其他任务。
+class PortValue : public Value {
+private:
+    int fd;
+    bool owns_fd;
+    std::string buffer;
+    bool eof = false;
+
+    bool fill();
+
+public:
+    PortValue(int fd, bool owns_fd = true);
+    ~PortValue() override;
+    std::string toString() const override;
+
+    int getFd() const {
+        return fd;
+    }
+    bool isClosed() const {
+        return fd < 0;
+    }
+    // 读取一行（不含换行符），到达文件末尾时返回 nullopt
+    std::optional<std::string> readLine();
+    // 读取当前可用的数据（至少 1 字节），到达文件末尾时返回 nullopt
+    std::optional<std::string> readChunk();
+    void write(const std::string& data);
+    void close();
+
+    static std::shared_ptr<PortValue> openFile(const std::string& path, bool for_output);
+    static std::shared_ptr<PortValue> standardInput();
+    // 返回 {读端, 写端}
+    static std::pair<std::shared_ptr<PortValue>, std::shared_ptr<PortValue>> makePipe();
+};
+
+using PortPtr = std::shared_ptr<PortValue>;
+
+#endif
@@ -0,0 +1,45 @@
+#include "runner.h"
+
+#include <sstream>
+
+#include "builtins.h"
+#include "error.h"
+#include "eval_env.h"
+#include "parser.h"
+#include "scheduler.h"
+#include "tokenizer.h"
+
+RunResult runCaptured(EvalEnv& env, const std::string& source) {
+    RunResult result;
+    std::ostringstream output;
+    {
+        OutputRedirect redirect(output);
+        ExitTrap trap;
+        try {
+            Parser parser(Tokenizer::tokenize(source));
+            ValuePtr last = nullptr;
+            while (!parser.isAtEnd()) {
+                auto value = parser.parse();
+                if (!value) {
+                    break;
+                }
+                last = env.eval(value);
+            }
+            if (last) {
+                result.value = last->toString();
+            }
+        } catch (const std::runtime_error& e) {
+            result.ok = false;
+            result.value = e.what();
+            result.exit_code = 1;
+        } catch (const ExitRequest& request) {
+            result.ok = request.code == 0;
+            result.value = "exit " + std::to_string(request.code);
+            result.exit_code = request.code;
+        }
+        // 脚本留下的任务、定时器与 I/O 等待不能在之后的脚本中运行
+        Scheduler::current().cancelAll();
+    }
+    result.output = output.str();
+    return result;
+}
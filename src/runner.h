@@ -0,0 +1,20 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <string>
+
+class EvalEnv;
+
+struct RunResult {
+    bool ok = true;
+    std::string output;  // display 等过程的输出
+    std::string value;   // 成功时为最后一个表达式的值，失败时为错误信息
+    int exit_code = 0;   // 脚本调用 (exit n) 时为 n，出错时为 1
+};
+
+// 在 env 中依次求值 source 里的全部表达式，并捕获当前线程的 Lisp 输出。
+// 期间 exit 只结束这段脚本，不会结束进程。
+// 结束时取消这段脚本留下的全部任务（见 Scheduler::cancelAll）
+RunResult runCaptured(EvalEnv& env, const std::string& source);
+
+#endif
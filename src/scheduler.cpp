@@ -0,0 +1,392 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "builtins.h"
+#include "error.h"
+#include "eval_env.h"
+#include "handler_stack.h"
+#include "stack_segments.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#endif
+
+namespace {
+
+constexpr size_t TASK_STACK_SIZE = 8 * 1024 * 1024;
+// 栈顶以下预留的空间，低于此位置即视为栈溢出
+constexpr size_t STACK_SAFETY_MARGIN = 64 * 1024;
+// switchOut 自身以及 swapcontext 栈帧的大小上界
+constexpr size_t SWITCH_FRAME_MARGIN = 256;
+
+// 取消任务时在它挂起处抛出，展开它的栈。不是 std::exception，不会被普通的错误处理拦截
+struct TaskCancelled {};
+
+bool wakesLater(const TaskPtr& a, const TaskPtr& b) {
+    return a->wake_time > b->wake_time;
+}
+
+}  // namespace
+
+#ifndef _WIN32
+struct TaskContext {
+    ucontext_t ctx;
+    bool started = false;
+    char* saved_sp = nullptr;
+    std::vector<char> saved_stack;
+    HandlerFrame* handlers = nullptr;  // 切出时任务的处理器栈，各层位于任务自己的栈上
+};
+#else
+struct TaskContext {};
+#endif
+
+TaskValue::TaskValue(ValuePtr proc, std::shared_ptr<EvalEnv> env)
+    : proc(std::move(proc)), env(std::move(env)), context(std::make_unique<TaskContext>()) {}
+
+TaskValue::~TaskValue() = default;
+
+std::string TaskValue::toString() const {
+    return "#<task>";
+}
+
+Scheduler& Scheduler::current() {
+    thread_local Scheduler instance;
+    return instance;
+}
+
+Scheduler::~Scheduler() {
+#ifndef _WIN32
+    if (stack_base) {
+        munmap(stack_base, stack_size);
+    }
+    delete main_context;
+#endif
+}
+
+TaskPtr Scheduler::spawn(ValuePtr proc, std::shared_ptr<EvalEnv> env, double delay) {
+#ifdef _WIN32
+    throw LispError("spawn: tasks are not supported on this platform.");
+#else
+    if (!stack_base) {
+        void* mem = mmap(nullptr, TASK_STACK_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem == MAP_FAILED) {
+            throw LispError("spawn: failed to allocate task stack.");
+        }
+        stack_base = static_cast<char*>(mem);
+        stack_size = TASK_STACK_SIZE;
+        main_context = new TaskContext;
+    }
+    auto task = std::make_shared<TaskValue>(std::move(proc), std::move(env));
+    task->start_delay = delay;
+    ready.push_back(task);
+    return task;
+#endif
+}
+
+void Scheduler::trampoline() {
+    Scheduler& self = current();
+    TaskPtr task = self.running;
+    try {
+        if (task->start_delay > 0) {
+            self.sleepFor(task->start_delay);
+        }
+        task->result = task->env->apply(task->proc, {});
+        task->state = TaskValue::State::Done;
+    } catch (const std::exception& e) {
+        task->error = e.what();
+        task->state = TaskValue::State::Failed;
+    } catch (const TaskCancelled&) {
+        task->error = "task: cancelled.";
+        task->state = TaskValue::State::Failed;
+    } catch (...) {
+        // 其他异常不能越过 makecontext 的入口函数展开，记下后在调度器自己的上下文中重新抛出
+        self.escaped = std::current_exception();
+        task->error = "task: exited abnormally.";
+        task->state = TaskValue::State::Failed;
+    }
+    self.finish(task);
+    // 返回后经 uc_link 回到调度器
+}
+
+void Scheduler::finish(const TaskPtr& task) {
+    for (auto& waiter : task->waiters) {
+        waiter->state = TaskValue::State::Ready;
+        ready.push_back(waiter);
+    }
+    task->waiters.clear();
+    task->proc = nullptr;
+    task->env = nullptr;
+}
+
+#ifndef _WIN32
+__attribute__((noinline)) static void switchOut(TaskContext* from, TaskContext* to) {
+    volatile char marker = 0;
+    // 按整数计算，不对局部变量的地址做越界的指针运算
+    from->saved_sp = reinterpret_cast<char*>(reinterpret_cast<std::uintptr_t>(&marker) - SWITCH_FRAME_MARGIN);
+    swapcontext(&from->ctx, &to->ctx);
+}
+#endif
+
+void Scheduler::resume(const TaskPtr& task) {
+#ifndef _WIN32
+    TaskContext* ctx = task->context.get();
+    char* stack_top = stack_base + stack_size;
+    if (!ctx->started) {
+        getcontext(&ctx->ctx);
+        ctx->ctx.uc_stack.ss_sp = stack_base;
+        ctx->ctx.uc_stack.ss_size = stack_size;
+        ctx->ctx.uc_link = &main_context->ctx;
+        makecontext(&ctx->ctx, &Scheduler::trampoline, 0);
+        ctx->started = true;
+    } else {
+        std::memcpy(ctx->saved_sp, ctx->saved_stack.data(), ctx->saved_stack.size());
+    }
+    running = task;
+    task->state = TaskValue::State::Running;
+    const char* outer_limit = stack_limit;
+    stack_limit = stack_base + STACK_SAFETY_MARGIN;
+    HandlerFrame* outer_handlers = current_handlers;
+    current_handlers = ctx->handlers;
+    swapcontext(&main_context->ctx, &ctx->ctx);
+    ctx->handlers = current_handlers;
+    current_handlers = outer_handlers;
+    stack_limit = outer_limit;
+    running = nullptr;
+    if (task->isFinished()) {
+        task->context.reset();
+    } else {
+        ctx->saved_stack.assign(ctx->saved_sp, stack_top);
+    }
+    if (escaped) {
+        try {
+            std::rethrow_exception(std::exchange(escaped, nullptr));
+        } catch (const ExitRequest& request) {
+            // 任务中调用了 exit：在主流程中结束当前脚本或进程
+            requestExit(request.code);
+        }
+    }
+#endif
+}
+
+void Scheduler::suspend() {
+#ifndef _WIN32
+    if (!running->cancelled) {
+        switchOut(running->context.get(), main_context);
+    }
+    if (running->cancelled) {
+        throw TaskCancelled{};
+    }
+#endif
+}
+
+void Scheduler::checkSuspendable() const {
+    // 切出时只保存共用执行栈上的部分，在生成器的栈上挂起会丢失状态
+    char probe;
+    if (&probe < stack_base || &probe >= stack_base + stack_size) {
+        throw LispError("Cannot suspend a task from inside a generator.");
+    }
+}
+
+void Scheduler::wakeSleepers() {
+    auto now = SchedulerClock::now();
+    while (!sleepers.empty() && sleepers.front()->wake_time <= now) {
+        std::pop_heap(sleepers.begin(), sleepers.end(), wakesLater);
+        TaskPtr task = std::move(sleepers.back());
+        sleepers.pop_back();
+        task->state = TaskValue::State::Ready;
+        ready.push_back(std::move(task));
+    }
+}
+
+bool Scheduler::waitForEvents(const SchedulerClock::time_point* deadline, int main_fd, short main_events) {
+#ifdef _WIN32
+    return false;
+#else
+    const SchedulerClock::time_point* until = deadline;
+    if (!sleepers.empty() && (!until || sleepers.front()->wake_time < *until)) {
+        until = &sleepers.front()->wake_time;
+    }
+    if (!until && io_waiters.empty() && main_fd < 0) {
+        return false;
+    }
+    std::vector<pollfd> fds;
+    fds.reserve(io_waiters.size() + 1);
+    for (const auto& wait : io_waiters) {
+        fds.push_back({wait.fd, wait.events, 0});
+    }
+    if (main_fd >= 0) {
+        fds.push_back({main_fd, main_events, 0});
+    }
+    int timeout_ms = -1;
+    if (until) {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(*until - SchedulerClock::now());
+        timeout_ms = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+    }
+    int n = poll(fds.data(), fds.size(), timeout_ms);
+    if (n < 0 && errno != EINTR) {
+        throw LispError(std::string("poll: ") + std::strerror(errno));
+    }
+    if (n > 0) {
+        size_t kept = 0;
+        for (size_t i = 0; i < io_waiters.size(); ++i) {
+            if (fds[i].revents) {
+                io_waiters[i].task->state = TaskValue::State::Ready;
+                ready.push_back(std::move(io_waiters[i].task));
+            } else {
+                io_waiters[kept++] = std::move(io_waiters[i]);
+            }
+        }
+        io_waiters.resize(kept);
+    }
+    return true;
+#endif
+}
+
+void Scheduler::runOne() {
+    TaskPtr task = std::move(ready.front());
+    ready.pop_front();
+    resume(task);
+}
+
+template <typename Pred>
+void Scheduler::runUntil(Pred done) {
+    while (!done()) {
+        wakeSleepers();
+        if (!ready.empty()) {
+            runOne();
+        } else if (!waitForEvents(nullptr)) {
+            throw LispError("Deadlock: no runnable tasks.");
+        }
+    }
+}
+
+void Scheduler::runAll() {
+    runUntil([&] { return ready.empty() && sleepers.empty() && io_waiters.empty(); });
+}
+
+void Scheduler::cancelAll() {
+#ifndef _WIN32
+    // 等待 join 的任务只记录在被等待任务的 waiters 中
+    std::vector<TaskPtr> pending(ready.begin(), ready.end());
+    pending.insert(pending.end(), sleepers.begin(), sleepers.end());
+    for (const auto& wait : io_waiters) {
+        pending.push_back(wait.task);
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+        for (const auto& waiter : pending[i]->waiters) {
+            if (std::find(pending.begin(), pending.end(), waiter) == pending.end()) {
+                pending.push_back(waiter);
+            }
+        }
+    }
+    for (const auto& task : pending) {
+        if (task->isFinished()) {
+            continue;
+        }
+        task->cancelled = true;
+        if (task->context && task->context->started) {
+            try {
+                resume(task);
+            } catch (...) {
+                // 展开途中的异常只属于被取消的任务
+            }
+        } else {
+            task->error = "task: cancelled.";
+            task->state = TaskValue::State::Failed;
+            task->context.reset();
+            finish(task);
+        }
+    }
+    ready.clear();
+    sleepers.clear();
+    io_waiters.clear();
+#endif
+}
+
+void Scheduler::yield() {
+    if (inTask()) {
+        checkSuspendable();
+        ready.push_back(running);
+        running->state = TaskValue::State::Ready;
+        suspend();
+        return;
+    }
+    // 主流程让出：当前就绪的任务各运行一次
+    for (size_t remaining = ready.size(); remaining > 0 && !ready.empty(); --remaining) {
+        runOne();
+    }
+}
+
+void Scheduler::sleepFor(double seconds) {
+    auto wake = SchedulerClock::now() +
+                std::chrono::duration_cast<SchedulerClock::duration>(std::chrono::duration<double>(seconds));
+    if (inTask()) {
+        checkSuspendable();
+        running->wake_time = wake;
+        running->state = TaskValue::State::Waiting;
+        sleepers.push_back(running);
+        std::push_heap(sleepers.begin(), sleepers.end(), wakesLater);
+        suspend();
+        return;
+    }
+    while (SchedulerClock::now() < wake) {
+        wakeSleepers();
+        if (!ready.empty()) {
+            runOne();
+        } else {
+            waitForEvents(&wake);
+        }
+    }
+}
+
+void Scheduler::waitIo(int fd, short events) {
+#ifndef _WIN32
+    if (inTask()) {
+        checkSuspendable();
+        running->state = TaskValue::State::Waiting;
+        io_waiters.push_back({fd, events, running});
+        suspend();
+        return;
+    }
+    while (true) {
+        pollfd self{fd, events, 0};
+        if (poll(&self, 1, 0) > 0) {
+            return;
+        }
+        wakeSleepers();
+        if (!ready.empty()) {
+            runOne();
+        } else {
+            waitForEvents(nullptr, fd, events);
+        }
+    }
+#endif
+}
+
+ValuePtr Scheduler::join(const TaskPtr& task) {
+    if (task == running) {
+        throw LispError("join: a task cannot join itself.");
+    }
+    if (!task->isFinished()) {
+        if (inTask()) {
+            checkSuspendable();
+            task->waiters.push_back(running);
+            running->state = TaskValue::State::Waiting;
+            suspend();
+        } else {
+            runUntil([&] { return task->isFinished(); });
+        }
+    }
+    if (task->state == TaskValue::State::Failed) {
+        throw LispError(task->error);
+    }
+    return task->result;
+}
@@ -0,0 +1,102 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "value.h"
+
+class EvalEnv;
+struct TaskContext;
+
+using SchedulerClock = std::chrono::steady_clock;
+
+// 协程任务：spawn 返回的对象，join 时取回结果
+class TaskValue : public Value {
+public:
+    enum class State { Ready, Running, Waiting, Done, Failed };
+
+    ValuePtr proc;
+    std::shared_ptr<EvalEnv> env;
+    State state = State::Ready;
+    ValuePtr result;
+    std::string error;
+    SchedulerClock::time_point wake_time{};
+    double start_delay = 0;
+    std::vector<std::shared_ptr<TaskValue>> waiters;
+    std::unique_ptr<TaskContext> context;
+    bool cancelled = false;  // 被 cancelAll 取消：恢复后在挂起处展开栈
+
+    TaskValue(ValuePtr proc, std::shared_ptr<EvalEnv> env);
+    ~TaskValue() override;
+    std::string toString() const override;
+    bool isFinished() const {
+        return state == State::Done || state == State::Failed;
+    }
+};
+
+using TaskPtr = std::shared_ptr<TaskValue>;
+
+// 协作式调度器，每个线程一个实例。
+// 所有任务共用一段执行栈，切出时只把实际用到的部分拷贝到堆上，
+// 因此挂起的任务只占用几 KB 内存。
+class Scheduler {
+public:
+    static Scheduler& current();
+
+    TaskPtr spawn(ValuePtr proc, std::shared_ptr<EvalEnv> env, double delay = 0);
+    void yield();
+    void sleepFor(double seconds);
+    ValuePtr join(const TaskPtr& task);
+    // 等待 fd 可读（POLLIN）或可写（POLLOUT）；在任务中调用时挂起任务，
+    // 在主流程中调用时一边等待一边运行其他任务
+    void waitIo(int fd, short events);
+    // 运行所有任务直到没有任何任务剩余
+    void runAll();
+    // 取消所有尚未结束的任务（包括定时器与等待 I/O 的任务）：已开始的任务在挂起处展开栈后以出错结束。
+    // 一段脚本结束时调用（见 runCaptured），它留下的任务不会在之后的脚本中运行
+    void cancelAll();
+    bool inTask() const {
+        return running != nullptr;
+    }
+    // 正在运行的任务，主流程中为 nullptr
+    const TaskValue* runningTask() const {
+        return running.get();
+    }
+
+    ~Scheduler();
+
+private:
+    std::deque<TaskPtr> ready;
+    std::vector<TaskPtr> sleepers;  // 按 wake_time 组织的最小堆
+    struct IoWait {
+        int fd;
+        short events;
+        TaskPtr task;
+    };
+    std::vector<IoWait> io_waiters;
+    TaskPtr running;
+    TaskContext* main_context = nullptr;
+    char* stack_base = nullptr;
+    size_t stack_size = 0;
+    // 任务中抛出的、不派生自 std::exception 的异常，切回调度器后重新抛出
+    std::exception_ptr escaped;
+
+    template <typename Pred>
+    void runUntil(Pred done);
+    void resume(const TaskPtr& task);
+    void suspend();
+    // 挂起前检查当前是否在任务自己的栈上（不在生成器等另外的栈上）
+    void checkSuspendable() const;
+    void wakeSleepers();
+    bool waitForEvents(const SchedulerClock::time_point* deadline, int main_fd = -1, short main_events = 0);
+    void runOne();
+    void finish(const TaskPtr& task);
+    static void trampoline();
+};
+
+#endif
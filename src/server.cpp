@@ -0,0 +1,191 @@
+#include "server.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "eval_env.h"
+#include "framing.h"
+#include "runner.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+int runServer(const std::string& socket_path, const std::shared_ptr<EvalEnv>& root) {
+    std::cerr << "Error: --serve is not supported on this platform." << std::endl;
+    return 1;
+}
+
+#else
+
+namespace {
+
+int listenOn(const std::string& socket_path) {
+    sockaddr_un addr{};
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: socket path too long: " << socket_path << std::endl;
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(socket_path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 128) < 0) {
+        std::cerr << "Error: cannot listen on '" << socket_path << "': " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 一个客户端连接。套接字是非阻塞的：收到的字节先缓存，凑齐一个完整的请求帧才求值，
+// 响应也先放入缓冲区，对方暂时不读时等 POLLOUT 再继续写，慢的连接不会拖住其他连接
+struct Connection {
+    int fd;
+    std::string input;
+    size_t consumed = 0;  // input 中已取出的请求帧
+    std::string output;
+    size_t written = 0;
+    bool eof = false;     // 对方已关闭写端：处理完已收到的请求、发完响应后关闭
+    bool failed = false;  // 读写出错或收到非法的帧，立即关闭
+
+    explicit Connection(int fd) : fd(fd) {}
+
+    // 读出当前可读的全部数据
+    void fill() {
+        char buffer[64 * 1024];
+        while (true) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                input.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0) {
+                eof = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                failed = true;
+            }
+            return;
+        }
+    }
+
+    // 尽量写出缓冲的响应
+    void flush() {
+        while (written < output.size()) {
+            ssize_t n = ::write(fd, output.data() + written, output.size() - written);
+            if (n > 0) {
+                written += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                failed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                return;
+            }
+        }
+        output.clear();
+        written = 0;
+    }
+
+    // 缓存中有完整的请求帧（或非法的帧头，取出时报错）
+    bool hasRequest() const {
+        return frameStatus(input, consumed) != FrameStatus::Incomplete;
+    }
+
+    // 取出下一个完整的请求帧
+    bool nextRequest(std::string& source) {
+        switch (parseFrame(input, consumed, source)) {
+            case FrameStatus::Complete:
+                return true;
+            case FrameStatus::Invalid:
+                failed = true;
+                return false;
+            case FrameStatus::Incomplete:
+                input.erase(0, consumed);
+                consumed = 0;
+                return false;
+        }
+        return false;
+    }
+};
+
+}  // namespace
+
+int runServer(const std::string& socket_path, const std::shared_ptr<EvalEnv>& root) {
+    int listener = listenOn(socket_path);
+    if (listener < 0) {
+        return 1;
+    }
+    // 客户端提前断开时不要被 SIGPIPE 杀死
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
+    std::string source;
+    bool backlog = false;  // 有连接缓存着尚未处理的完整请求，这一轮 poll 不等待
+    while (true) {
+        fds.assign(1, {listener, POLLIN, 0});
+        for (const auto& connection : connections) {
+            // 响应还没发完时不再读新的请求，对方不读响应就不会无限缓存
+            fds.push_back({connection.fd, static_cast<short>(connection.output.empty() ? POLLIN : POLLOUT), 0});
+        }
+        if (::poll(fds.data(), fds.size(), backlog ? 0 : -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        backlog = false;
+        for (size_t i = connections.size(); i-- > 0;) {
+            Connection& connection = connections[i];
+            short revents = fds[i + 1].revents;
+            if (revents & POLLOUT) {
+                connection.flush();
+            } else if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                connection.fill();
+            }
+            // 每个连接每轮最多处理一个请求，轮流服务各个连接
+            if (!connection.failed && connection.output.empty() && connection.nextRequest(source)) {
+                auto request_env = std::make_shared<EvalEnv>(root);
+                request_env->toplevel = true;
+                RunResult result = runCaptured(*request_env, source);
+                // 请求中定义的闭包引用着 request_env，清空绑定以打破引用环
+                request_env->clearBindings();
+                connection.output = encodeResult(result);
+                connection.flush();
+            }
+            bool pending = connection.hasRequest();
+            backlog = backlog || (pending && connection.output.empty());
+            // 对方关闭后剩下的不完整请求直接丢弃
+            if (connection.failed || (connection.eof && connection.output.empty() && !pending)) {
+                ::close(connection.fd);
+                connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (client >= 0) {
+                connections.emplace_back(client);
+            }
+        }
+    }
+    ::close(listener);
+    ::unlink(socket_path.c_str());
+    return 1;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <memory>
+#include <string>
+
+class EvalEnv;
+
+// 常驻服务模式：在 Unix 域套接字上接收求值请求。
+// 每个请求在 root 之上新建的子环境中求值，互不影响，root 只初始化一次。
+//
+// 请求帧：4 字节大端长度 + 源代码
+// 响应帧：1 字节状态（0 成功，1 出错）
+//        + 4 字节长度 + 捕获的输出
+//        + 4 字节长度 + 最后一个表达式的值或错误信息
+int runServer(const std::string& socket_path, const std::shared_ptr<EvalEnv>& root);
+
+#endif
@@ -0,0 +1,167 @@
+#include "stack_segments.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <string>
+
+#include "error.h"
+#include "eval_env.h"
+#include "scheduler.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+thread_local const char* stack_limit = nullptr;
+
+namespace {
+
+constexpr size_t SEGMENT_SIZE = 8 * 1024 * 1024;
+// 栈段底部以上预留的空间：两次检查之间内建过程等可能用到的栈，以及切换栈段本身所需的栈
+constexpr size_t STACK_SAFETY_MARGIN = 256 * 1024;
+
+std::atomic<size_t> max_segment_bytes{size_t{1} << 30};
+
+// 当前栈位置以下 distance 字节处的地址。按整数计算，不对局部变量的地址做越界的指针运算
+const char* stackAddressBelow(size_t distance) {
+    char probe;
+    return reinterpret_cast<const char*>(reinterpret_cast<std::uintptr_t>(&probe) - distance);
+}
+
+#ifndef _WIN32
+// 本线程正在使用的栈段总量；另缓存一个空闲栈段，递归在栈段边界附近反复进出时不必每次 mmap
+struct SegmentPool {
+    size_t used = 0;
+    char* spare = nullptr;
+
+    ~SegmentPool() {
+        if (spare) {
+            munmap(spare, SEGMENT_SIZE);
+        }
+    }
+
+    char* acquire() {
+        if (used + SEGMENT_SIZE > max_segment_bytes.load(std::memory_order_relaxed)) {
+            throw LispError("Stack overflow: recursion too deep (stack limit " +
+                            std::to_string(max_segment_bytes.load(std::memory_order_relaxed) >> 20) + " MB).");
+        }
+        char* segment = spare;
+        spare = nullptr;
+        if (!segment) {
+            void* mem = mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                             -1, 0);
+            if (mem == MAP_FAILED) {
+                throw LispError("Stack overflow: failed to allocate a stack segment.");
+            }
+            segment = static_cast<char*>(mem);
+            // 最低的一页作为保护页，越过安全余量的溢出会立即出错而不是改写其他内存
+            mprotect(segment, sysconf(_SC_PAGESIZE), PROT_NONE);
+        }
+        used += SEGMENT_SIZE;
+        return segment;
+    }
+
+    void release(char* segment) {
+        used -= SEGMENT_SIZE;
+        if (spare) {
+            munmap(segment, SEGMENT_SIZE);
+        } else {
+            spare = segment;
+        }
+    }
+};
+
+thread_local SegmentPool pool;
+
+struct SegmentCall {
+    EvalEnv* env;
+    const ValuePtr* expr;
+    ValuePtr result;
+    std::exception_ptr error;
+};
+
+thread_local SegmentCall* pending_call = nullptr;
+
+void segmentEntry() {
+    SegmentCall* call = pending_call;
+    try {
+        call->result = call->env->evalOrEscape(*call->expr);
+    } catch (...) {
+        call->error = std::current_exception();
+    }
+    // 返回后经 uc_link 回到调用方
+}
+
+// 在 segment 上执行 call，返回时已切回原来的栈。getcontext 按可能返回两次对待，
+// 单独成为一个函数，调用方的局部变量（如 pool.acquire 的结果）不受影响
+__attribute__((noinline)) void runOnSegment(char* segment, SegmentCall& call) {
+    ucontext_t caller;
+    ucontext_t callee;
+    getcontext(&callee);
+    callee.uc_stack.ss_sp = segment;
+    callee.uc_stack.ss_size = SEGMENT_SIZE;
+    callee.uc_link = &caller;
+    makecontext(&callee, &segmentEntry, 0);
+    const char* outer_limit = stack_limit;
+    stack_limit = segment + STACK_SAFETY_MARGIN;
+    pending_call = &call;
+    swapcontext(&caller, &callee);
+    stack_limit = outer_limit;
+}
+
+// 按线程原生栈的范围设置 stack_limit
+void initStackLimit() {
+    pthread_attr_t attr;
+    void* base = nullptr;
+    size_t size = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstack(&attr, &base, &size);
+        pthread_attr_destroy(&attr);
+    }
+    if (base && size > STACK_SAFETY_MARGIN) {
+        stack_limit = static_cast<const char*>(base) + STACK_SAFETY_MARGIN;
+    } else {
+        // 无法取得栈的范围时按默认的 8MB 估计
+        stack_limit = stackAddressBelow(SEGMENT_SIZE - STACK_SAFETY_MARGIN);
+    }
+}
+#else
+void initStackLimit() {
+    // 默认 1MB 的线程栈，不支持分段，只把溢出报告为 LispError
+    stack_limit = stackAddressBelow(768 * 1024);
+}
+#endif
+
+}  // namespace
+
+ValuePtr eval_on_new_stack_segment(EvalEnv& env, const ValuePtr& expr) {
+    if (!stack_limit) {
+        initStackLimit();
+        if (!stack_exhausted()) {
+            return env.evalOrEscape(expr);
+        }
+    }
+#ifdef _WIN32
+    throw LispError("Stack overflow: recursion too deep.");
+#else
+    if (Scheduler::current().inTask()) {
+        throw LispError("Stack overflow in task.");
+    }
+    char* segment = pool.acquire();
+    SegmentCall call{&env, &expr, nullptr, nullptr};
+    runOnSegment(segment, call);
+    pool.release(segment);
+    if (call.error) {
+        std::rethrow_exception(call.error);
+    }
+    return std::move(call.result);
+#endif
+}
+
+void set_max_stack_size(size_t bytes) {
+    max_segment_bytes.store(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+#ifndef STACK_SEGMENTS_H
+#define STACK_SEGMENTS_H
+
+#include <cstddef>
+
+#include "value.h"
+
+class EvalEnv;
+
+// 分段栈。非尾递归（如 (+ (car l) (sum (cdr l)))）每一层都要占用求值器的几个原生栈帧，
+// 原生栈将要用完时，在堆上分配一段新的栈继续求值，这一层返回时释放。递归深度因此只受内存
+// 与可配置的栈总量限制，超出时抛出 LispError 而不是崩溃。
+// 协程任务共用一段会被整体拷贝的执行栈，不能切换到其他栈段，任务中栈用完时直接抛出 LispError。
+
+// 当前栈段上可用空间的下界（已留出安全余量）；本线程尚未初始化时为 nullptr
+extern thread_local const char* stack_limit;
+
+// 剩余的栈空间不足（或尚未初始化），需要经 eval_on_new_stack_segment 继续求值
+inline bool stack_exhausted() {
+    char probe;
+    return &probe < stack_limit || !stack_limit;
+}
+
+// 在新的栈段上求值 env.evalOrEscape(expr) 并返回结果（可能是 LISP_ESCAPE），求值中抛出的异常在原来的栈上重新抛出。
+// 本线程的栈尚未初始化且空间充足时直接求值。放在单独的编译单元中，不增大 eval 自身的栈帧
+ValuePtr eval_on_new_stack_segment(EvalEnv& env, const ValuePtr& expr);
+
+// 每个线程的原生栈之外可以再分配的栈段总量（字节），默认 1GB
+void set_max_stack_size(size_t bytes);
+
+#endif
@@ -0,0 +1,504 @@
+#include "syntax_rules.h"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "error.h"
+#include "eval_env.h"
+
+namespace {
+
+// 展开时为模板引入的绑定名生成新符号所用的编号
+std::atomic<std::uint64_t> rename_counter{0};
+
+const std::string* symbolName(const ValuePtr& value) {
+    return typeid(*value) == typeid(SymbolValue) ? &static_cast<SymbolValue&>(*value).getName() : nullptr;
+}
+
+bool isNamed(const ValuePtr& value, const std::string& name) {
+    const std::string* symbol = symbolName(value);
+    return symbol && *symbol == name;
+}
+
+PairValue* asPair(const ValuePtr& value) {
+    return value->isPair() ? static_cast<PairValue*>(value.get()) : nullptr;
+}
+
+// 模式中的常量（数字、字符串、布尔值）与实参是否相同
+bool sameDatum(const ValuePtr& pattern, const ValuePtr& input) {
+    if (pattern->isNumber() && input->isNumber()) {
+        return pattern->asNumber() == input->asNumber();
+    }
+    if (pattern->isString() && input->isString()) {
+        return pattern->asString() == input->asString();
+    }
+    if (pattern->isBoolean() && input->isBoolean()) {
+        return pattern->isLispFalse() == input->isLispFalse();
+    }
+    return pattern->isNil() && input->isNil();
+}
+
+}  // namespace
+
+struct SyntaxRules::Pattern {
+    enum Kind { ANY, VARIABLE, LITERAL, DATUM, LIST } kind;
+    size_t slot = 0;                  // VARIABLE
+    ValuePtr datum;                   // LITERAL 的符号、DATUM 的常量
+    std::vector<Pattern> prefix;      // LIST：省略号之前的元素（没有省略号时为全部元素）
+    std::unique_ptr<Pattern> repeat;  // LIST：后跟省略号的元素
+    std::vector<size_t> repeat_slots; // repeat 中的模式变量
+    std::vector<Pattern> suffix;      // LIST：省略号之后的元素
+    std::unique_ptr<Pattern> tail;    // LIST：点对的尾部；为空时要求是真正的表
+};
+
+struct SyntaxRules::Template {
+    enum Kind { CONSTANT, VARIABLE, RENAMED, PAIR, REPEAT } kind;
+    ValuePtr constant;               // CONSTANT
+    size_t index = 0;                // VARIABLE 的槽位，RENAMED 在本次展开的新符号表中的下标
+    std::unique_ptr<Template> car;   // PAIR；REPEAT 中重复的元素
+    std::unique_ptr<Template> cdr;   // PAIR；REPEAT 之后的部分
+    // REPEAT：每层省略号逐项展开的模式变量；x ... ... 有两层，结果被展平
+    std::vector<std::vector<size_t>> drivers;
+};
+
+// 一个模式变量匹配到的语法；位于省略号之下时 items 为逐项的匹配结果
+struct SyntaxRules::Match {
+    ValuePtr value;
+    std::vector<Match> items;
+};
+
+struct SyntaxRules::Rule {
+    Pattern pattern;  // 调用形式中去掉宏名之后的部分
+    Template tmpl;
+    size_t slots = 0;
+    std::vector<std::string> renamed;  // 模板引入的绑定名
+    size_t min_length = 0;
+    bool variadic = false;
+};
+
+class SyntaxRules::Compiler {
+public:
+    Compiler(const std::string& macro, std::string ellipsis, std::unordered_set<std::string> literals)
+        : macro(macro), ellipsis(std::move(ellipsis)), literals(std::move(literals)) {}
+
+    void compileRule(const ValuePtr& spec, Rule& rule) {
+        PairValue* clause = asPair(spec);
+        PairValue* rest = clause ? asPair(clause->r) : nullptr;
+        if (!rest || !rest->r->isNil()) {
+            fail("each rule must be (pattern template)");
+        }
+        PairValue* pattern = asPair(clause->l);
+        if (!pattern) {
+            fail("a pattern must be a list starting with the macro keyword");
+        }
+        variables.clear();
+        rule.pattern = compilePattern(pattern->r, 0);
+        rule.slots = variables.size();
+        if (rule.pattern.kind == Pattern::LIST) {
+            rule.min_length = rule.pattern.prefix.size() + rule.pattern.suffix.size();
+            rule.variadic = rule.pattern.repeat || rule.pattern.tail;
+        } else {
+            // (_ . rest)：整个实参表由一个模式匹配，接受任意个数的实参
+            rule.min_length = 0;
+            rule.variadic = true;
+        }
+
+        std::unordered_set<std::string> binders;
+        collectBinders(rest->l, binders);
+        renamed.clear();
+        for (const auto& binder : binders) {
+            renamed.emplace(binder, renamed.size());
+            rule.renamed.push_back(binder);
+        }
+        rule.tmpl = compileTemplate(rest->l, 0);
+    }
+
+private:
+    struct Variable {
+        size_t slot;
+        int depth;
+    };
+
+    const std::string& macro;
+    std::string ellipsis;
+    std::unordered_set<std::string> literals;
+    std::unordered_map<std::string, Variable> variables;
+    std::unordered_map<std::string, size_t> renamed;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw LispError("syntax-rules (" + macro + "): " + message);
+    }
+
+    bool isEllipsis(const ValuePtr& value) const {
+        return isNamed(value, ellipsis);
+    }
+
+    Pattern compilePattern(const ValuePtr& syntax, int depth) {
+        Pattern pattern;
+        if (const std::string* name = symbolName(syntax)) {
+            if (*name == ellipsis) {
+                fail("misplaced ellipsis in pattern");
+            }
+            if (*name == "_") {
+                pattern.kind = Pattern::ANY;
+            } else if (literals.count(*name)) {
+                pattern.kind = Pattern::LITERAL;
+                pattern.datum = syntax;
+            } else {
+                if (variables.count(*name)) {
+                    fail("duplicate pattern variable " + *name);
+                }
+                pattern.kind = Pattern::VARIABLE;
+                pattern.slot = variables.size();
+                variables.emplace(*name, Variable{pattern.slot, depth});
+            }
+            return pattern;
+        }
+        if (!syntax->isPair() && !syntax->isNil()) {
+            pattern.kind = Pattern::DATUM;
+            pattern.datum = syntax;
+            return pattern;
+        }
+        pattern.kind = Pattern::LIST;
+        ValuePtr rest = syntax;
+        for (PairValue* pair; (pair = asPair(rest)); rest = pair->r) {
+            PairValue* next = asPair(pair->r);
+            if (next && isEllipsis(next->l)) {
+                if (pattern.repeat) {
+                    fail("more than one ellipsis in a list pattern");
+                }
+                size_t first_slot = variables.size();
+                pattern.repeat = std::make_unique<Pattern>(compilePattern(pair->l, depth + 1));
+                for (size_t slot = first_slot; slot < variables.size(); ++slot) {
+                    pattern.repeat_slots.push_back(slot);
+                }
+                pair = next;
+                continue;
+            }
+            (pattern.repeat ? pattern.suffix : pattern.prefix).push_back(compilePattern(pair->l, depth));
+        }
+        if (!rest->isNil()) {
+            pattern.tail = std::make_unique<Pattern>(compilePattern(rest, depth));
+        }
+        return pattern;
+    }
+
+    // 模板在绑定形式中引入、且不是模式变量的名字
+    void collectBinders(const ValuePtr& syntax, std::unordered_set<std::string>& out) const {
+        PairValue* pair = asPair(syntax);
+        if (!pair) {
+            return;
+        }
+        auto add = [&](const ValuePtr& name) {
+            const std::string* symbol = symbolName(name);
+            if (symbol && !variables.count(*symbol) && *symbol != ellipsis && *symbol != "_") {
+                out.insert(*symbol);
+            }
+        };
+        auto addBindingNames = [&](const ValuePtr& bindings) {
+            for (ValuePtr rest = bindings; PairValue* binding = asPair(rest); rest = binding->r) {
+                PairValue* spec = asPair(binding->l);
+                add(spec ? spec->l : binding->l);
+            }
+        };
+        PairValue* second = asPair(pair->r);
+        if (const std::string* head = symbolName(pair->l); head && second) {
+            if (*head == "lambda") {
+                ValuePtr params = second->l;
+                for (PairValue* param; (param = asPair(params)); params = param->r) {
+                    add(param->l);
+                }
+                add(params);
+            } else if (*head == "let" || *head == "let*" || *head == "letrec" || *head == "letrec*" ||
+                       *head == "do") {
+                ValuePtr bindings = second->l;
+                if (symbolName(bindings) && asPair(second->r)) {
+                    add(bindings);  // 命名 let
+                    bindings = asPair(second->r)->l;
+                }
+                addBindingNames(bindings);
+            }
+        }
+        for (ValuePtr rest = syntax; PairValue* item = asPair(rest); rest = item->r) {
+            collectBinders(item->l, out);
+        }
+    }
+
+    static Template constant(const ValuePtr& value) {
+        Template tmpl;
+        tmpl.kind = Template::CONSTANT;
+        tmpl.constant = value;
+        return tmpl;
+    }
+
+    Template compileTemplate(const ValuePtr& syntax, int depth) {
+        if (const std::string* name = symbolName(syntax)) {
+            if (auto it = variables.find(*name); it != variables.end()) {
+                if (it->second.depth > depth) {
+                    fail("pattern variable " + *name + " is used without enough ellipses");
+                }
+                Template tmpl;
+                tmpl.kind = Template::VARIABLE;
+                tmpl.index = it->second.slot;
+                return tmpl;
+            }
+            if (auto it = renamed.find(*name); it != renamed.end()) {
+                Template tmpl;
+                tmpl.kind = Template::RENAMED;
+                tmpl.index = it->second;
+                return tmpl;
+            }
+            if (*name == ellipsis) {
+                fail("misplaced ellipsis in template");
+            }
+            return constant(syntax);
+        }
+        PairValue* pair = asPair(syntax);
+        if (!pair) {
+            return constant(syntax);
+        }
+        ValuePtr rest;
+        // (... ...) 表示省略号本身
+        if (isEllipsis(pair->l) && asPair(pair->r) && asPair(pair->r)->r->isNil()) {
+            std::string saved = std::move(ellipsis);
+            Template escaped = compileTemplate(asPair(pair->r)->l, depth);
+            ellipsis = std::move(saved);
+            return escaped;
+        }
+        PairValue* next = asPair(pair->r);
+        if (next && isEllipsis(next->l)) {
+            Template tmpl;
+            tmpl.kind = Template::REPEAT;
+            int levels = 0;
+            for (; next && isEllipsis(next->l); next = asPair(next->r)) {
+                ++levels;
+                collectDrivers(pair->l, depth + levels, tmpl.drivers.emplace_back());
+                if (tmpl.drivers.back().empty()) {
+                    fail("no pattern variable to repeat before ellipsis in template");
+                }
+                rest = next->r;
+            }
+            tmpl.car = std::make_unique<Template>(compileTemplate(pair->l, depth + levels));
+            tmpl.cdr = std::make_unique<Template>(compileTemplate(rest, depth));
+            return tmpl;
+        }
+        Template car = compileTemplate(pair->l, depth);
+        Template cdr = compileTemplate(pair->r, depth);
+        if (car.kind == Template::CONSTANT && cdr.kind == Template::CONSTANT) {
+            // 不含模式变量的子结构在定义时构造一次，各次展开共享
+            if (car.constant == pair->l && cdr.constant == pair->r) {
+                return constant(syntax);
+            }
+            return constant(std::make_shared<PairValue>(car.constant, cdr.constant));
+        }
+        Template tmpl;
+        tmpl.kind = Template::PAIR;
+        tmpl.car = std::make_unique<Template>(std::move(car));
+        tmpl.cdr = std::make_unique<Template>(std::move(cdr));
+        return tmpl;
+    }
+
+    // 省略号下的子模板中，嵌套深度足以逐项展开的模式变量
+    void collectDrivers(const ValuePtr& syntax, int depth, std::vector<size_t>& out) const {
+        if (const std::string* name = symbolName(syntax)) {
+            auto it = variables.find(*name);
+            if (it != variables.end() && it->second.depth >= depth &&
+                std::find(out.begin(), out.end(), it->second.slot) == out.end()) {
+                out.push_back(it->second.slot);
+            }
+            return;
+        }
+        for (ValuePtr rest = syntax; PairValue* pair = asPair(rest); rest = pair->r) {
+            collectDrivers(pair->l, depth, out);
+            if (!pair->r->isPair()) {
+                collectDrivers(pair->r, depth, out);
+            }
+        }
+    }
+};
+
+SyntaxRules::SyntaxRules(const std::string& name, const ValuePtr& spec) : name(name) {
+    PairValue* form = asPair(spec);
+    if (!form || !isNamed(form->l, "syntax-rules")) {
+        throw LispError("define-syntax: expects (syntax-rules (literal ...) rule ...)");
+    }
+    PairValue* rest = asPair(form->r);
+    std::string ellipsis = "...";
+    if (rest && symbolName(rest->l)) {
+        ellipsis = *symbolName(rest->l);
+        rest = asPair(rest->r);
+    }
+    if (!rest) {
+        throw LispError("syntax-rules (" + name + "): missing literal list");
+    }
+    std::unordered_set<std::string> literals;
+    for (ValuePtr literal = rest->l; PairValue* item = asPair(literal); literal = item->r) {
+        if (!symbolName(item->l)) {
+            throw LispError("syntax-rules (" + name + "): literals must be symbols");
+        }
+        literals.insert(*symbolName(item->l));
+    }
+    Compiler compiler(this->name, ellipsis, std::move(literals));
+    for (ValuePtr clause = rest->r; PairValue* item = asPair(clause); clause = item->r) {
+        compiler.compileRule(item->l, rules.emplace_back());
+    }
+
+    size_t longest = 0;
+    for (const auto& rule : rules) {
+        longest = std::max(longest, rule.min_length);
+    }
+    by_length.resize(longest + 2);
+    for (size_t length = 0; length < by_length.size(); ++length) {
+        for (const auto& rule : rules) {
+            if (rule.variadic ? rule.min_length <= length : rule.min_length == length) {
+                by_length[length].push_back(&rule);
+            }
+        }
+    }
+}
+
+SyntaxRules::~SyntaxRules() = default;
+
+ValuePtr SyntaxRules::expand(const ValuePtr& form) const {
+    const ValuePtr& args = static_cast<PairValue&>(*form).r;
+    size_t length = 0;
+    for (PairValue* pair = asPair(args); pair; pair = asPair(pair->r)) {
+        ++length;
+    }
+    std::vector<Match> slots;
+    std::vector<Match*> match_frame;
+    for (const Rule* rule : by_length[std::min(length, by_length.size() - 1)]) {
+        slots.assign(rule->slots, Match{});
+        match_frame.resize(rule->slots);
+        for (size_t i = 0; i < rule->slots; ++i) {
+            match_frame[i] = &slots[i];
+        }
+        if (!match(rule->pattern, args, match_frame)) {
+            continue;
+        }
+        std::vector<ValuePtr> renamed;
+        renamed.reserve(rule->renamed.size());
+        for (const auto& binder : rule->renamed) {
+            renamed.push_back(create_or_get_symbol(binder + "%" + std::to_string(++rename_counter)));
+        }
+        std::vector<const Match*> frame(slots.size());
+        for (size_t i = 0; i < slots.size(); ++i) {
+            frame[i] = &slots[i];
+        }
+        return instantiate(rule->tmpl, frame, renamed);
+    }
+    throw LispError(name + ": no syntax rule matches " + form->toString());
+}
+
+bool SyntaxRules::match(const Pattern& pattern, const ValuePtr& input, std::vector<Match*>& frame) {
+    switch (pattern.kind) {
+        case Pattern::ANY:
+            return true;
+        case Pattern::VARIABLE:
+            frame[pattern.slot]->value = input;
+            return true;
+        case Pattern::LITERAL:
+            return input->isSymbol() && input.get() == pattern.datum.get();
+        case Pattern::DATUM:
+            return sameDatum(pattern.datum, input);
+        case Pattern::LIST:
+            break;
+    }
+    ValuePtr rest = input;
+    for (const auto& element : pattern.prefix) {
+        PairValue* pair = asPair(rest);
+        if (!pair || !match(element, pair->l, frame)) {
+            return false;
+        }
+        rest = pair->r;
+    }
+    if (pattern.repeat) {
+        size_t available = 0;
+        for (PairValue* pair = asPair(rest); pair; pair = asPair(pair->r)) {
+            ++available;
+        }
+        if (available < pattern.suffix.size()) {
+            return false;
+        }
+        std::vector<Match*> saved(pattern.repeat_slots.size());
+        for (size_t i = 0; i < pattern.repeat_slots.size(); ++i) {
+            saved[i] = frame[pattern.repeat_slots[i]];
+        }
+        for (size_t n = available - pattern.suffix.size(); n > 0; --n) {
+            auto& pair = static_cast<PairValue&>(*rest);
+            for (size_t i = 0; i < saved.size(); ++i) {
+                frame[pattern.repeat_slots[i]] = &saved[i]->items.emplace_back();
+            }
+            bool matched = match(*pattern.repeat, pair.l, frame);
+            if (!matched) {
+                return false;
+            }
+            rest = pair.r;
+        }
+        for (size_t i = 0; i < saved.size(); ++i) {
+            frame[pattern.repeat_slots[i]] = saved[i];
+        }
+    }
+    for (const auto& element : pattern.suffix) {
+        auto& pair = static_cast<PairValue&>(*rest);
+        if (!match(element, pair.l, frame)) {
+            return false;
+        }
+        rest = pair.r;
+    }
+    return pattern.tail ? match(*pattern.tail, rest, frame) : rest->isNil();
+}
+
+void SyntaxRules::instantiateRepeat(const Template& tmpl, size_t level, std::vector<const Match*>& frame,
+                                    const std::vector<ValuePtr>& renamed, std::vector<ValuePtr>& out) {
+    if (level == tmpl.drivers.size()) {
+        out.push_back(instantiate(*tmpl.car, frame, renamed));
+        return;
+    }
+    const auto& drivers = tmpl.drivers[level];
+    size_t count = frame[drivers[0]]->items.size();
+    for (size_t slot : drivers) {
+        if (frame[slot]->items.size() != count) {
+            throw LispError("syntax-rules: pattern variables under the same ellipsis matched different lengths");
+        }
+    }
+    std::vector<const Match*> saved(drivers.size());
+    for (size_t i = 0; i < drivers.size(); ++i) {
+        saved[i] = frame[drivers[i]];
+    }
+    for (size_t n = 0; n < count; ++n) {
+        for (size_t i = 0; i < drivers.size(); ++i) {
+            frame[drivers[i]] = &saved[i]->items[n];
+        }
+        instantiateRepeat(tmpl, level + 1, frame, renamed, out);
+    }
+    for (size_t i = 0; i < drivers.size(); ++i) {
+        frame[drivers[i]] = saved[i];
+    }
+}
+
+ValuePtr SyntaxRules::instantiate(const Template& tmpl, std::vector<const Match*>& frame,
+                                  const std::vector<ValuePtr>& renamed) {
+    switch (tmpl.kind) {
+        case Template::CONSTANT:
+            return tmpl.constant;
+        case Template::VARIABLE:
+            return frame[tmpl.index]->value;
+        case Template::RENAMED:
+            return renamed[tmpl.index];
+        case Template::PAIR:
+            return std::make_shared<PairValue>(instantiate(*tmpl.car, frame, renamed),
+                                               instantiate(*tmpl.cdr, frame, renamed));
+        case Template::REPEAT:
+            break;
+    }
+    std::vector<ValuePtr> items;
+    instantiateRepeat(tmpl, 0, frame, renamed, items);
+    ValuePtr result = instantiate(*tmpl.cdr, frame, renamed);
+    for (auto it = items.rbegin(); it != items.rend(); ++it) {
+        result = std::make_shared<PairValue>(std::move(*it), std::move(result));
+    }
+    return result;
+}
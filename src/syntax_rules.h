@@ -0,0 +1,46 @@
+#ifndef SYNTAX_RULES_H
+#define SYNTAX_RULES_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "value.h"
+
+// define-syntax 定义的 syntax-rules 宏。各条规则的模式与模板在定义时编译：
+// 模式变量编号为槽位，模板中不含模式变量的部分预先构造好并在各次展开间共享。
+// 展开时先按调用形式的长度选出可能匹配的规则，再逐条匹配、实例化，整个过程不调用求值器。
+//
+// 卫生性：模板在 lambda、let、let*、letrec、do 等形式中引入的绑定名，每次展开都换成新的符号，
+// 不会捕获实参中的同名变量；模板中其他的自由标识符仍在展开处按名字解析。
+class SyntaxRules {
+public:
+    // spec 为 (syntax-rules (literal ...) (pattern template) ...)，也可以在字面量表前指定省略号符号
+    SyntaxRules(const std::string& name, const ValuePtr& spec);
+    ~SyntaxRules();
+    SyntaxRules(const SyntaxRules&) = delete;
+    SyntaxRules& operator=(const SyntaxRules&) = delete;
+
+    // 展开宏调用 form；没有匹配的规则时抛出 LispError
+    ValuePtr expand(const ValuePtr& form) const;
+
+private:
+    struct Pattern;
+    struct Template;
+    struct Match;
+    struct Rule;
+    class Compiler;
+
+    std::string name;
+    std::vector<Rule> rules;
+    // by_length[n]：实参个数为 n 的调用可能匹配的规则（按定义顺序）；更长的调用使用最后一项
+    std::vector<std::vector<const Rule*>> by_length;
+
+    static bool match(const Pattern& pattern, const ValuePtr& input, std::vector<Match*>& frame);
+    static ValuePtr instantiate(const Template& tmpl, std::vector<const Match*>& frame,
+                                const std::vector<ValuePtr>& renamed);
+    static void instantiateRepeat(const Template& tmpl, size_t level, std::vector<const Match*>& frame,
+                                  const std::vector<ValuePtr>& renamed, std::vector<ValuePtr>& out);
+};
+
+#endif
@@ -23,6 +23,14 @@ TokenPtr Token::dot() {
     return TokenPtr(new Token(TokenType::DOT));
 }
 
+TokenPtr Token::unquoteSplicing() {
+    return TokenPtr(new Token(TokenType::UNQUOTE_SPLICING));
+}
+
+TokenPtr Token::vectorBegin() {
+    return TokenPtr(new Token(TokenType::VECTOR_BEGIN));
+}
+
 std::string Token::toString() const {
     switch (type) {
         case TokenType::LEFT_PAREN: return "(LEFT_PAREN)"; break;
@@ -30,7 +38,9 @@ std::string Token::toString() const {
         case TokenType::QUOTE: return "(QUOTE)"; break;
         case TokenType::QUASIQUOTE: return "(QUASIQUOTE)"; break;
         case TokenType::UNQUOTE: return "(UNQUOTE)"; break;
+        case TokenType::UNQUOTE_SPLICING: return "(UNQUOTE_SPLICING)"; break;
         case TokenType::DOT: return "(DOT)"; break;
+        case TokenType::VECTOR_BEGIN: return "(VECTOR_BEGIN)"; break;
         default: return "(UNKNOWN)";
     }
 }
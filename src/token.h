@@ -12,7 +12,9 @@ enum class TokenType {
     QUOTE,
     QUASIQUOTE,
     UNQUOTE,
+    UNQUOTE_SPLICING,
     DOT,
+    VECTOR_BEGIN,  // #(
     BOOLEAN_LITERAL,
     NUMERIC_LITERAL,
     STRING_LITERAL,
@@ -34,6 +36,8 @@ public:
 
     static TokenPtr fromChar(char c);
     static TokenPtr dot();
+    static TokenPtr unquoteSplicing();
+    static TokenPtr vectorBegin();
 
     TokenType getType() const {
         return type;
@@ -56,11 +56,14 @@ TokenPtr Tokenizer::nextToken(int& pos) {
                 if (!comment_handled) { // 如果循环结束了还没找到闭合
                     throw SyntaxError("Unterminated block comment starting with #|");
                 }
+            } else if (pos + 1 < input.size() && input[pos + 1] == '(') {
+                pos += 2;
+                return Token::vectorBegin();
             } else if (auto result = BooleanLiteralToken::fromChar(input[pos + 1])) {
                 pos += 2;
                 return result;
             } else {
-                throw SyntaxError("Unexpected character after #. Expected 't', 'f', or '|'.");
+                throw SyntaxError("Unexpected character after #. Expected 't', 'f', '(' or '|'.");
             }
         }
         
@@ -70,6 +73,11 @@ TokenPtr Tokenizer::nextToken(int& pos) {
         }
 
         // --- 从这里开始，是原来的 token 解析逻辑，完全不变 ---
+
+        if (c == ',' && pos + 1 < input.size() && input[pos + 1] == '@') {
+            pos += 2;
+            return Token::unquoteSplicing();
+        }
         
         if (auto token = Token::fromChar(c)) {
             pos++;
@@ -1,5 +1,6 @@
 #include "value.h"
 #include "error.h"
+#include <algorithm>
 #include <sstream>
 #include <numeric>
 #include <string>
@@ -36,7 +37,7 @@ std::string NilValue::toString() const {
     return "()";
 }
 
-SymbolValue::SymbolValue(const std::string& name) : name(name) {}
+SymbolValue::SymbolValue(const std::string& name, size_t id) : name(name), id(id) {}
 
 std::string SymbolValue::toString() const {
     return name;
@@ -44,6 +45,20 @@ std::string SymbolValue::toString() const {
 
 PairValue::PairValue(ValuePtr l, ValuePtr r) : l(l), r(r) {}
 
+PairValue::~PairValue() {
+    // 沿 cdr 逐个释放；流（cons-stream）的 cdr 是已求值的 promise，同样沿它的值继续
+    ValuePtr rest = std::move(r);
+    while (rest && rest.use_count() == 1) {
+        if (typeid(*rest) == typeid(PairValue)) {
+            rest = std::move(static_cast<PairValue&>(*rest).r);
+        } else if (typeid(*rest) == typeid(PromiseValue) && static_cast<PromiseValue&>(*rest).state.use_count() == 1) {
+            rest = std::move(static_cast<PromiseValue&>(*rest).state->value);
+        } else {
+            break;
+        }
+    }
+}
+
 std::string PairValue::toString() const {
     std::string result = "(" + l->toString();
     ValuePtr temp = r;
@@ -62,11 +77,23 @@ std::string PairValue::toString() const {
     }
 }
 
+std::string VectorValue::toString() const {
+    std::string result = "#(";
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (i > 0) {
+            result += " ";
+        }
+        result += elements[i]->toString();
+    }
+    return result + ")";
+}
+
 bool Value::isSelfEvaluating() {
     return typeid(*this) == typeid(BooleanValue)
         || typeid(*this) == typeid(NumericValue)
         || typeid(*this) == typeid(StringValue)
-        || typeid(*this) == typeid(RationalValue);
+        || typeid(*this) == typeid(RationalValue)
+        || typeid(*this) == typeid(VectorValue);
 }
 
 bool Value::isNil() {
@@ -122,7 +149,7 @@ std::string BuiltinProcValue :: toString() const {
     return "#<procedure>";
 }
 
-LambdaValue::LambdaValue(std::string name, const std::vector<std::string>& params, const std::vector<ValuePtr>& body, std::shared_ptr<EvalEnv> env) : name(std::move(name)), params(params), body(body), captured_env(std::move(env)) {}
+LambdaValue::LambdaValue(std::string name, const std::vector<std::string>& params, const std::vector<ValuePtr>& body, std::shared_ptr<EvalEnv> env) : name(std::move(name)), params(params), code(std::make_shared<const LambdaCode>(body)), source_body(body), captured_env(std::move(env)) {}
 
 std::string LambdaValue::toString() const {
     return "#<procedure>";
@@ -132,8 +159,8 @@ const std::vector<std::string>& LambdaValue::get_params() const {
     return params;
 }
 
-const std::vector<ValuePtr>& LambdaValue::get_body() const {
-    return body;
+std::shared_ptr<const LambdaCode> LambdaValue::get_code() const {
+    return code;
 }
 
 std::shared_ptr<EvalEnv> LambdaValue::get_captured_env() const {
@@ -173,7 +200,8 @@ bool Value::isList(){
 }
 
 bool Value::isProcedure(){
-    return typeid(*this) == typeid(BuiltinProcValue) || typeid(*this) == typeid(LambdaValue);
+    return typeid(*this) == typeid(BuiltinProcValue) || typeid(*this) == typeid(LambdaValue) ||
+           typeid(*this) == typeid(ContinuationValue);
 }
 
 double Value::asNumber(){
@@ -201,19 +229,13 @@ std::string StringValue::asString(){
 }
 
 ValuePtr toList(std::vector<ValuePtr>& params){
-    if (params.empty()){
-        return LISP_NIL;
+    // 从末尾向前构造，元素移入表中，params 随后清空
+    ValuePtr list = LISP_NIL;
+    for (auto it = params.rbegin(); it != params.rend(); ++it) {
+        list = std::make_shared<PairValue>(std::move(*it), std::move(list));
     }
-    auto head = std::make_shared<PairValue>(params.front(), LISP_NIL);
-    ValuePtr current = head;
-    params.erase(params.begin());
-    while(!params.empty()){
-        auto newPair = std::make_shared<PairValue>(params.front(), LISP_NIL);
-        static_cast<PairValue*>(current.get())->r = newPair;
-        current = newPair;
-        params.erase(params.begin());
-    }
-    return head;
+    params.clear();
+    return list;
 }
 
 bool Value::getboolValue(){
@@ -248,4 +270,104 @@ std::string RationalValue::toString() const {
 
 double RationalValue::asNumber() {
     return static_cast<double>(numerator) / denominator;
-}
\ No newline at end of file
+}
+
+namespace {
+
+// 表或向量的元素超出 limit 时停止，返回 false
+bool appendBrief(std::string& out, const Value& value, size_t limit) {
+    if (typeid(value) == typeid(VectorValue)) {
+        out += "#(";
+        const auto& elements = static_cast<const VectorValue&>(value).elements;
+        for (size_t i = 0; i < elements.size(); ++i) {
+            if (out.size() >= limit) {
+                return false;
+            }
+            if (i > 0) {
+                out += ' ';
+            }
+            if (!appendBrief(out, *elements[i], limit)) {
+                return false;
+            }
+        }
+        out += ')';
+        return true;
+    }
+    if (typeid(value) != typeid(PairValue)) {
+        out += value.toString();
+        return true;
+    }
+    out += '(';
+    const Value* node = &value;
+    for (bool first = true; typeid(*node) == typeid(PairValue); first = false) {
+        if (out.size() >= limit) {
+            return false;
+        }
+        auto& pair = static_cast<const PairValue&>(*node);
+        if (!first) {
+            out += ' ';
+        }
+        if (!appendBrief(out, *pair.l, limit)) {
+            return false;
+        }
+        node = pair.r.get();
+    }
+    if (typeid(*node) != typeid(NilValue)) {
+        out += " . " + node->toString();
+    }
+    out += ')';
+    return true;
+}
+
+}  // namespace
+
+std::string brief_repr(const Value& value, size_t limit) {
+    std::string result;
+    if (!appendBrief(result, value, limit) || result.size() > limit) {
+        result.resize(std::min(result.size(), limit - 3));
+        result += "...";
+    }
+    return result;
+}
+
+void MultipleValuesValue::assign(const ValuePtr* values, size_t n) {
+    count = n;
+    if (n <= INLINE_COUNT) {
+        std::copy(values, values + n, inline_values.begin());
+        more.clear();
+    } else {
+        more.assign(values, values + n);
+    }
+}
+
+void MultipleValuesValue::release() {
+    std::fill(inline_values.begin(), inline_values.end(), nullptr);
+    more.clear();
+    count = 0;
+}
+
+std::string MultipleValuesValue::toString() const {
+    std::string result;
+    for (size_t i = 0; i < count; ++i) {
+        result += (i ? " " : "") + (*this)[i]->toString();
+    }
+    return result;
+}
+
+std::string ErrorObjectValue::toString() const {
+    return "#<error " + describe() + ">";
+}
+
+std::string ErrorObjectValue::describe() const {
+    std::string result = message;
+    for (const Value* node = irritants.get(); typeid(*node) == typeid(PairValue);) {
+        auto& pair = static_cast<const PairValue&>(*node);
+        result += " " + brief_repr(*pair.l);
+        node = pair.r.get();
+        if (result.size() > 400) {
+            result += " ...";
+            break;
+        }
+    }
+    return result;
+}
@@ -1,9 +1,11 @@
 #ifndef VALUE_H
 #define VALUE_H
+#include <array>
 #include <string>
 #include <vector>
 #include <memory>
 #include <optional>
+#include <cstdint>
 
 class EvalEnv;
 
@@ -69,10 +71,13 @@ public:
 class SymbolValue : public Value {
 private:
     std::string name;
+    size_t id;  // 驻留时按顺序分配，全局环境按它索引绑定格
 public:
-    SymbolValue(const std::string& name);
+    SymbolValue(const std::string& name, size_t id);
+    size_t getId() const { return id; }
     std::string toString()const override;
     std::optional<std::string> asSymbol()override;
+    const std::string& getName() const { return name; }
 };
 
 class PairValue:public Value{
@@ -80,33 +85,153 @@ public:
     ValuePtr l;
     ValuePtr r;
     PairValue(ValuePtr l,ValuePtr r);
+    // 沿 cdr 逐个释放只被本序对引用的后继序对，长表的析构不会递归耗尽栈
+    ~PairValue() override;
     std::string toString()const override;
 };
 
+// 向量：元素连续存放，按下标直接访问与修改
+class VectorValue : public Value {
+public:
+    std::vector<ValuePtr> elements;
+    explicit VectorValue(std::vector<ValuePtr> elements) : elements(std::move(elements)) {}
+    std::string toString() const override;
+};
+
 using BuiltinFuncType = ValuePtr (*)(const std::vector<ValuePtr>& args, EvalEnv& env);
 
+struct BuiltinDescriptor;
+
 class BuiltinProcValue : public Value {
-    BuiltinFuncType func;
+    const BuiltinDescriptor* descriptor;
 public:
-    BuiltinProcValue(BuiltinFuncType func):func{func}{}
+    BuiltinProcValue(const BuiltinDescriptor* descriptor):descriptor{descriptor}{}
     std::string toString()const override;
-    BuiltinFuncType get_function_pointer(){
-        return func;
+    const BuiltinDescriptor& get_descriptor() const {
+        return *descriptor;
     }
 };
 
+// 优化后的过程体及分析结果。重新优化时整体替换，正在执行的调用仍持有旧的版本
+struct LambdaCode {
+    LambdaCode() = default;
+    explicit LambdaCode(std::vector<ValuePtr> body) : body(std::move(body)) {}
+
+    std::vector<ValuePtr> body;
+    // 调用帧是否可能在返回后仍被引用；不会逃逸的帧分配在 FrameArena 中
+    bool frame_escapes = true;
+    // 调用时预先装箱的绑定：过程体中的闭包可能在定义执行之前就捕获的内部定义名，
+    // 以及闭包捕获后仍会被 set! 修改的形参
+    std::vector<std::string> boxed_bindings;
+};
+
 class LambdaValue : public Value {
 public:
+    static constexpr std::uint64_t NOT_OPTIMIZED = UINT64_MAX;
     std::string name;
     std::vector<std::string> params;
-    std::vector<ValuePtr> body;
+    std::shared_ptr<const LambdaCode> code;
+    std::vector<ValuePtr> source_body;  // 原始过程体，相关绑定被重新定义后据此重新优化
+    std::uint64_t optimized_epoch = NOT_OPTIMIZED;
+    // 定义在全局时为全局环境；否则通常只含过程体中的自由变量（见 make_lambda）
     std::shared_ptr<EvalEnv> captured_env;
     LambdaValue(std::string name, const std::vector<std::string>& params, const std::vector<ValuePtr>& body, std::shared_ptr<EvalEnv> env);
     std::string toString() const override; 
     const std::vector<std::string>& get_params() const;
-    const std::vector<ValuePtr>& get_body() const;
+    std::shared_ptr<const LambdaCode> get_code() const;
     std::shared_ptr<EvalEnv> get_captured_env() const;
 };
+
+// 可能被闭包捕获且可能被修改的局部绑定，以及全局环境中的绑定格。绑定表中存放 BoxValue，
+// 闭包复制的是盒子本身，因此之后的修改对双方可见。查找变量时自动取出其中的值。
+class BoxValue : public Value {
+public:
+    ValuePtr value;  // 尚未定义时为空
+    explicit BoxValue(ValuePtr value = nullptr) : value(std::move(value)) {}
+    std::string toString() const override {
+        return "#<box>";
+    }
+};
+
+// call/cc 捕获的逃逸续延。只能在 call/cc 返回之前、在捕获它的执行流（主流程或同一个协程任务）中调用，
+// 调用时求值器逐层返回 LISP_ESCAPE（见 eval_env.h），沿途的帧照常释放，由创建它的 call/cc 返回实参
+class ContinuationValue : public Value {
+public:
+    bool active = true;   // call/cc 返回后置为 false
+    const void* owner;    // 捕获时所在的任务，主流程为 nullptr
+    explicit ContinuationValue(const void* owner) : owner(owner) {}
+    std::string toString() const override {
+        return "#<continuation>";
+    }
+};
+
+// promise 的状态。force 一个 delay-force 得到另一个 promise 时，把它的状态移到本 promise 中，
+// 并让两者共享同一个 PromiseState（R7RS 的做法），循环直到得到值，长的 delay-force 链不在原生栈上递归
+struct PromiseState {
+    bool done = false;
+    bool delay_force = false;  // 表达式的结果是另一个 promise
+    ValuePtr value;            // done 时为值
+    ValuePtr expr;             // 尚未求值时的表达式及其环境，求值后释放
+    std::shared_ptr<EvalEnv> env;
+};
+
+// delay、delay-force、cons-stream 与 make-promise 创建的 promise，force 后记住结果
+class PromiseValue : public Value {
+public:
+    std::shared_ptr<PromiseState> state;
+    explicit PromiseValue(std::shared_ptr<PromiseState> state) : state(std::move(state)) {}
+    std::string toString() const override {
+        return "#<promise>";
+    }
+};
+
+// values 返回的多个值（个数不为 1 时）。不超过 4 个的值存放在对象内部，对象本身在线程内循环使用
+// （见 builtin_values），常见情形下传递多个值不分配内存
+class MultipleValuesValue : public Value {
+public:
+    static constexpr size_t INLINE_COUNT = 4;
+
+    void assign(const ValuePtr* values, size_t count);
+    // 清空保存的值。消费方取出各个值、确认对象不再被别处引用后调用，避免池延长这些值的生存期
+    void release();
+    size_t size() const {
+        return count;
+    }
+    const ValuePtr& operator[](size_t i) const {
+        return count <= INLINE_COUNT ? inline_values[i] : more[i];
+    }
+    std::string toString() const override;
+
+private:
+    std::array<ValuePtr, INLINE_COUNT> inline_values;
+    std::vector<ValuePtr> more;  // 超过 INLINE_COUNT 个值时存放全部的值
+    size_t count = 0;
+};
+
+// guard / with-exception-handler 处理 error 与运行时错误时得到的条件对象。信息与附带的值（irritants）原样保存，
+// 只在显示或作为未处理的错误报告时才格式化，且长度有上限
+class ErrorObjectValue : public Value {
+public:
+    std::string message;
+    ValuePtr irritants;  // 表
+    ErrorObjectValue(std::string message, ValuePtr irritants)
+        : message(std::move(message)), irritants(std::move(irritants)) {}
+    std::string toString() const override;
+    // 报告用的信息：message 之后依次是各个 irritant 的简短表示
+    std::string describe() const;
+};
+
+// 优化器把过程体中对全局变量的引用改写为它：直接指向全局环境中的绑定格，
+// 求值时不必再逐层按名字查找；全局 define 原地更新绑定格，这些引用随之看到新值。
+class GlobalRefValue : public Value {
+public:
+    std::shared_ptr<BoxValue> cell;
+    ValuePtr symbol;
+    GlobalRefValue(std::shared_ptr<BoxValue> cell, ValuePtr symbol) : cell(std::move(cell)), symbol(std::move(symbol)) {}
+    std::string toString() const override {
+        return symbol->toString();
+    }
+};
 class RationalValue : public Value {
 private:
     int numerator;
@@ -123,6 +248,9 @@ class MacroValue : public Value {
 public:
     std::vector<std::string> params;
     ValuePtr body;
+    // 编译了 quasiquote 模板的宏体（见 refresh_macro），定义了新的宏等情况下从 body 重新编译
+    ValuePtr code;
+    std::uint64_t optimized_epoch = LambdaValue::NOT_OPTIMIZED;
     MacroValue(const std::vector<std::string>& params, ValuePtr body)
         : params(params), body(body) {}
     std::string toString() const override {
@@ -130,6 +258,19 @@ public:
     }
 };
 
+class SyntaxRules;
+// define-syntax 定义的宏，规则在定义时已编译（见 syntax_rules.h）
+class SyntaxRulesValue : public Value {
+public:
+    std::shared_ptr<const SyntaxRules> rules;
+    explicit SyntaxRulesValue(std::shared_ptr<const SyntaxRules> rules) : rules(std::move(rules)) {}
+    std::string toString() const override {
+        return "#<syntax>";
+    }
+};
+
 ValuePtr toList(std::vector<ValuePtr>& params);
+// 错误信息中使用的外部表示，至多 limit 个字符，超出部分以 "..." 结尾；很长的表只访问开头的元素
+std::string brief_repr(const Value& value, size_t limit = 80);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "worker_pool.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "eval_env.h"
+#include "framing.h"
+#include "runner.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+int runWorkerPool(int workers, const std::shared_ptr<EvalEnv>& root, int jobs_fd) {
+    std::cerr << "Error: --workers is not supported on this platform." << std::endl;
+    return 1;
+}
+
+#else
+
+namespace {
+
+// 每个工作进程对应的已读入、尚未输出的任务数上限
+constexpr size_t WINDOW_PER_WORKER = 16;
+
+struct Worker {
+    pid_t pid = -1;
+    int to_worker = -1;
+    int from_worker = -1;
+    long job = -1;  // 正在执行的任务下标，-1 表示空闲
+};
+
+RunResult runJob(const std::shared_ptr<EvalEnv>& root, const std::string& job) {
+    std::string source = job;
+    std::ifstream file(job);
+    if (file.good()) {
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        source = buffer.str();
+    }
+    auto job_env = std::make_shared<EvalEnv>(root);
+    job_env->toplevel = true;
+    RunResult result = runCaptured(*job_env, source);
+    job_env->clearBindings();
+    return result;
+}
+
+[[noreturn]] void workerLoop(int in, int out, const std::shared_ptr<EvalEnv>& root) {
+    std::string job;
+    while (readFrame(in, job)) {
+        if (!writeResult(out, runJob(root, job))) {
+            break;
+        }
+    }
+    _exit(0);
+}
+
+bool startWorker(Worker& worker, const std::vector<Worker>& all, const std::shared_ptr<EvalEnv>& root) {
+    int to_worker[2];
+    int from_worker[2];
+    if (::pipe(to_worker) < 0) {
+        return false;
+    }
+    if (::pipe(from_worker) < 0) {
+        ::close(to_worker[0]);
+        ::close(to_worker[1]);
+        return false;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(to_worker[1]);
+        ::close(from_worker[0]);
+        // 关闭继承来的其他工作进程的管道，否则父进程检测不到它们退出
+        for (const auto& other : all) {
+            if (other.pid > 0) {
+                ::close(other.to_worker);
+                ::close(other.from_worker);
+            }
+        }
+        workerLoop(to_worker[0], from_worker[1], root);
+    }
+    ::close(to_worker[0]);
+    ::close(from_worker[1]);
+    if (pid < 0) {
+        ::close(to_worker[1]);
+        ::close(from_worker[0]);
+        return false;
+    }
+    worker = Worker{pid, to_worker[1], from_worker[0], -1};
+    return true;
+}
+
+void stopWorker(Worker& worker) {
+    ::close(worker.to_worker);
+    ::close(worker.from_worker);
+    ::waitpid(worker.pid, nullptr, 0);
+    worker = Worker{};
+}
+
+// 工作进程意外退出：回收并描述退出原因
+std::string reapCrashed(Worker& worker) {
+    ::close(worker.to_worker);
+    ::close(worker.from_worker);
+    int status = 0;
+    ::waitpid(worker.pid, &status, 0);
+    worker = Worker{};
+    if (WIFSIGNALED(status)) {
+        return "worker crashed with signal " + std::to_string(WTERMSIG(status));
+    }
+    return "worker exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+}  // namespace
+
+int runWorkerPool(int workers, const std::shared_ptr<EvalEnv>& root, int jobs_fd) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // 已读入、尚未按顺序输出的任务，window[i] 是第 first_job + i 个任务。输出一个弹出一个，
+    // 超过上限时暂停读入，前面的任务较慢时也不会把后面的结果全部积压在内存中
+    struct Slot {
+        std::string job;
+        std::optional<RunResult> result;
+    };
+    std::deque<Slot> window;
+    const size_t window_limit = static_cast<size_t>(workers) * WINDOW_PER_WORKER;
+    size_t first_job = 0;
+    size_t next_job = 0;  // 下一个要分派的任务
+    std::string input;    // 尚未读到换行符的部分
+    bool input_done = false;
+    auto addJob = [&](std::string line) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            window.push_back({std::move(line), std::nullopt});
+        }
+    };
+
+    std::vector<Worker> pool;
+    pool.reserve(workers);
+    int exit_code = 0;
+    while (true) {
+        // 把任务分派给空闲的工作进程；都在忙而进程数未到上限时再 fork 一个
+        for (size_t w = 0; next_job < first_job + window.size(); ++w) {
+            if (w == pool.size()) {
+                if (pool.size() == static_cast<size_t>(workers)) {
+                    break;
+                }
+                pool.emplace_back();
+            }
+            Worker& worker = pool[w];
+            while (worker.job < 0 && next_job < first_job + window.size()) {
+                Slot& slot = window[next_job - first_job];
+                long job = static_cast<long>(next_job++);
+                if (worker.pid < 0 && !startWorker(worker, pool, root)) {
+                    slot.result = RunResult{false, "", "failed to start worker process"};
+                    continue;
+                }
+                if (writeFrame(worker.to_worker, slot.job)) {
+                    worker.job = job;
+                } else {
+                    slot.result = RunResult{false, "", reapCrashed(worker)};
+                }
+            }
+        }
+
+        // 按任务顺序输出已完成的结果
+        while (!window.empty() && window.front().result) {
+            const Slot& slot = window.front();
+            std::cout << slot.result->output << std::flush;
+            if (!slot.result->ok) {
+                std::cerr << "Error: " << slot.job << ": " << slot.result->value << std::endl;
+                exit_code = 1;
+            }
+            window.pop_front();
+            ++first_job;
+        }
+        if (input_done && window.empty()) {
+            break;
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<Worker*> busy;
+        bool reading = !input_done && window.size() < window_limit;
+        if (reading) {
+            fds.push_back({jobs_fd, POLLIN, 0});
+        }
+        for (auto& worker : pool) {
+            if (worker.job >= 0) {
+                fds.push_back({worker.from_worker, POLLIN, 0});
+                busy.push_back(&worker);
+            }
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        if (reading && fds[0].revents) {
+            char buffer[64 * 1024];
+            ssize_t n = ::read(jobs_fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                input.append(buffer, static_cast<size_t>(n));
+                size_t begin = 0;
+                for (size_t end; (end = input.find('\n', begin)) != std::string::npos; begin = end + 1) {
+                    addJob(input.substr(begin, end - begin));
+                }
+                input.erase(0, begin);
+            } else if (n == 0 || errno != EINTR) {
+                addJob(std::move(input));
+                input_done = true;
+            }
+        }
+        for (size_t i = reading ? 1 : 0; i < fds.size(); ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            Worker& worker = *busy[i - (reading ? 1 : 0)];
+            Slot& slot = window[static_cast<size_t>(worker.job) - first_job];
+            RunResult result;
+            if (readResult(worker.from_worker, result)) {
+                worker.job = -1;
+                slot.result = std::move(result);
+            } else {
+                slot.result = RunResult{false, "", reapCrashed(worker)};
+            }
+        }
+    }
+
+    for (auto& worker : pool) {
+        if (worker.pid > 0) {
+            stopWorker(worker);
+        }
+    }
+    return exit_code;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <memory>
+
+class EvalEnv;
+
+// 预热进程池模式：root 初始化完毕后 fork 出 workers 个工作进程，
+// 它们以写时复制的方式共享预热好的堆。任务从文件描述符 jobs_fd 中逐行读取，读到一行即分派：
+// 已存在的文件路径按脚本执行，其余行按表达式求值。
+// 结果按任务顺序输出；工作进程崩溃只影响当前任务，随后会被重新 fork。
+int runWorkerPool(int workers, const std::shared_ptr<EvalEnv>& root, int jobs_fd);
+
+#endif
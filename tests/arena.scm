@@ -0,0 +1,41 @@
+; 调用帧的栈式分配与逃逸分析（见 extensions.md 第 13 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 不逃逸的帧：普通递归
+(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+(check "fib" (fib 20) 6765)
+(define (tak x y z) (if (not (< y x)) z (tak (tak (- x 1) y z) (tak (- y 1) z x) (tak (- z 1) x y))))
+(check "tak" (tak 12 8 4) 5)
+(define (count-down n) (if (= n 0) 'done (count-down (- n 1))))
+(check "deep recursion" (count-down 2000) 'done)
+
+; 创建闭包或内部定义过程的帧会逃逸，返回后仍可使用
+(define (make-adder n) (lambda (x) (+ x n)))
+(define add5 (make-adder 5))
+(check "closure" (add5 1) 6)
+(define (make-counter start) (define (next) (+ start 1)) next)
+(check "inner define" ((make-counter 41)) 42)
+(define (make-pair a b) (let ((get-a (lambda () a)) (get-b (lambda () b))) (list get-a get-b)))
+(define getters (make-pair 'x 'y))
+(check "let closures" (list ((car getters)) ((car (cdr getters)))) '(x y))
+
+; 条件执行的内部定义也会使帧逃逸
+(define (maybe-closure flag n) (if flag (define f (lambda () n))) (if flag f #f))
+(check "conditional define" ((maybe-closure #t 7)) 7)
+
+; 在 eval 中使用调用处的环境
+(define (eval-here x) (eval '(* x 2)))
+(check "eval" (eval-here 21) 42)
+
+; 协程交替执行时帧不按栈顺序释放
+(define (work n acc) (if (= n 0) acc (begin (yield) (work (- n 1) (+ acc n)))))
+(define tasks (map (lambda (n) (spawn (lambda () (work n 0)))) '(10 50 20 100 5)))
+(check "interleaved" (map join tasks) '(55 1275 210 5050 15))
+(check "after tasks" (fib 15) 610)
+
+; 任务中逃逸的闭包
+(define t (spawn (lambda () (yield) (make-adder 100))))
+(check "closure from task" ((join t) 1) 101)
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""--batch 模式与脚本模式下的 exit（见 extensions.md 第 8 节）。
+
+用法：batch.py MINI_LISP。检查失败时抛出 AssertionError，以非零状态退出。
+"""
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def write_scripts(workdir, scripts):
+    paths = []
+    for name, source in scripts:
+        path = os.path.join(workdir, name)
+        with open(path, "w") as f:
+            f.write(source)
+        paths.append(path)
+    return paths
+
+
+def run(args, **kwargs):
+    return subprocess.run(args, capture_output=True, text=True, timeout=60, **kwargs)
+
+
+def main():
+    binary = sys.argv[1]
+    workdir = tempfile.mkdtemp()
+
+    # 各文件的输出按命令行顺序打印；文件之间互不影响
+    paths = write_scripts(workdir, [
+        ("a.scm", "(define x 1) (sleep 0.05) (display 'a)"),
+        ("b.scm", "(display 'b) (display x)"),
+        ("c.scm", "(display 'c) (exit 0)"),
+        ("d.scm", "(display 'd) (exit 3) (display 'unreachable)"),
+        ("e.scm", "(display (join (spawn (lambda () (yield) 'e))))"),
+        ("f.scm", "(join (spawn (lambda () (exit 4)))) (display 'unreachable)"),
+    ])
+    result = run([binary, "--batch"] + paths)
+    assert result.stdout == "abcde", result.stdout
+    assert result.returncode == 1
+    status = [next(line.split()[0] for line in result.stderr.splitlines() if path in line) for path in paths]
+    assert status == ["ok", "FAIL", "ok", "FAIL", "ok", "FAIL"], result.stderr
+    assert "exit 4" in result.stderr, result.stderr
+
+    # 清单文件
+    manifest = os.path.join(workdir, "list.txt")
+    with open(manifest, "w") as f:
+        f.write(paths[0] + "\n\n" + paths[2] + "\n")
+    result = run([binary, "--batch", "@" + manifest])
+    assert result.returncode == 0 and result.stdout == "ac", result.stdout
+
+    # 脚本模式：任务中调用 exit 结束整个进程
+    script, = write_scripts(workdir, [("exit.scm", "(join (spawn (lambda () (display 'x) (exit 4)))) (display 'y)")])
+    result = run([binary, script])
+    assert result.returncode == 4 and result.stdout == "x", (result.returncode, result.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,5 @@
+; 第 20 节：对全局累加器 set! 的 30 万次迭代
+(define total 0)
+(define (add! x) (set! total (+ total x)))
+(do ((i 0 (+ i 1))) ((= i 300000)) (add! i))
+(display total) (newline)
@@ -0,0 +1,8 @@
+; 第 20 节：30 万次迭代的三路计数，每一轮重建计数表的函数式写法
+(define (bump counts k)
+  (cond ((= k 0) (list (+ (car counts) 1) (car (cdr counts)) (car (cdr (cdr counts)))))
+        ((= k 1) (list (car counts) (+ (car (cdr counts)) 1) (car (cdr (cdr counts)))))
+        (else (list (car counts) (car (cdr counts)) (+ (car (cdr (cdr counts))) 1)))))
+(define (tally n)
+  (do ((i 0 (+ i 1)) (counts (list 0 0 0) (bump counts (remainder i 3)))) ((= i n) counts)))
+(display (tally 300000)) (newline)
@@ -0,0 +1,10 @@
+; 第 20 节：30 万次迭代的三路计数，用 set! 更新闭包中的计数器
+(define (tally n)
+  (let ((a 0) (b 0) (c 0))
+    (define (bump! k)
+      (cond ((= k 0) (set! a (+ a 1)))
+            ((= k 1) (set! b (+ b 1)))
+            (else (set! c (+ c 1)))))
+    (do ((i 0 (+ i 1))) ((= i n) (list a b c))
+      (bump! (remainder i 3)))))
+(display (tally 300000)) (newline)
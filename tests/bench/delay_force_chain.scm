@@ -0,0 +1,3 @@
+; 第 25 节：100 万层的 delay-force 链
+(define (loop n) (delay-force (if (= n 0) (delay 'done) (loop (- n 1)))))
+(display (force (loop 1000000))) (newline)
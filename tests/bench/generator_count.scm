@@ -0,0 +1,3 @@
+; 第 26 节：生成器逐个产生 100 万个元素
+(define (counter n) (make-generator (lambda () (do ((i 0 (+ i 1))) ((= i n)) (generator-yield i)))))
+(display (reduce + (counter 1000000))) (newline)
@@ -0,0 +1,3 @@
+; 第 23 节：100 万次迭代，每一轮用 guard 捕获 car 的类型错误
+(do ((i 0 (+ i 1))) ((= i 1000000))
+  (guard (e (#t e)) (car i)))
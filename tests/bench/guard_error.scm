@@ -0,0 +1,3 @@
+; 第 23 节：100 万次迭代，每一轮用 guard 捕获 error
+(do ((i 0 (+ i 1))) ((= i 1000000))
+  (guard (e (#t e)) (error "boom" i)))
@@ -0,0 +1,3 @@
+; 第 23 节：与 guard_error.scm 相同的循环，不引发错误
+(do ((i 0 (+ i 1))) ((= i 1000000))
+  (guard (e (#t e)) i))
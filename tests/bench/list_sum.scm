@@ -0,0 +1,3 @@
+; 第 27 节：与 vector_sum.scm 相同的求和，改为用 car/cdr 遍历表
+(define l (vector->list (make-vector 1000000 1)))
+(display (do ((l l (cdr l)) (acc 0 (+ acc (car l)))) ((null? l) acc))) (newline)
@@ -0,0 +1,3 @@
+; 第 19 节：100 万次迭代的累加，do
+(define (run n) (do ((i n (- i 1)) (acc 0 (+ acc (remainder i 1001)))) ((= i 0) acc)))
+(display (run 1000000)) (newline)
@@ -0,0 +1,3 @@
+; 第 19 节：100 万次迭代的累加，命名 let
+(define (run n) (let loop ((i n) (acc 0)) (if (= i 0) acc (loop (- i 1) (+ acc (remainder i 1001))))))
+(display (run 1000000)) (newline)
@@ -0,0 +1,3 @@
+; 第 19 节：1000 万次迭代的命名 let，峰值 RSS 不随迭代次数增长
+(define (run n) (let loop ((i n) (acc 0)) (if (= i 0) acc (loop (- i 1) (+ acc (remainder i 1001))))))
+(display (run 10000000)) (newline)
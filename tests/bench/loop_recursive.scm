@@ -0,0 +1,4 @@
+; 第 19 节：100 万次迭代的累加，写成两层尾递归的辅助过程
+(define (inner i acc) (if (= i 0) acc (inner (- i 1) (+ acc (remainder i 1001)))))
+(define (outer j acc) (if (= j 0) acc (outer (- j 1) (inner 1000 acc))))
+(display (outer 1000 0)) (newline)
@@ -0,0 +1,2 @@
+; 第 26 节：与 range_reduce.scm 相同的求和，写成 do 循环
+(display (do ((i 0 (+ i 1)) (acc 0 (+ acc i))) ((= i 10000000) acc))) (newline)
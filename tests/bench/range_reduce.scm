@@ -0,0 +1,2 @@
+; 第 26 节：对 1000 万个数求和，不构造表
+(display (reduce + (in-range 0 10000000))) (newline)
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""运行 tests/bench 中的脚本，报告最短的用户态时间与峰值 RSS。
+
+用法：run.py MINI_LISP [脚本 ...] [--runs N]
+不给脚本时运行本目录下全部 .scm。应使用 Release 构建的解释器。
+"""
+import argparse
+import glob
+import os
+import resource
+import subprocess
+import sys
+
+
+def measure(binary, script, runs):
+    best = None
+    for _ in range(runs):
+        before = resource.getrusage(resource.RUSAGE_CHILDREN)
+        subprocess.run([binary, script], stdout=subprocess.DEVNULL, check=True)
+        after = resource.getrusage(resource.RUSAGE_CHILDREN)
+        elapsed = after.ru_utime - before.ru_utime
+        best = elapsed if best is None else min(best, elapsed)
+    # ru_maxrss 是已结束子进程中的最大值；每个脚本单独起一个进程测量，避免与之前的脚本混在一起
+    rss = subprocess.run(
+        [sys.executable, "-c",
+         "import resource, subprocess, sys;"
+         "subprocess.run(sys.argv[1:], stdout=subprocess.DEVNULL, check=True);"
+         "print(resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss)",
+         binary, script],
+        capture_output=True, text=True, check=True).stdout.strip()
+    return best, int(rss)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("binary")
+    parser.add_argument("scripts", nargs="*")
+    parser.add_argument("--runs", type=int, default=3)
+    args = parser.parse_args()
+    here = os.path.dirname(os.path.abspath(__file__))
+    scripts = args.scripts or sorted(glob.glob(os.path.join(here, "*.scm")))
+    for script in scripts:
+        elapsed, rss = measure(args.binary, script, args.runs)
+        print("%-24s user %6.2fs  maxrss %6d KB" % (os.path.basename(script), elapsed, rss))
+
+
+if __name__ == "__main__":
+    main()
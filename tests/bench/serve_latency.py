@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""第 6 节：小脚本逐个 fork-exec 运行与发往 --serve 服务的延迟对比（p50 / p99）。
+
+用法：serve_latency.py MINI_LISP [请求数，默认 500]
+"""
+import os
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+SOURCE = b"(define (f n) (if (= n 0) 0 (+ n (f (- n 1))))) (display (f 100))"
+
+
+def percentiles(samples):
+    samples = sorted(samples)
+    return samples[len(samples) // 2] * 1e3, samples[int(len(samples) * 0.99)] * 1e3
+
+
+def recv_exact(conn, size):
+    data = b""
+    while len(data) < size:
+        chunk = conn.recv(size - len(data))
+        if not chunk:
+            raise EOFError("server closed the connection")
+        data += chunk
+    return data
+
+
+def request(conn, source):
+    conn.sendall(struct.pack(">I", len(source)) + source)
+    status = recv_exact(conn, 1)[0]
+    output = recv_exact(conn, struct.unpack(">I", recv_exact(conn, 4))[0])
+    value = recv_exact(conn, struct.unpack(">I", recv_exact(conn, 4))[0])
+    return status, output, value
+
+
+def main():
+    binary = sys.argv[1]
+    count = int(sys.argv[2]) if len(sys.argv) > 2 else 500
+    workdir = tempfile.mkdtemp()
+    script = os.path.join(workdir, "job.lisp")
+    with open(script, "wb") as f:
+        f.write(SOURCE)
+
+    latencies = []
+    for _ in range(count):
+        start = time.perf_counter()
+        output = subprocess.run([binary, script], capture_output=True, check=True).stdout
+        latencies.append(time.perf_counter() - start)
+    assert output == b"5050", output
+    print("fork-exec  p50 %.2fms  p99 %.2fms" % percentiles(latencies))
+
+    sock = os.path.join(workdir, "serve.sock")
+    server = subprocess.Popen([binary, "--serve", sock])
+    try:
+        conn = socket.socket(socket.AF_UNIX)
+        for _ in range(500):
+            try:
+                conn.connect(sock)
+                break
+            except (FileNotFoundError, ConnectionRefusedError):
+                time.sleep(0.01)
+        latencies = []
+        for _ in range(count):
+            start = time.perf_counter()
+            status, output, _ = request(conn, SOURCE)
+            latencies.append(time.perf_counter() - start)
+            assert status == 0 and output == b"5050", (status, output)
+        print("serve      p50 %.2fms  p99 %.2fms" % percentiles(latencies))
+        status, _, value = request(conn, b"(car 1)")
+        assert status == 1, value
+    finally:
+        server.kill()
+        server.wait()
+        os.unlink(script)
+        if os.path.exists(sock):
+            os.unlink(sock)
+        os.rmdir(workdir)
+
+
+if __name__ == "__main__":
+    main()
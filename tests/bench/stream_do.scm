@@ -0,0 +1,3 @@
+; 第 25 节：用 do 遍历流的 100 万个元素
+(define (ints n) (cons-stream n (ints (+ n 1))))
+(display (do ((s (ints 0) (stream-cdr s)) (i 0 (+ i 1))) ((= i 1000000) (stream-car s)))) (newline)
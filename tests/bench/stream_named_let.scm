@@ -0,0 +1,3 @@
+; 第 25 节：用命名 let 遍历流的 100 万个元素
+(define (ints n) (cons-stream n (ints (+ n 1))))
+(display (let loop ((s (ints 0)) (i 0)) (if (= i 1000000) (stream-car s) (loop (stream-cdr s) (+ i 1))))) (newline)
@@ -0,0 +1,4 @@
+; 第 25 节：用尾递归的过程遍历流的 100 万个元素
+(define (ints n) (cons-stream n (ints (+ n 1))))
+(define (walk s i) (if (= i 1000000) (stream-car s) (walk (stream-cdr s) (+ i 1))))
+(display (walk (ints 0) 0)) (newline)
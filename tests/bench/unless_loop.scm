@@ -0,0 +1,5 @@
+; 第 16 节：过程体中的宏调用在优化时预先展开。调用 unless 100 万次
+(define-macro unless (c e) (list 'if c #f e))
+(define (inner i acc) (if (= i 0) acc (inner (- i 1) (unless (< i 0) (+ acc 1)))))
+(define (outer j acc) (if (= j 0) acc (outer (- j 1) (inner 1000 acc))))
+(display (outer 1000 0)) (newline)
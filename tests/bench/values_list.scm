@@ -0,0 +1,5 @@
+; 第 24 节：与 values_receive.scm 相同，改为返回表再用 car/cdr 取出
+(define (qr a b) (list (quotient a b) (remainder a b)))
+(define (run n)
+  (do ((i 0 (+ i 1)) (acc 0 (let ((l (qr i 7))) (+ acc (car l) (car (cdr l)))))) ((= i n) acc)))
+(display (run 300000)) (newline)
@@ -0,0 +1,5 @@
+; 第 24 节：30 万次迭代，receive 接收 qr 的两个值
+(define (qr a b) (values (quotient a b) (remainder a b)))
+(define (run n)
+  (do ((i 0 (+ i 1)) (acc 0 (receive (q r) (qr i 7) (+ acc q r)))) ((= i n) acc)))
+(display (run 300000)) (newline)
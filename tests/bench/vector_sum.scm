@@ -0,0 +1,3 @@
+; 第 27 节：对 100 万个元素的向量按下标求和
+(define v (make-vector 1000000 1))
+(display (do ((i 0 (+ i 1)) (acc 0 (+ acc (vector-ref v i)))) ((= i 1000000) acc))) (newline)
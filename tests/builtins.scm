@@ -0,0 +1,35 @@
+; 内建过程描述表：一元、二元专用入口与间接调用（见 extensions.md 第 10 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 直接调用走 fn1/fn2 入口
+(check "car" (car '(1 2)) 1)
+(check "cdr" (cdr '(1 2)) '(2))
+(check "cons" (cons 1 '(2)) '(1 2))
+(check "not" (list (not #f) (not '())) '(#t #f))
+(check "eq" (list (eq? 'a 'a) (eq? '(1) '(1))) '(#t #f))
+(check "equal" (equal? '(1 (2 "x")) '(1 (2 "x"))) #t)
+(check "predicates"
+       (list (pair? '(1)) (null? '()) (list? '(1 2)) (symbol? 'a) (string? "s") (boolean? #f) (procedure? car))
+       '(#t #t #t #t #t #t #t))
+
+; 实参中的求值顺序与嵌套调用
+(define (f x) (* x 10))
+(check "nested" (cons (car (cdr '(1 2))) (f (+ 1 2))) '(2 . 30))
+
+; 通过 apply、map 与变量间接调用时结果相同
+(check "apply" (apply cons '(1 2)) '(1 . 2))
+(check "map" (map car '((1) (2) (3))) '(1 2 3))
+(define first car)
+(check "alias" (first '(a b)) 'a)
+(check "higher order" ((lambda (op) (op 7 3)) -) 4)
+
+; 全局重新定义内建过程名后，调用使用新的定义
+(define (cadr-of x) (car (cdr x)))
+(define (car x) 'shadowed)
+(check "redefined" (car '(1 2)) 'shadowed)
+(check "redefined via caller" (cadr-of '(1 2)) 'shadowed)
+(define car first)
+(check "restored" (car '(1 2)) 1)
@@ -0,0 +1,58 @@
+; call/cc 逃逸续延与 dynamic-wind（见 extensions.md 第 22 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 续延调用后 call/cc 立即以实参返回，未调用时返回过程的值
+(check "escape" (call/cc (lambda (k) (+ 1 (k 42)))) 42)
+(check "normal return" (call/cc (lambda (k) 7)) 7)
+(check "long name" (call-with-current-continuation (lambda (k) (k 'x) 'y)) 'x)
+
+; 从尾调用循环与深层非尾递归中逃逸
+(define (find-first pred l)
+  (call/cc (lambda (return)
+    (let loop ((l l))
+      (if (null? l)
+          #f
+          (begin (if (pred (car l)) (return (car l)) #f)
+                 (loop (cdr l))))))))
+(check "tail loop" (find-first (lambda (x) (> x 3)) '(1 2 5 7)) 5)
+(check "not found" (find-first (lambda (x) (> x 9)) '(1 2)) #f)
+(define (deep n k) (if (= n 0) (k 'bottom) (+ 1 (deep (- n 1) k))))
+(check "deep recursion" (call/cc (lambda (k) (deep 10000 k))) 'bottom)
+
+; 经内建过程（map、apply）调用的过程中逃逸
+(check "through map" (call/cc (lambda (k) (map (lambda (x) (if (= x 2) (k 'esc) x)) '(1 2 3)))) 'esc)
+(check "through apply" (call/cc (lambda (k) (apply k '(5)))) 5)
+
+; 嵌套的 call/cc：内层续延只回到内层
+(check "nested"
+       (call/cc (lambda (outer)
+         (+ 1 (call/cc (lambda (inner) (inner 10))))))
+       11)
+(check "outer from inner"
+       (call/cc (lambda (outer)
+         (+ 1 (call/cc (lambda (inner) (outer 10))))))
+       10)
+
+; dynamic-wind：正常返回与逃逸都执行 after
+(define trace '())
+(define (note x) (set! trace (cons x trace)))
+(check "wind value" (dynamic-wind (lambda () (note 'in)) (lambda () 'body) (lambda () (note 'out))) 'body)
+(check "wind escape"
+       (call/cc (lambda (k)
+         (dynamic-wind (lambda () (note 'in)) (lambda () (k 'escaped)) (lambda () (note 'out)))))
+       'escaped)
+(check "wind trace" trace '(out in out in))
+
+; 被遮蔽或重新定义的 call/cc 按普通过程调用
+(define (shadowed call/cc) (call/cc (lambda (k) (k 1))))
+(check "shadowed" (shadowed (lambda (f) 'local)) 'local)
+(define (use-callcc) (call/cc (lambda (k) (k 'builtin))))
+(check "before redefinition" (use-callcc) 'builtin)
+(define saved-call/cc call/cc)
+(define (call/cc f) 'redefined)
+(check "redefined" (use-callcc) 'redefined)
+(define call/cc saved-call/cc)
+(check "restored" (use-callcc) 'builtin)
@@ -0,0 +1,52 @@
+; 平坦闭包与内部定义的装箱（见 extensions.md 第 14 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define (make-adder n) (lambda (x) (+ x n)))
+(check "adder" (map (make-adder 10) '(1 2 3)) '(11 12 13))
+
+; 多层嵌套：只捕获用到的局部变量，全局变量仍在全局环境中查找
+(define scale 2)
+(define (make-linear a b) (lambda (x) (let ((ax (* a x))) ((lambda () (+ ax b scale))))))
+(check "nested" ((make-linear 3 1) 5) 18)
+(define scale 10)
+(check "global redefined" ((make-linear 3 1) 5) 26)
+
+; 相互递归的内部过程：后定义的过程在闭包创建之后才绑定
+(define (parity n)
+  (define (ev? k) (if (= k 0) #t (od? (- k 1))))
+  (define (od? k) (if (= k 0) #f (ev? (- k 1))))
+  (list (ev? n) (od? n)))
+(check "mutual recursion" (parity 7) '(#f #t))
+
+; 内部定义在闭包创建后重新定义，闭包看到新的值
+(define (redefine-inner)
+  (define v 1)
+  (define get (lambda () v))
+  (define v 2)
+  (get))
+(check "inner redefined" (redefine-inner) 2)
+
+; 局部变量遮蔽全局过程名
+(define (shadow-car car) (lambda (l) (car l)))
+(check "param shadows" ((shadow-car cdr) '(1 2)) '(2))
+(define (let-shadow) (let ((list (lambda (a b) 'mine))) (lambda () (list 1 2))))
+(check "let shadows" ((let-shadow)) 'mine)
+
+; 条件执行的内部 define：未执行时名字仍指向外层绑定
+(define (maybe-car flag) (if flag (define car cdr)) (lambda () (car '(1 2))))
+(check "conditional define taken" ((maybe-car #t)) '(2))
+(check "conditional define not taken" ((maybe-car #f)) 1)
+(define (outer x) (define (inner flag) (if flag (define x 1)) (lambda () x)) (list ((inner #f)) ((inner #t))))
+(check "conditional define over local" (outer 5) '(5 1))
+
+; 闭包不再持有外层环境中用不到的大对象，结果仍然正确
+(define (range n) (if (= n 0) '() (cons n (range (- n 1)))))
+(define (make-getters n) (let ((big (range 500)) (k n)) (lambda () k)))
+(check "many closures" (map (lambda (g) (g)) (map make-getters '(1 2 3))) '(1 2 3))
+
+; 使用 eval 的过程体保留完整的环境链
+(define (with-eval x) (lambda () (eval 'x)))
+(check "eval" ((with-eval 42)) 42)
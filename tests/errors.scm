@@ -0,0 +1,74 @@
+; error、raise 与 guard（见 extensions.md 第 23 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define (message-of thunk)
+  (guard (e ((error-object? e) (error-object-message e))
+            (#t (list 'raised e)))
+    (thunk)))
+
+; (error message irritant ...)
+(check "message" (message-of (lambda () (error "bad thing"))) "bad thing")
+(check "irritants"
+       (guard (e (#t (error-object-irritants e))) (error "bad" 1 'x))
+       '(1 x))
+
+; (error code) 与不带实参的 (error)
+(check "code" (message-of (lambda () (error 3))) "3")
+(check "no arguments" (message-of (lambda () (error))) "error")
+
+; raise 任意值
+(check "raise" (message-of (lambda () (raise 'oops))) '(raised oops))
+(check "no error" (message-of (lambda () 'fine)) 'fine)
+
+; 内建过程与求值器的运行时错误同样可以捕获
+(check "builtin error" (guard (e ((error-object? e) 'caught)) (car 5)) 'caught)
+(check "via callBuiltin" (guard (e ((error-object? e) 'caught)) (vector-ref 1 2)) 'caught)
+(check "undefined variable" (guard (e (#t 'caught)) undefined-variable-in-errors) 'caught)
+
+; 子句按 cond 的规则选择；没有子句匹配时交给外层的 guard
+(check "else" (guard (e ((string? e) 'string) (else (list 'else e))) (raise 1)) '(else 1))
+(check "test value" (guard (e ((and (number? e) (* e 10)))) (raise 2)) 20)
+(check "reraise" (guard (outer (#t (list 'outer outer))) (guard (inner ((string? inner) 'inner)) (raise 'x)))
+       '(outer x))
+(check "body value" (guard (e (#t 'handler)) 1 2 3) 3)
+
+; with-exception-handler 与 raise-continuable
+(check "continuable" (with-exception-handler (lambda (e) (* e 10)) (lambda () (+ 1 (raise-continuable 4)))) 41)
+(check "handler escape"
+       (call/cc (lambda (k) (with-exception-handler (lambda (e) (k (list 'handled e))) (lambda () (raise 'bad)))))
+       '(handled bad))
+(check "handler returns"
+       (guard (e ((error-object? e) (error-object-message e)))
+         (with-exception-handler (lambda (e) 'ignored) (lambda () (raise 'bad))))
+       "handler returned from non-continuable exception:")
+(check "error in handler goes outward"
+       (guard (e (#t (list 'outer e)))
+         (with-exception-handler (lambda (e) (raise 'from-handler)) (lambda () (raise 'first))))
+       '(outer from-handler))
+
+; 从深层的尾调用循环与非尾递归中引发
+(define (count-down n) (if (= n 0) (raise 'bottom) (count-down (- n 1))))
+(check "tail loop" (guard (e (#t e)) (count-down 100000)) 'bottom)
+(define (nest n) (if (= n 0) (raise 'deep) (+ 1 (nest (- n 1)))))
+(check "deep recursion" (guard (e (#t e)) (nest 10000)) 'deep)
+(check "through map" (guard (e (#t e)) (map (lambda (x) (if (= x 2) (raise 'in-map) x)) '(1 2 3))) 'in-map)
+
+; guard 的变量遮蔽外层的同名变量，子句之外不可见
+(define e 'outer-e)
+(check "guard variable" (guard (e (#t e)) (raise 'inner-e)) 'inner-e)
+(check "outer unchanged" e 'outer-e)
+(check "closure over condition" ((guard (c (#t (lambda () c))) (raise 'kept))) 'kept)
+
+; 被遮蔽或重新定义的 error、raise 按普通过程调用
+(define (local-error error) (error "not raised"))
+(check "shadowed error" (local-error (lambda (msg) (list 'local msg))) '(local "not raised"))
+(define (raise-it x) (raise x))
+(check "before redefinition" (guard (e (#t (list 'caught e))) (raise-it 1)) '(caught 1))
+(define saved-raise raise)
+(define (raise x) (list 'not-raised x))
+(check "redefined raise" (guard (e (#t (list 'caught e))) (raise-it 1)) '(not-raised 1))
+(define raise saved-raise)
+(check "restored raise" (guard (e (#t (list 'caught e))) (raise-it 1)) '(caught 1))
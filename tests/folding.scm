@@ -0,0 +1,50 @@
+; 常量折叠与名字的遮蔽、重定义（见 extensions.md 第 11 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define (area r) (* r r (* 2 3)))
+(check "fold" (area 2) 24)
+(define (nested) (if (< 1 2) (+ 1 (* 2 3)) 'no))
+(check "nested" (nested) 7)
+(define (conds x) (cond ((= x (- 2 1)) (string-append "a" "b")) (else (not #t))))
+(check "cond" (list (conds 1) (conds 2)) '("ab" #f))
+
+; 结果为序对的调用不折叠，每次得到新的序对
+(define (fresh) (list 1 2))
+(check "fresh pairs" (eq? (fresh) (fresh)) #f)
+
+; 被形参、let 或内部 define 遮蔽的内建过程名
+(define (param car) (car '(1 2)))
+(check "param" (param cdr) '(2))
+(define (let-shadow) (let ((+ -)) (+ 5 3)))
+(check "let" (let-shadow) 2)
+(define (inner) (define (car l) 'inner) (car '(1 2)))
+(check "inner define" (inner) 'inner)
+(define (in-begin) (begin (define + -)) (+ 5 3))
+(check "define in begin" (in-begin) 2)
+
+; 条件执行的内部 define 同样可能遮蔽外层绑定，不能按内建过程折叠
+(define (fc flag l) (if flag (define car (lambda (l) 'mine))) (car l))
+(check "define in if" (fc #t '(1 2)) 'mine)
+(define (fq flag) (if flag (define car (lambda (l) 'mine))) (car '(1 2)))
+(check "define in if, literal args" (fq #t) 'mine)
+(define (fw flag) (cond (flag (define + -))) (+ 5 3))
+(check "define in cond" (fw #t) 2)
+(define (fa flag) (and flag (define abs (lambda (x) 'own))) (abs -1))
+(check "define in and" (fa #t) 'own)
+
+; 嵌套过程体中的 define 不影响外层
+(define (outer) (define (helper) (define car cdr) 0) (car '(1 2)))
+(check "nested lambda" (outer) 1)
+
+; quote 中的表达式保持原样
+(define (quoted) '(+ 1 2))
+(check "quote" (quoted) '(+ 1 2))
+
+; 重新定义内建过程名后，已创建的过程使用新的定义
+(define (plus) (+ 1 2))
+(check "before redefine" (plus) 3)
+(define (+ a b) (* a b))
+(check "after redefine" (plus) 2)
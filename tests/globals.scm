@@ -0,0 +1,51 @@
+; 全局绑定格与变量引用的改写（见 extensions.md 第 15 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 先引用、后定义与重新定义的全局变量
+(define (get-later) later)
+(define later 1)
+(check "defined later" (get-later) 1)
+(define later 2)
+(check "redefined" (get-later) 2)
+(define (call-helper x) (helper x))
+(define (helper x) (* x 10))
+(check "helper defined later" (call-helper 4) 40)
+(define (helper x) (+ x 10))
+(check "helper redefined" (call-helper 4) 14)
+
+; 内部定义与形参遮蔽全局变量，不改写为全局引用
+(define n 100)
+(define (param-shadow n) (+ n 1))
+(check "param" (param-shadow 1) 2)
+(define (inner-shadow) (define n 5) (+ n 1))
+(check "inner define" (inner-shadow) 6)
+(define (let-shadow) (let ((n 7)) (+ n 1)))
+(check "let" (let-shadow) 8)
+(check "global untouched" n 100)
+
+; if、cond 等子表达式中的内部 define 同样遮蔽全局绑定；未执行时仍使用全局绑定
+(define (fc flag l) (if flag (define car (lambda (l) 'mine))) (car l))
+(check "conditional define taken" (fc #t '(1 2)) 'mine)
+(check "conditional define not taken" (fc #f '(1 2)) 1)
+(define (fn flag) (cond (flag (define n 1))) (+ n 1))
+(check "define in cond" (list (fn #t) (fn #f)) '(2 101))
+(define (fw flag) (if flag (begin (define n 'local) n) n))
+(check "define in begin branch" (list (fw #t) (fw #f)) '(local 100))
+
+; 经局部变量调用的过程可能是 eval，它在调用者的帧中引入的定义遮蔽全局绑定
+(define (f ev) (ev '(define car cdr)) (car '(1 2)))
+(check "eval as value" (f eval) '(2))
+(check "car still global" (car '(1 2)) 1)
+
+; 同一个 lambda 表达式创建的闭包共用优化结果，环境形态不同时各自优化
+(define (make-getter use-local)
+  (if use-local
+      (let ((car cdr)) (lambda (l) (car l)))
+      (lambda (l) (car l))))
+(check "shape local" ((make-getter #t) '(1 2)) '(2))
+(check "shape global" ((make-getter #f) '(1 2)) 1)
+(define (adders n) (if (= n 0) '() (cons (lambda (x) (+ x n)) (adders (- n 1)))))
+(check "shared code" (map (lambda (g) (g 10)) (adders 3)) '(13 12 11))
@@ -0,0 +1,143 @@
+// 宿主 API（src/mini_lisp.h）的测试：检查失败时打印原因，以非零状态退出。
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "mini_lisp.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& name) {
+    if (!ok) {
+        std::cerr << "check failed: " << name << std::endl;
+        ++failures;
+    }
+}
+
+template <typename F>
+bool throws(F&& f) {
+    try {
+        f();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main() {
+    using mini_lisp::Interpreter;
+    using mini_lisp::Object;
+    using mini_lisp::Type;
+
+    Interpreter interp;
+    check(interp.eval("(+ 1 2)").toNumber() == 3, "eval");
+    check(interp.eval("(define x 5) x").toNumber() == 5, "define in source");
+    check(interp.lookup("x").toNumber() == 5, "lookup");
+
+    // 宿主定义的值与源代码互相可见
+    interp.define("y", Object::number(7));
+    check(interp.eval("(* x y)").toNumber() == 35, "define from host");
+    interp.eval("(define (add a b) (+ a b))");
+    check(interp.call("add", {Object::number(1), Object::number(2)}).toNumber() == 3, "call by name");
+    check(interp.call(interp.lookup("add"), {Object::number(4), Object::number(5)}).toNumber() == 9,
+          "call object");
+
+    // 值的构造与访问
+    Object list = Object::list({Object::number(1), Object::string("a"), Object::symbol("b")});
+    check(list.type() == Type::Pair && list.toList().size() == 3, "list");
+    check(list.car().toNumber() == 1, "car");
+    check(list.cdr().car().toStringView() == "a", "string");
+    check(list.repr() == "(1 \"a\" b)", "repr");
+    check(Object::nil().isNil() && !Object::boolean(false).truthy(), "nil and #f");
+    check(Object::number(0).truthy(), "0 is true");
+    check(throws([&] { list.toNumber(); }), "type mismatch");
+    Object vector = interp.eval("(vector 1 \"a\" '(2))");
+    check(vector.type() == Type::Vector && vector.isVector() && !vector.isPair(), "vector type");
+    check(vector.toVector().size() == 3 && vector.toVector()[1].toStringView() == "a", "toVector");
+    check(Object::vector({Object::number(1), Object::symbol("b")}).repr() == "#(1 b)", "vector");
+    check(throws([&] { list.toVector(); }) && throws([&] { vector.toList(); }), "vector mismatch");
+
+    // 预先解析的程序可以在多个实例中重复求值
+    auto program = mini_lisp::Program::parse("(define z 1) (+ z 41)");
+    check(program.size() == 2, "program size");
+    Interpreter other;
+    check(interp.eval(program).toNumber() == 42 && other.eval(program).toNumber() == 42, "program");
+
+    // 各实例拥有自己的全局环境
+    check(throws([&] { other.eval("x"); }), "separate environments");
+
+    // 求值出错与 exit 都以异常报告，不会结束宿主进程
+    check(throws([&] { interp.eval("(car 1)"); }), "error");
+    try {
+        interp.eval("(exit 3)");
+        check(false, "exit");
+    } catch (const mini_lisp::Exit& e) {
+        check(e.code() == 3, "exit code");
+    }
+    check(interp.eval("x").toNumber() == 5, "usable after exit");
+
+    // 类型化内建过程的参数错误指明参数位置；超出 int64 范围的数不是合法的整数参数
+    auto error_message = [&](const std::string& source) -> std::string {
+        try {
+            interp.eval(source);
+        } catch (const std::runtime_error& e) {
+            return e.what();
+        }
+        return "";
+    };
+    check(error_message("(+ 1 \"a\")") == "+: argument 2 must be a number. Got: \"a\"", "argument error");
+    check(error_message("(even? 1.5)").starts_with("even?: argument 1 must be an integer"), "not an integer");
+    check(error_message("(even? 1e300)").starts_with("even?: argument 1 must be an integer"), "int64 range");
+    check(error_message("(odd? 9223372036854775808)").starts_with("odd?: argument 1 must be an integer"),
+          "int64 upper bound");
+    // 实参个数在调用处按描述表检查，经 apply 间接调用时同样检查
+    check(error_message("(car 1 2)") == "car: expects 1 argument. Got: 2", "arity");
+    check(error_message("(apply cons '(1))") == "cons: expects 2 arguments. Got: 1", "arity via apply");
+    // set! 不会创建新的绑定
+    check(error_message("(set! undefined-name 1)") == "set!: variable undefined-name not defined.", "set! undefined");
+
+    // 续延只能在它的 call/cc 返回之前调用
+    check(error_message("(define saved #f) (call/cc (lambda (k) (set! saved k) 1)) (saved 2)")
+              .starts_with("continuation: only escapes"), "continuation reentry");
+    check(error_message("(call/cc (lambda (k) (k 1 2)))") == "continuation: expects 1 argument, got 2.",
+          "continuation arity");
+
+    // 多值的个数与 formals 不符，或用在需要单个值的地方
+    check(error_message("(receive (a b) (values 1 2 3) a)") == "receive: expected 2 values, got 3.", "values count");
+    check(error_message("(+ 1 (values 2 3))").starts_with("+: argument 2 must be a number"), "values as one value");
+
+    // stream-car、stream-cdr 只接受流
+    check(error_message("(stream-cdr 5)") == "stream-cdr: argument must be a stream pair. Got: 5", "stream-cdr");
+
+    // 取完的迭代器与生成器之外的 generator-yield
+    check(error_message("(iterator-next (in-range 0))") == "iterator-next: iterator is exhausted.", "exhausted");
+    check(error_message("(generator-yield 1)") == "generator-yield: not inside a generator.", "yield outside");
+
+    // 向量的长度上限与超出 int64 范围的下标
+    check(error_message("(make-vector 1e12)").starts_with("make-vector: length"), "make-vector limit");
+    check(error_message("(vector-ref (vector 1 2) 1e19)").starts_with("vector-ref: argument 2 must be an integer"),
+          "vector-ref huge index");
+
+    // 深层递归中的错误在原来的栈上报告；栈段总量超过上限时报告错误，解释器仍可继续使用
+    interp.eval("(define (deep n) (if (= n 0) (car '()) (+ 1 (deep (- n 1)))))");
+    check(error_message("(deep 30000)").starts_with("car"), "error on a stack segment");
+    Interpreter::setMaxStackSize(16 << 20);
+    check(error_message("(deep 1000000)").starts_with("Stack overflow"), "stack limit");
+    Interpreter::setMaxStackSize(size_t{1} << 30);
+    check(interp.eval("(+ 1 2)").toNumber() == 3, "usable after stack overflow");
+
+    // 输出重定向
+    std::ostringstream output;
+    interp.setOutput(&output);
+    interp.eval("(display \"hi\") (newline)");
+    interp.setOutput(nullptr);
+    check(output.str() == "hi\n", "output");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+; 小过程的内联与 let/lambda 的展开（见 extensions.md 第 12 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define (square x) (* x x))
+(define (average a b) (/ (+ a b) 2))
+(define (sum-squares a b) (+ (square a) (square b)))
+(check "inline" (sum-squares 3 4) 25)
+(check "non-trivial argument" (square (+ 1 2)) 9)
+(check "nested" (average (square 2) (square 4)) 10)
+
+; 辅助过程定义在调用者之后
+(define (hyp a b) (- (sum-of-squares a b) 1))
+(define (sum-of-squares a b) (+ (* a a) (* b b)))
+(check "defined later" (hyp 3 4) 24)
+
+; 直接调用的 lambda 与单个过程体表达式的 let
+(define (beta n) ((lambda (x y) (+ x y)) n (* n 2)))
+(check "lambda" (beta 5) 15)
+(define (let1 n) (let ((a (+ n 1)) (b 10)) (* a b)))
+(check "let" (let1 2) 30)
+
+; 实参被使用多次或可能不被求值时仍保持正确
+(define (twice x) (+ x x))
+(define (pick flag x) (if flag x 0))
+(check "used twice" (twice (car '(4))) 8)
+(check "conditional use" (list (pick #t (car '(7))) (pick #f (car '(7)))) '(7 0))
+
+; 递归过程不展开
+(define (fact n) (if (= n 0) 1 (* n (fact (- n 1)))))
+(define (fact5) (fact 5))
+(check "recursive" (fact5) 120)
+
+; 过程体的自由变量被调用处的局部变量遮蔽
+(define k 100)
+(define (add-k x) (+ x k))
+(define (caller k) (add-k k))
+(check "free variable shadowed" (caller 1) 101)
+
+; 调用处的形参、let 或内部 define 与被内联的过程同名
+(define (param-shadow square) (square 3))
+(check "param shadows" (param-shadow (lambda (x) 'param)) 'param)
+(define (inner-shadow) (define (square x) 'inner) (square 3))
+(check "define shadows" (inner-shadow) 'inner)
+(define (cond-shadow flag) (if flag (define square (lambda (x) 'cond))) (square 3))
+(check "conditional define shadows" (cond-shadow #t) 'cond)
+
+; 重新定义被内联的过程后，已优化的调用者使用新的定义
+(define (cube x) (* x x x))
+(define (cube-of-2) (cube 2))
+(check "before redefine" (cube-of-2) 8)
+(define (cube x) (+ x 1))
+(check "after redefine" (cube-of-2) 3)
+(define (sum-cubes a b) (+ (cube a) (cube b)))
+(check "new callers" (sum-cubes 1 2) 5)
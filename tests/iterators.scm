@@ -0,0 +1,82 @@
+; 迭代器、in-range、in-lines 与生成器（见 extensions.md 第 26 节）。在 tests/ 目录下运行，检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; in-range 的三种形式
+(check "end" (iterator->list (in-range 4)) '(0 1 2 3))
+(check "start end" (iterator->list (in-range 2 5)) '(2 3 4))
+(check "step" (iterator->list (in-range 10 0 -3)) '(10 7 4 1))
+(check "empty" (iterator->list (in-range 3 3)) '())
+
+; reduce、for-each、map、filter 逐个取出元素
+(check "reduce" (reduce + (in-range 0 100001)) 5000050000)
+(check "reduce lambda" (reduce (lambda (a b) (if (> a b) a b)) (in-range 5)) 4)
+(check "map filter" (iterator->list (map (lambda (x) (* x x)) (filter odd? (in-range 10)))) '(1 9 25 49 81))
+(define seen '())
+(for-each (lambda (x) (set! seen (cons x seen))) (in-range 3))
+(check "for-each" seen '(2 1 0))
+(check "lists unchanged" (map (lambda (x) (+ x 1)) '(1 2)) '(2 3))
+
+; map 是惰性的：只在取元素时调用过程
+(define calls 0)
+(define lazy (map (lambda (x) (set! calls (+ calls 1)) x) (in-range 1000000)))
+(check "not called yet" calls 0)
+(check "iterator-next" (list (iterator-next lazy) (iterator-next lazy)) '(0 1))
+(check "called twice" calls 2)
+(check "iterator-next default" (iterator-next (in-range 0) 'none) 'none)
+
+; in-lines 逐行读取端口
+(define f (open-input-file "iterators.scm"))
+(define first-line (iterator-next (in-lines f)))
+(check "in-lines first" (string? first-line) #t)
+(check "in-lines rest" (> (reduce + (map (lambda (line) 1) (in-lines f))) 40) #t)
+(close-port f)
+
+; 生成器：递归过程逐个产生元素
+(define (tree-leaves t)
+  (make-generator
+    (lambda ()
+      (let walk ((t t))
+        (cond ((pair? t) (walk (car t)) (walk (cdr t)))
+              ((not (null? t)) (generator-yield t)))))))
+(check "generator" (iterator->list (tree-leaves '((1 2) (3 (4 5)) 6))) '(1 2 3 4 5 6))
+(check "generator map" (iterator->list (map (lambda (x) (* 10 x)) (tree-leaves '(1 (2))))) '(10 20))
+(define (deep-gen n)
+  (make-generator (lambda ()
+    (define (d k) (if (= k 0) (begin (generator-yield 'bottom) 0) (+ 1 (d (- k 1)))))
+    (generator-yield (d n)))))
+(check "deep generator" (iterator->list (deep-gen 50000)) '(bottom 50000))
+
+; 生成器中的条件交给取元素一方的处理器；未取完的生成器释放时执行 dynamic-wind 的 after
+(define failing (make-generator (lambda () (generator-yield 1) (raise 'inside))))
+(check "raise from generator" (guard (e (#t (list 'caught e))) (iterator->list failing)) '(caught inside))
+(check "error from generator"
+       (guard (e ((error-object? e) 'caught)) (iterator->list (make-generator (lambda () (car 1)))))
+       'caught)
+(check "escape from consumer"
+       (call/cc (lambda (k) (for-each (lambda (x) (if (= x 3) (k 'found))) (tree-leaves '(1 2 3 4)))))
+       'found)
+(define unwound #f)
+(define abandoned
+  (make-generator (lambda ()
+    (dynamic-wind (lambda () #f)
+                  (lambda () (generator-yield 1) (generator-yield 2))
+                  (lambda () (set! unwound #t))))))
+(check "first of abandoned" (iterator-next abandoned) 1)
+(set! abandoned #f)
+(check "abandoned unwound" unwound #t)
+
+; 被遮蔽或重新定义的 in-range、generator-yield 按普通过程调用
+(define (shadowed in-range) (in-range 3))
+(check "shadowed" (shadowed (lambda (n) (list n))) '(3))
+(define (count-to n) (iterator->list (in-range n)))
+(check "before redefinition" (count-to 2) '(0 1))
+(define saved-in-range in-range)
+(define (in-range n) (saved-in-range n (+ n 2)))
+(check "redefined" (count-to 2) '(2 3))
+(define in-range saved-in-range)
+(check "restored" (count-to 2) '(0 1))
+(define (local-yield generator-yield) (generator-yield 'x))
+(check "shadowed generator-yield" (local-yield list) '(x))
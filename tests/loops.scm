@@ -0,0 +1,43 @@
+; 命名 let 与 do（见 extensions.md 第 19 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(check "named let" (let loop ((i 0) (acc 0)) (if (= i 10) acc (loop (+ i 1) (+ acc i)))) 45)
+(check "do" (do ((i 0 (+ i 1)) (acc '() (cons i acc))) ((= i 3) acc)) '(2 1 0))
+(check "do without step" (do ((i 0 (+ i 1)) (k 7)) ((= i 2) k)) 7)
+(check "do body" (do ((i 0 (+ i 1))) ((= i 3) 'end) (list i)) 'end)
+
+; 尾位置的循环在一个帧中执行，迭代次数不受栈深度限制
+(define (sum-to n) (let loop ((i n) (acc 0)) (if (= i 0) acc (loop (- i 1) (+ acc i)))))
+(check "many iterations" (sum-to 100000) 5000050000)
+(define (count-do n) (do ((i 0 (+ i 1))) ((= i n) i)))
+(check "many do iterations" (count-do 100000) 100000)
+(check "cond tail" (let loop ((i 0)) (cond ((= i 5) 'done) (else (loop (+ i 1))))) 'done)
+
+; 非尾位置的调用与作为值传递的循环名按局部过程执行
+(check "non-tail" (let fact ((n 5)) (if (= n 0) 1 (* n (fact (- n 1))))) 120)
+(check "loop as value" (let loop ((i 0)) (if (= i 0) (map loop '(1 2)) i)) '(1 2))
+
+; 每一轮的闭包看到的是当时的绑定
+(define thunks (do ((i 0 (+ i 1)) (acc '() (cons (lambda () i) acc))) ((= i 3) acc)))
+(check "closures per iteration" (map (lambda (t) (t)) thunks) '(2 1 0))
+(define (collect n) (let loop ((i 0) (acc '())) (if (= i n) acc (loop (+ i 1) (cons (lambda () i) acc)))))
+(check "named let closures" (map (lambda (t) (t)) (collect 3)) '(2 1 0))
+
+; 循环名与循环变量遮蔽同名的全局绑定
+(define (loop x) 'global)
+(define i 'global)
+(check "loop name shadows global" (let loop ((i 3)) (if (= i 0) 'local (loop (- i 1)))) 'local)
+(check "global after loop" (list (loop 1) i) '(global global))
+(define (shadow-car n) (let car ((k n)) (if (= k 0) 'ok (car (- k 1)))))
+(check "loop name shadows builtin" (shadow-car 3) 'ok)
+(check "builtin after loop" (car '(1)) 1)
+
+; 过程体中调用的全局过程被重新定义
+(define (step x) (+ x 1))
+(define (run n) (let loop ((i 0) (acc 0)) (if (= i n) acc (loop (+ i 1) (step acc)))))
+(check "before redefine" (run 3) 3)
+(define (step x) (+ x 10))
+(check "redefined" (run 3) 30)
@@ -0,0 +1,47 @@
+; 过程体中宏调用的预先展开（见 extensions.md 第 16 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define-macro unless (c e) (list 'if c #f e))
+(define (count-down n acc) (if (= n 0) acc (count-down (- n 1) (unless (< n 0) (+ acc 1)))))
+(check "expanded" (count-down 100 0) 100)
+
+; 宏的实参只按语法代入，不提前求值
+(define-macro my-if (c a b) (list 'cond (list c a) (list 'else b)))
+(define (safe-car l) (my-if (null? l) 'empty (car l)))
+(check "lazy arguments" (list (safe-car '()) (safe-car '(1))) '(empty 1))
+
+; 展开结果中的宏继续展开
+(define-macro when1 (c e) (list 'unless (list 'not c) e))
+(define (w x) (when1 (> x 0) 'positive))
+(check "nested expansion" (list (w 1) (w -1)) '(positive #f))
+
+; 重新定义宏后，已优化的过程使用新的展开
+(define (u x) (unless x 'no))
+(check "before redefine" (u #f) 'no)
+(define-macro unless (c e) (list 'if c e #f))
+(check "macro redefined" (u #f) #f)
+(check "macro redefined, true" (u #t) 'no)
+
+; 宏名被重新定义为过程
+(define-macro twice (e) (list 'begin e e))
+(define (t) (twice 5))
+(check "macro" (t) 5)
+(define (twice x) (* x 2))
+(check "macro redefined as procedure" (t) 10)
+
+; 宏体用到的全局变量被重新定义
+(define tag 'old)
+(define-macro tagged (e) (list 'list (list 'quote tag) e))
+(define (tg) (tagged 1))
+(check "global in macro body" (tg) '(old 1))
+(define tag 'new)
+(check "global in macro body redefined" (tg) '(new 1))
+
+; 被局部绑定遮蔽的宏名不展开
+(define (shadow unless) (unless 1 2))
+(check "param shadows macro" (shadow +) 3)
+(define (cond-shadow flag) (if flag (define unless (lambda (a b) 'proc))) (unless #t 'x))
+(check "conditional define shadows macro" (cond-shadow #t) 'proc)
@@ -0,0 +1,25 @@
+; register_native 注册的数值过程（见 extensions.md 第 10 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(check "add" (+ 1 2 3.5) 6.5)
+(check "add none" (+) 0)
+(check "subtract" (- 10 1 2) 7)
+(check "negate" (- 5) -5)
+(check "multiply" (* 2 3 4) 24)
+(check "divide" (/ 1 4) 0.25)
+(check "abs" (abs -3) 3)
+(check "expt" (expt 2 10) 1024)
+(check "quotient" (quotient -7 2) -3)
+(check "modulo" (modulo -7 2) 1)
+(check "remainder" (remainder -7 2) -1)
+(check "compare" (list (< 1 2) (< 2 1) (>= 3 3) (= 2 2.0)) '(#t #f #t #t))
+(check "even" (list (even? 4) (even? -3) (odd? -3) (zero? 0)) '(#t #f #t #t))
+(check "int64 bounds" (list (even? -9223372036854775808) (even? 9007199254740992)) '(#t #t))
+(check "predicates" (list (integer? 2.0) (integer? 2.5) (number? "1")) '(#t #f #f))
+
+; 内建过程可以作为值传递
+(check "apply" (apply + '(1 2 3)) 6)
+(check "map" (map abs '(-1 2 -3)) '(1 2 3))
@@ -0,0 +1,37 @@
+; 端口与事件循环（见 extensions.md 第 5 节）。在 tests/ 目录下运行，检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 管道：任务中读取时挂起，另一端写入后继续；写端关闭后读到 ()
+(define p (make-pipe))
+(define reader (car p))
+(define writer (car (cdr p)))
+(define t (spawn (lambda () (list (read-line-async reader) (read-line-async reader)))))
+(write-async writer "hello\nworld\n")
+(check "pipe lines" (join t) '("hello" "world"))
+(write-async writer "partial")
+(close-port writer)
+(check "pipe last line" (read-line-async reader) "partial")
+(check "pipe eof" (read-line-async reader) '())
+(close-port reader)
+
+; 文件：逐行读取本脚本
+(define f (open-input-file "ports.scm"))
+(check "port?" (port? f) #t)
+(check "file first line" (read-line-async f)
+       "; 端口与事件循环（见 extensions.md 第 5 节）。在 tests/ 目录下运行，检查失败时报错，mini_lisp 以非零状态退出")
+(check "file blank line" (read-line-async f) "")
+(define (count-lines port n)
+  (if (null? (read-line-async port)) n (count-lines port (+ n 1))))
+(check "file rest" (> (count-lines f 0) 20) #t)
+(close-port f)
+
+; 定时器按到期时间运行，run-event-loop 在没有任务剩余时返回
+(define q (make-pipe))
+(define (log line) (write-async (car (cdr q)) line))
+(set-timeout 0.02 (lambda () (log "late\n")))
+(set-timeout 0 (lambda () (log "early\n")))
+(run-event-loop)
+(check "timers" (list (read-line-async (car q)) (read-line-async (car q))) '("early" "late"))
@@ -0,0 +1,66 @@
+; delay、delay-force、make-promise 与流（见 extensions.md 第 25 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 第一次 force 时求值并记住结果
+(define count 0)
+(define p (delay (begin (set! count (+ count 1)) count)))
+(check "promise?" (promise? p) #t)
+(check "not yet forced" count 0)
+(check "force" (force p) 1)
+(check "memoized" (force p) 1)
+(check "evaluated once" count 1)
+(check "force non-promise" (force 5) 5)
+(check "make-promise" (force (make-promise 'v)) 'v)
+(check "promise? non-promise" (promise? '(1)) #f)
+
+; delay 捕获所在的环境
+(define (make-lazy x) (delay (* x 2)))
+(check "captured env" (force (make-lazy 21)) 42)
+
+; 求值中重入的 force 先得到了值时以它为准（R7RS 的例子）
+(define x 5)
+(define reentrant
+  (delay (begin (set! x (+ x 1))
+                (if (> x 10) x (force reentrant)))))
+(check "reentrant" (force reentrant) 11)
+(check "reentrant memoized" (begin (set! x 100) (force reentrant)) 11)
+
+; 长的 delay-force 链只占用常量的栈
+(define (chain n) (delay-force (if (= n 0) (delay 'done) (chain (- n 1)))))
+(check "delay-force chain" (force (chain 100000)) 'done)
+
+; 流：尾递归、do 与命名 let 遍历
+(define (ints n) (cons-stream n (ints (+ n 1))))
+(define (stream-ref s k) (if (= k 0) (stream-car s) (stream-ref (stream-cdr s) (- k 1))))
+(check "stream" (stream-car (stream-cdr (stream-cdr (ints 1)))) 3)
+(check "tail walk" (stream-ref (ints 0) 100000) 100000)
+(check "do walk" (do ((s (ints 0) (stream-cdr s)) (i 0 (+ i 1))) ((= i 100000) (stream-car s))) 100000)
+(check "named let walk"
+       (let loop ((s (ints 0)) (i 0)) (if (= i 100000) (stream-car s) (loop (stream-cdr s) (+ i 1))))
+       100000)
+(define (stream-take s k) (if (= k 0) '() (cons (stream-car s) (stream-take (stream-cdr s) (- k 1)))))
+(define (stream-map2 f s) (cons-stream (f (stream-car s)) (stream-map2 f (stream-cdr s))))
+(check "stream-map" (stream-take (stream-map2 (lambda (n) (* n n)) (ints 1)) 4) '(1 4 9 16))
+
+; 已经走过的长流整体释放时不会递归析构
+(define long (ints 0))
+(stream-ref long 200000)
+(set! long #f)
+(check "released" long #f)
+
+; 被遮蔽或重新定义的 force 按普通过程调用；被遮蔽的变量名不影响 delay 捕获的绑定
+(define (shadowed force) (force (delay 1)))
+(check "shadowed force" (shadowed (lambda (p) 'local)) 'local)
+(define (value-of q) (force q))
+(check "before redefinition" (value-of (delay 'forced)) 'forced)
+(define saved-force force)
+(define (force q) 'redefined)
+(check "redefined force" (value-of (delay 'forced)) 'redefined)
+(define force saved-force)
+(check "restored force" (value-of (delay 'forced)) 'forced)
+(define y 'outer)
+(define q (let ((y 'inner)) (delay y)))
+(check "delay scope" (force q) 'inner)
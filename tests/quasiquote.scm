@@ -0,0 +1,57 @@
+; quasiquote 模板与 unquote-splicing，包括向量模板（见 extensions.md 第 17、27 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define lst '(1 2))
+
+(check "unquote" `(a ,(+ 1 1) b) '(a 2 b))
+(check "splicing" `(a ,@lst b) '(a 1 2 b))
+(check "splicing at end shares" (eq? (cdr `(a ,@lst)) lst) #t)
+(check "splicing empty" `(a ,@'() b) '(a b))
+(check "dotted" `(a . ,(+ 1 2)) '(a . 3))
+(check "nested" `(a `(b ,(c ,(+ 1 1)))) '(a (quasiquote (b (unquote (c 2))))))
+(check "constant" `(a (b c)) '(a (b c)))
+
+; 过程体中的模板由优化器编译；常量部分每次求值都是同一个对象
+(define (wrap x) `(start (fixed part) ,x ,@(list x x)))
+(check "compiled" (wrap 7) '(start (fixed part) 7 7 7))
+(check "constant shared" (eq? (car (cdr (wrap 1))) (car (cdr (wrap 2)))) #t)
+(define (make-thunk x) (lambda () `(a (,x))))
+(check "captured" ((make-thunk 5)) '(a (5)))
+
+; 向量模板
+(check "vector unquote" `#(1 ,(+ 1 1)) #(1 2))
+(check "vector splicing" `#(a ,@lst b) #(a 1 2 b))
+(check "vector in list" `(x #(,(* 2 3))) '(x #(6)))
+(check "nested vector" `#(1 `#(,(+ 1 ,(+ 1 1)))) '#(1 (quasiquote #((unquote (+ 1 2))))))
+(check "constant vector" `#(1 (a b)) #(1 (a b)))
+
+; 过程体中的向量模板同样由优化器编译；闭包须捕获向量模板中引用的变量
+(define (spread x) `#(,x ,@(list x x) #(,x)))
+(check "compiled vector" (spread 7) #(7 7 7 #(7)))
+(define (make-vector-thunk x) (lambda () `(a #(,x))))
+(check "captured in vector" ((make-vector-thunk 5)) '(a #(5)))
+
+; 编译后的模板直接调用内建的 cons/append，不受同名全局变量重新定义的影响
+(define (pair-up x) `(,x ,@lst))
+(define (cons a b) 'user-cons)
+(define (append a b) 'user-append)
+(check "builtin cons" (pair-up 0) '(0 1 2))
+(check "builtin cons, global template" `(,0 ,@lst) '(0 1 2))
+(define (list->vector l) 'user-list->vector)
+(check "builtin list->vector" (spread 1) #(1 1 1 #(1)))
+(check "builtin list->vector, global template" `#(,0 ,@lst) #(0 1 2))
+
+; 局部绑定遮蔽模板中引用的名字
+(define (shadow lst) `(x ,@lst))
+(check "param shadows global" (shadow '(9)) '(x 9))
+(define (cond-shadow flag) (if flag (define lst '(local))) `(,@lst))
+(check "conditional define shadows" (list (cond-shadow #t) (cond-shadow #f)) '((local) (1 2)))
+
+; 宏体中的模板在重新定义后重新编译
+(define-macro swap (a b) `(list ,b ,a))
+(check "macro template" (swap 1 2) '(2 1))
+(define-macro swap (a b) `(list ,a ,b))
+(check "macro redefined" (swap 1 2) '(1 2))
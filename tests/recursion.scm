@@ -0,0 +1,31 @@
+; 深层递归与分段栈（见 extensions.md 第 21 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define (build n) (let loop ((i n) (acc '())) (if (= i 0) acc (loop (- i 1) (cons i acc)))))
+(define big (build 30000))
+
+; 非尾递归超出原生栈，在新的栈段上继续
+(define (sum l) (if (null? l) 0 (+ (car l) (sum (cdr l)))))
+(check "non-tail sum" (sum big) 450015000)
+(define (copy l) (if (null? l) '() (cons (car l) (copy (cdr l)))))
+(check "non-tail copy" (length (copy big)) 30000)
+(check "cond and let" (let count ((l big)) (cond ((null? l) 0) (else (let ((n (count (cdr l)))) (+ n 1))))) 30000)
+
+; 过程体尾位置上的调用不增加栈深度
+(define (sum-tail l acc) (if (null? l) acc (sum-tail (cdr l) (+ (car l) acc))))
+(check "tail call" (sum-tail big 0) 450015000)
+(define (even-length? l) (if (null? l) #t (odd-length? (cdr l))))
+(define (odd-length? l) (if (null? l) #f (even-length? (cdr l))))
+(check "mutual tail calls" (even-length? big) #t)
+
+; 递归中重新定义、遮蔽被调用的过程
+(define (depth l) (if (null? l) 0 (+ 1 (depth (cdr l)))))
+(check "depth" (depth big) 30000)
+(define (shadow depth l) (depth l))
+(check "param shadows recursive procedure" (shadow length big) 30000)
+(define old-depth depth)
+(define (depth l) 0)
+(check "redefined inside recursion" (old-depth big) 1)
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""--serve 模式的请求帧、输出捕获与连接处理（见 extensions.md 第 6 节）。
+
+用法：serve.py MINI_LISP。检查失败时抛出 AssertionError，以非零状态退出。
+"""
+import os
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def recv_exact(conn, size):
+    data = b""
+    while len(data) < size:
+        chunk = conn.recv(size - len(data))
+        if not chunk:
+            raise EOFError("server closed the connection")
+        data += chunk
+    return data
+
+
+def frame(source):
+    return struct.pack(">I", len(source)) + source
+
+
+def response(conn):
+    status = recv_exact(conn, 1)[0]
+    output = recv_exact(conn, struct.unpack(">I", recv_exact(conn, 4))[0])
+    value = recv_exact(conn, struct.unpack(">I", recv_exact(conn, 4))[0])
+    return status, output, value
+
+
+def request(conn, source):
+    conn.sendall(frame(source))
+    return response(conn)
+
+
+def connect(path):
+    conn = socket.socket(socket.AF_UNIX)
+    conn.settimeout(10)
+    conn.connect(path)
+    return conn
+
+
+def main():
+    binary = sys.argv[1]
+    path = os.path.join(tempfile.mkdtemp(), "serve.sock")
+    server = subprocess.Popen([binary, "--serve", path])
+    try:
+        for _ in range(500):
+            try:
+                conn = connect(path)
+                break
+            except (FileNotFoundError, ConnectionRefusedError):
+                time.sleep(0.01)
+
+        # 输出与最后一个表达式的值分别返回
+        assert request(conn, b"(display 1) (+ 1 2)") == (0, b"1", b"3")
+        status, output, _ = request(conn, b"(display 'before) (car 1)")
+        assert status == 1 and output == b"before"
+
+        # 各请求在自己的环境中求值，定义不会留到下一个请求
+        assert request(conn, b"(define x 10) x") == (0, b"", b"10")
+        assert request(conn, b"x")[0] == 1
+        # 请求中的定义按顶层定义对待：可以先引用后定义，也可以重新定义
+        assert request(conn, b"(define (mk) (lambda () (h))) (define (h) 1) ((mk))") == (0, b"", b"1")
+        assert request(conn, b"(define (f) (lambda () (g))) (define (g) 1) (define c (f)) (define (g) 2) (c)") == (0, b"", b"2")
+
+        # exit 只结束当前请求，在任务中调用时也是如此
+        assert request(conn, b"(display 'a) (exit 2) (display 'b)") == (1, b"a", b"exit 2")
+        assert request(conn, b"(exit)") == (0, b"", b"exit 0")
+        assert request(conn, b"(join (spawn (lambda () (exit 5)))) (display 'after)") == (1, b"", b"exit 5")
+
+        # 请求结束时取消它留下的任务、定时器与 I/O 等待，它们不会在之后的请求中运行
+        assert request(conn, b"(join (spawn (lambda () (display 'in) 1)))") == (0, b"in", b"1")
+        assert request(conn, b"(spawn (lambda () (display 'task)))")[:2] == (0, b"")
+        assert request(conn, b"(yield)") == (0, b"", b"()")
+        assert request(conn, b"(spawn (lambda () (display 'a) (yield) (display 'b))) (yield)")[:2] == (0, b"a")
+        assert request(conn, b"(set-timeout 0 (lambda () (display 'timer))) 1") == (0, b"", b"1")
+        assert request(conn, b"(define p (make-pipe)) (spawn (lambda () (read-line-async (car p)))) (yield)")[0] == 0
+        assert request(conn, b"(sleep 0.01) (yield)") == (0, b"", b"()")
+
+        # 一次发送的多个请求依次处理
+        conn.sendall(frame(b"1") + frame(b"2") + frame(b"3"))
+        assert [response(conn)[2] for _ in range(3)] == [b"1", b"2", b"3"]
+
+        # 只发出一半请求的连接不影响其他连接
+        stalled = connect(path)
+        stalled.sendall(frame(b"(+ 40 2)")[:6])
+        other = connect(path)
+        assert request(other, b"(* 6 7)") == (0, b"", b"42")
+        stalled.sendall(frame(b"(+ 40 2)")[6:])
+        assert response(stalled) == (0, b"", b"42")
+
+        # 逐字节到达的请求
+        for byte in frame(b"(list 1 2)"):
+            stalled.send(bytes([byte]))
+        assert response(stalled) == (0, b"", b"(1 2)")
+
+        # 对方关闭写端后，仍处理已收到的请求并返回响应
+        stalled.sendall(frame(b"'done"))
+        stalled.shutdown(socket.SHUT_WR)
+        assert response(stalled) == (0, b"", b"done")
+        assert stalled.recv(1) == b""
+
+        # 非法的帧（长度超过上限）只关闭这个连接
+        other.sendall(b"\xff\xff\xff\xff")
+        assert other.recv(1) == b""
+        assert request(conn, b"'alive") == (0, b"", b"alive")
+    finally:
+        server.kill()
+        server.wait()
+
+
+if __name__ == "__main__":
+    main()
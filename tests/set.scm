@@ -0,0 +1,83 @@
+; set! 与赋值转换（见 extensions.md 第 20 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 闭包与外层共享被修改的变量
+(define (make-counter)
+  (let ((n 0))
+    (lambda () (set! n (+ n 1)) n)))
+(define c1 (make-counter))
+(define c2 (make-counter))
+(c1)
+(check "counter" (list (c1) (c2)) '(2 1))
+
+; 被修改的形参与内部定义
+(define (param-box x)
+  (define get (lambda () x))
+  (set! x (* x 10))
+  (get))
+(check "param assigned after capture" (param-box 2) 20)
+(define (inner-define)
+  (define v 1)
+  (define (bump!) (set! v (+ v 1)))
+  (bump!) (bump!)
+  v)
+(check "internal define" (inner-define) 3)
+
+; 不被修改的变量由闭包复制值；被修改的变量读取时不能移动到 set! 之前
+(define (order)
+  (let ((a 1))
+    (let ((before a))
+      (set! a 2)
+      (list before a))))
+(check "read order" (order) '(1 2))
+(define (inline-target x) (+ x 1))
+(define (moved y)
+  (let ((r (inline-target y)))
+    (set! y 100)
+    r))
+(check "inlined read stays" (moved 1) 2)
+
+; 循环中修改的变量与每一轮的闭包
+(define (loop-set n)
+  (let ((sum 0))
+    (do ((i 0 (+ i 1))) ((= i n) sum)
+      (set! sum (+ sum i)))))
+(check "do set!" (loop-set 5) 10)
+(define (shared-box)
+  (let loop ((i 0) (thunks '()))
+    (if (= i 2)
+        (map (lambda (t) (t)) thunks)
+        (let ((v i))
+          (loop (+ i 1) (cons (lambda () (set! v (+ v 10)) v) thunks))))))
+(check "box per iteration" (shared-box) '(11 10))
+
+; 全局变量：修改全局绑定，未定义时报错
+(define total 0)
+(define (add! x) (set! total (+ total x)))
+(add! 3) (add! 4)
+(check "global" total 7)
+
+; 修改被内联的全局过程与内建过程的名字后，优化结果失效
+(define (twice x) (* 2 x))
+(define (use-twice) (twice 5))
+(check "before set!" (use-twice) 10)
+(set! twice (lambda (x) (* 3 x)))
+(check "procedure set!" (use-twice) 15)
+(define (use-abs) (abs -4))
+(check "builtin before set!" (use-abs) 4)
+(set! abs (lambda (x) 'changed))
+(check "builtin set!" (use-abs) 'changed)
+
+; 局部绑定遮蔽全局变量时修改的是局部绑定
+(define g 'global)
+(define (shadow-set g) (set! g 'local) g)
+(check "param shadows global" (list (shadow-set 1) g) '(local global))
+(define (cond-define-set flag)
+  (if flag (define g 'inner))
+  (set! g 'assigned)
+  g)
+(check "conditional define assigned" (list (cond-define-set #t) g) '(assigned global))
+(check "conditional define skipped" (list (cond-define-set #f) g) '(assigned assigned))
@@ -0,0 +1,81 @@
+; define-syntax 与 syntax-rules 的规则选择与匹配（见 extensions.md 第 18 节）。
+; 检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 按实参个数选择规则
+(define-syntax my-or
+  (syntax-rules ()
+    ((_) #f)
+    ((_ e) e)
+    ((_ e r ...) (let ((t e)) (if t t (my-or r ...))))))
+(check "my-or 0" (my-or) #f)
+(check "my-or 1" (my-or 3) 3)
+(check "my-or n" (my-or #f #f 7) 7)
+(define t 5)
+(check "my-or hygiene" (my-or #f t) 5)
+
+; 省略号之后的固定元素与点对尾部
+(define-syntax last-of
+  (syntax-rules ()
+    ((_ a ... z) 'z)))
+(check "suffix" (last-of 1 2 3) 3)
+(check "suffix only" (last-of 1) 1)
+(define-syntax head-tail
+  (syntax-rules ()
+    ((_ a . b) '(a b))))
+(check "dotted tail" (head-tail 1 2 3) '(1 (2 3)))
+(check "dotted tail empty" (head-tail 1) '(1 ()))
+
+; 只有尾部的模式 (_ . r) 接受任意个数的实参
+(define-syntax rest-only
+  (syntax-rules ()
+    ((_ . r) 'r)))
+(check "rest-only 0" (rest-only) '())
+(check "rest-only 1" (rest-only 1) '(1))
+(check "rest-only 3" (rest-only 1 2 3) '(1 2 3))
+(define-syntax ignore-all
+  (syntax-rules ()
+    ((_ . _) 'ignored)))
+(check "wildcard rest" (ignore-all 1 2) 'ignored)
+(check "wildcard rest 0" (ignore-all) 'ignored)
+
+; 定长规则在前，只有尾部的规则兜底
+(define-syntax arity
+  (syntax-rules ()
+    ((_ a) 'one)
+    ((_ . r) 'other)))
+(check "fixed first" (arity 1) 'one)
+(check "fallback 0" (arity) 'other)
+(check "fallback 2" (arity 1 2) 'other)
+
+; 字面量
+(define-syntax arrow
+  (syntax-rules (=>)
+    ((_ a => b) (list a b))
+    ((_ a b c) 'no-arrow)))
+(check "literal" (arrow 1 => 2) '(1 2))
+(check "literal mismatch" (arrow 1 2 3) 'no-arrow)
+
+; 过程体中的调用在优化时展开；重新定义宏后使用新的规则
+(define-syntax kind
+  (syntax-rules ()
+    ((_ x) 'old)))
+(define (kind-of v) (kind v))
+(check "expanded in body" (kind-of 1) 'old)
+(define-syntax kind
+  (syntax-rules ()
+    ((_ x) 'new)))
+(check "macro redefined" (kind-of 1) 'new)
+(define (kind x) 'procedure)
+(check "macro redefined as procedure" (kind-of 1) 'procedure)
+
+; 被局部绑定遮蔽的宏名不展开
+(define (param-shadow my-or) (my-or 1 2))
+(check "param shadows macro" (param-shadow +) 3)
+(define (define-shadow flag)
+  (if flag (define last-of (lambda (a b) 'proc)))
+  (last-of 1 2))
+(check "conditional define shadows macro" (list (define-shadow #t) (define-shadow #f)) '(proc 2))
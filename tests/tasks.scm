@@ -0,0 +1,34 @@
+; spawn、yield、sleep 与 join（见 extensions.md 第 4 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define t (spawn (lambda () (sleep 0.01) (yield) 42)))
+(check "task?" (task? t) #t)
+(check "not a task" (task? 42) #f)
+(check "join" (join t) 42)
+(check "join finished" (join t) 42)
+
+; 主流程中没有任务时 yield 直接返回
+(yield)
+
+; 任务中创建并等待其他任务
+(define (square-task n) (spawn (lambda () (yield) (* n n))))
+(define (sum-squares n)
+  (if (= n 0) 0 (+ (join (square-task n)) (sum-squares (- n 1)))))
+(check "nested" (join (spawn (lambda () (sum-squares 10)))) 385)
+
+; 先睡醒的任务先结束，等待它的任务随后继续
+(define slow (spawn (lambda () (sleep 0.03) 'slow)))
+(define fast (spawn (lambda () (sleep 0.01) (list 'fast (join slow)))))
+(check "sleep order" (join fast) '(fast slow))
+
+; 大量挂起的任务
+(define (range n) (if (= n 0) '() (cons n (range (- n 1)))))
+(define tasks (map (lambda (n) (spawn (lambda () (yield) (sleep 0) n))) (range 1000)))
+(check "many tasks" (reduce + (map join tasks)) 500500)
+
+; 任务栈上的递归
+(define (depth n) (if (= n 0) 0 (+ 1 (depth (- n 1)))))
+(check "recursion in task" (join (spawn (lambda () (depth 2000)))) 2000)
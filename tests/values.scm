@@ -0,0 +1,59 @@
+; values、call-with-values、let-values 与 receive（见 extensions.md 第 24 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+(define (qr a b) (values (quotient a b) (remainder a b)))
+
+(check "receive" (receive (q r) (qr 17 5) (list q r)) '(3 2))
+(check "receive rest" (receive all (values 1 2 3) all) '(1 2 3))
+(check "call-with-values" (call-with-values (lambda () (qr 17 5)) +) 5)
+(check "call-with-values list" (call-with-values (lambda () (values 1 2 3 4 5 6)) list) '(1 2 3 4 5 6))
+(check "single value" (+ 1 (values 2)) 3)
+(check "zero values" (call-with-values (lambda () (values)) list) '())
+(check "let-values"
+       (let-values (((q r) (qr 20 6)) (rest (values 1 2))) (list q r rest))
+       '(3 2 (1 2)))
+(check "let*-values"
+       (let*-values (((a b) (values 1 2)) ((c) (values (+ a b)))) (list a b c))
+       '(1 2 3))
+
+; let-values 的初始化表达式在外层求值，let*-values 依次可见
+(define a 'outer)
+(check "let-values scope" (let-values (((a) (values 1)) ((b) (values a))) b) 'outer)
+(check "let*-values scope" (let*-values (((a) (values 1)) ((b) (values a))) b) 1)
+(check "outer unchanged" a 'outer)
+
+; 池中的多值对象在仍被引用时不会被改写
+(define saved (values 1 2))
+(define other (values 3 4))
+(check "saved" (call-with-values (lambda () saved) list) '(1 2))
+(check "other" (call-with-values (lambda () other) list) '(3 4))
+
+; 在递归中接收多值
+(define (sum-remainders n acc)
+  (if (= n 0)
+      acc
+      (receive (q r) (qr n 3) (sum-remainders (- n 1) (+ acc r)))))
+(check "loop" (sum-remainders 100000 0) 100000)
+
+; 体内的内部定义与被闭包捕获后修改的变量
+(check "internal define" (receive (x y) (values 1 2) (define z (+ x y)) (* z 2)) 6)
+(define (make-counter)
+  (receive (n step) (values 0 1)
+    (lambda () (set! n (+ n step)) n)))
+(define counter (make-counter))
+(counter)
+(check "assigned capture" (counter) 2)
+
+; 被遮蔽或重新定义的 values 按普通过程调用
+(define (shadowed values) (receive all (values 1 2) all))
+(check "shadowed" (shadowed (lambda (a b) (list b a))) '((2 1)))
+(define (two) (values 1 2))
+(check "before redefinition" (call-with-values two list) '(1 2))
+(define saved-values values)
+(define (values a b) (saved-values b a))
+(check "redefined" (call-with-values two list) '(2 1))
+(define values saved-values)
+(check "restored" (call-with-values two list) '(1 2))
@@ -0,0 +1,62 @@
+; 向量（见 extensions.md 第 27 节）。检查失败时报错，mini_lisp 以非零状态退出
+
+(define (check name actual expected)
+  (if (not (equal? actual expected))
+      (error "check failed:" name actual expected)))
+
+; 构造与访问
+(define v (make-vector 3 0))
+(vector-set! v 1 'x)
+(check "make-vector" v #(0 x 0))
+(check "default fill" (make-vector 2) #(0 0))
+(check "empty" (make-vector 0) #())
+(check "vector" (vector 1 "a" 'b) #(1 "a" b))
+(check "vector?" (list (vector? #(1)) (vector? '(1)) (vector? "a")) '(#t #f #f))
+(check "vector-length" (vector-length #(1 2 3)) 3)
+(check "vector-ref" (vector-ref #(1 2 3) 2) 3)
+(check "literal self-evaluates" #(1 (+ 1 2)) (vector 1 '(+ 1 2)))
+(check "nested" (vector-ref (vector-ref #(#(a b) c) 0) 1) 'b)
+(define f (make-vector 3 'a))
+(vector-fill! f 'z)
+(check "vector-fill!" f #(z z z))
+(check "equal?" (list (equal? #(1 (2)) (vector 1 (list 2))) (equal? #(1) #(1 2)) (eq? #(1) #(1))) '(#t #f #f))
+
+; 与表的转换
+(check "list->vector" (list->vector '(a b)) #(a b))
+(check "vector->list" (vector->list #(1 2 3)) '(1 2 3))
+(check "round trip" (vector->list (list->vector '())) '())
+
+; vector-map 与 vector-for-each：一个或多个向量，到最短的向量为止
+(check "vector-map" (vector-map (lambda (x) (* x x)) (vector 1 2 3)) #(1 4 9))
+(check "vector-map many" (vector-map + #(1 2 3) #(10 20) #(100 200 300)) #(111 222))
+(define seen '())
+(vector-for-each (lambda (x) (set! seen (cons x seen))) #(a b c))
+(check "vector-for-each" seen '(c b a))
+(define pairs '())
+(vector-for-each (lambda (a b) (set! pairs (cons (list a b) pairs))) #(1 2 3) #(x y))
+(check "vector-for-each many" pairs '((2 y) (1 x)))
+(check "vector-map escape" (call/cc (lambda (k) (vector-map (lambda (x) (if (= x 2) (k 'esc) x)) #(1 2 3)))) 'esc)
+
+; 过程中修改原向量：按下标重新读取
+(define m (vector 1 2 3))
+(check "mutating map" (vector-map (lambda (x) (vector-set! m 2 10) x) m) #(1 2 10))
+
+; 下标检查与长度上限
+(check "index range" (guard (e ((error-object? e) 'caught)) (vector-ref #(1 2) 2)) 'caught)
+(check "huge index" (guard (e ((error-object? e) 'caught)) (vector-ref (vector 1 2) 1e19)) 'caught)
+(check "huge length" (guard (e ((error-object? e) 'caught)) (make-vector 1e12)) 'caught)
+
+; 按下标遍历的循环
+(define big (make-vector 10000 1))
+(check "sum" (do ((i 0 (+ i 1)) (acc 0 (+ acc (vector-ref big i)))) ((= i 10000) acc)) 10000)
+
+; 被遮蔽或重新定义的向量过程按普通过程调用
+(define (shadowed vector-ref) (vector-ref #(1 2) 0))
+(check "shadowed" (shadowed (lambda (v i) 'local)) 'local)
+(define (first-of v) (vector-ref v 0))
+(check "before redefinition" (first-of #(a b)) 'a)
+(define saved-vector-ref vector-ref)
+(define (vector-ref v i) 'redefined)
+(check "redefined" (first-of #(a b)) 'redefined)
+(define vector-ref saved-vector-ref)
+(check "restored" (first-of #(a b)) 'a)
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""--workers 模式的任务分派、结果顺序与出错处理（见 extensions.md 第 7 节）。
+
+用法：workers.py MINI_LISP。检查失败时抛出 AssertionError，以非零状态退出。
+"""
+import os
+import select
+import subprocess
+import sys
+import tempfile
+
+
+def run(binary, workers, jobs):
+    return subprocess.run([binary, "--workers", str(workers)], input="".join(line + "\n" for line in jobs),
+                          capture_output=True, text=True, timeout=60)
+
+
+def main():
+    binary = sys.argv[1]
+
+    # 结果按任务顺序输出
+    jobs = ["(display %d) (newline)" % i for i in range(200)]
+    result = run(binary, 3, jobs)
+    assert result.returncode == 0, result.stderr
+    assert result.stdout == "".join("%d\n" % i for i in range(200)), result.stdout
+
+    # 已存在的文件路径按脚本执行
+    with tempfile.NamedTemporaryFile("w", suffix=".scm", delete=False) as script:
+        script.write("(define (sq x) (* x x))\n(display (sq 12))\n")
+    try:
+        assert run(binary, 1, [script.name, "(display 'next)"]).stdout == "144next"
+    finally:
+        os.unlink(script.name)
+
+    # 出错的任务在标准错误上报告，退出码为 1，之后的任务照常运行
+    result = run(binary, 2, ["(display 'a)", "(car 1)", "(display 'b)"])
+    assert result.returncode == 1
+    assert result.stdout == "ab", result.stdout
+    assert "car" in result.stderr, result.stderr
+
+    # exit 只影响当前任务
+    result = run(binary, 1, ["(display 'a)", "(exit 3)", "(display 'b)"])
+    assert result.returncode == 1 and result.stdout == "ab", result.stdout
+
+    # 各任务在自己的环境中求值；任务留下的协程不会在同一工作进程的下一个任务中运行
+    result = run(binary, 1, ["(define x 1)", "(display x)"])
+    assert result.returncode == 1 and result.stdout == ""
+    result = run(binary, 1, ["(define (mk) (lambda () (h))) (define (h) 'late) (display ((mk)))"])
+    assert result.returncode == 0 and result.stdout == "late", result.stdout
+    result = run(binary, 1, ["(spawn (lambda () (display 'task)))", "(yield)", "(display 'done)"])
+    assert result.returncode == 0 and result.stdout == "done", result.stdout
+
+    # 边读标准输入边分派：前一个任务的结果在下一行送入之前就已输出
+    pool = subprocess.Popen([binary, "--workers", "1"], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+    try:
+        for i in range(3):
+            pool.stdin.write(b"(display %d) (newline)\n" % i)
+            pool.stdin.flush()
+            ready, _, _ = select.select([pool.stdout], [], [], 10)
+            assert ready, "no result before the next job was sent"
+            assert pool.stdout.readline() == b"%d\n" % i
+        pool.stdin.close()
+        assert pool.wait(timeout=10) == 0
+    finally:
+        pool.kill()
+
+
+if __name__ == "__main__":
+    main()